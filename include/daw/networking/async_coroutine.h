@@ -0,0 +1,94 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+/***
+ * C++20 coroutine support for async_result, included by async_result.h when
+ * the compiler has coroutines.  co_await on an async_result suspends the
+ * coroutine until the result completes and resumes it on the completing
+ * thread, for socket operations the socket's executor.  A function returning
+ * async_result<T> can be a coroutine, it runs eagerly until its first
+ * suspension and the returned result completes on co_return
+ */
+
+#include "async_result.h"
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace daw {
+	namespace details {
+		template<typename T>
+		struct async_awaiter {
+			async_result<T> result;
+
+			bool await_ready( ) const {
+				return result.try_wait( );
+			}
+
+			bool await_suspend( std::coroutine_handle<> handle ) {
+				return result.state( ).try_set_continuation(
+				  [handle]( async_result_state<T> & ) { handle.resume( ); } );
+			}
+
+			T await_resume( ) {
+				if constexpr( std::is_void_v<T> ) {
+					result.get( );
+				} else {
+					return std::move( result.get( ) );
+				}
+			}
+		};
+
+		template<typename T>
+		struct async_promise_base {
+			async_state_ptr<T> state = async_result_state<T>::make( );
+
+			async_result<T> get_return_object( ) {
+				return async_result<T>( state );
+			}
+
+			std::suspend_never initial_suspend( ) noexcept {
+				return { };
+			}
+
+			std::suspend_never final_suspend( ) noexcept {
+				return { };
+			}
+
+			void unhandled_exception( ) {
+				state->set_exception( std::current_exception( ) );
+			}
+		};
+
+		template<typename T>
+		struct async_promise : async_promise_base<T> {
+			template<typename U>
+			void return_value( U &&value ) {
+				this->state->set_value( std::forward<U>( value ) );
+			}
+		};
+
+		template<>
+		struct async_promise<void> : async_promise_base<void> {
+			void return_void( ) {
+				state->set_value( );
+			}
+		};
+	} // namespace details
+
+	template<typename T>
+	details::async_awaiter<T> operator co_await( async_result<T> result ) {
+		return { std::move( result ) };
+	}
+} // namespace daw
+
+template<typename T, typename... Args>
+struct std::coroutine_traits<daw::async_result<T>, Args...> {
+	using promise_type = daw::details::async_promise<T>;
+};
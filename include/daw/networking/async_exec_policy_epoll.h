@@ -0,0 +1,168 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "details/io_strand.h"
+#include "io_request.h"
+#include "reactor_group.h"
+#include "third_party/jthread.hpp"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <sys/epoll.h>
+#include <utility>
+#include <vector>
+
+namespace daw {
+	namespace details {
+		/***
+		 * Try the strand's request and park it in the epoll set when the fd is not
+		 * ready, timing it when the request has a deadline.  The two lanes of a
+		 * duplex_strand share one registration of the fd.  Shared by the
+		 * schedulers that wait with epoll
+		 */
+		std::optional<::ssize_t> epoll_start( int epoll_fd, io_strand &strand,
+		                                      strand_timers &timers );
+
+		/// Remove a parked strand from the epoll set and stop timing it
+		bool epoll_cancel( int epoll_fd, io_strand &strand,
+		                   strand_timers &timers );
+
+		/***
+		 * Take the strands parked on wait that events can continue, re-arming
+		 * the registration for the one left waiting
+		 */
+		std::array<io_strand *, 2> epoll_woken( int epoll_fd, shared_fd_wait &wait,
+		                                        std::uint32_t events );
+
+		/// Remove a parked strand from its shared registration
+		void epoll_remove( int epoll_fd, io_strand &strand );
+
+		/***
+		 * Unpark the strands an epoll event woke and pass each to on_ready
+		 */
+		template<typename OnReady>
+		void epoll_dispatch( int epoll_fd, ::epoll_event const &event,
+		                     strand_timers &timers, OnReady &&on_ready ) {
+			auto &wait = *static_cast<shared_fd_wait *>( event.data.ptr );
+			for( auto *strand : epoll_woken( epoll_fd, wait, event.events ) ) {
+				if( strand == nullptr ) {
+					continue;
+				}
+				if( auto self = strand->unpark( ) ) {
+					(void)timers.release( *strand );
+					on_ready( std::move( self ) );
+				}
+			}
+		}
+
+		/***
+		 * Unpark the strands whose timer expired, failing their requests with
+		 * expired_result, and pass each to on_ready
+		 */
+		template<typename OnReady>
+		void epoll_expire( int epoll_fd, strand_timers &timers,
+		                   std::vector<io_strand *> &expired, OnReady &&on_ready ) {
+			timers.expire( expired );
+			for( auto *strand : expired ) {
+				if( auto self = strand->unpark( ) ) {
+					epoll_remove( epoll_fd, *strand );
+					(void)timers.release( *strand );
+					strand->complete( expired_result( strand->request( ) ) );
+					on_ready( std::move( self ) );
+				}
+			}
+			expired.clear( );
+		}
+	} // namespace details
+
+	/***
+	 * A single thread driving any number of strands through one epoll set
+	 */
+	class epoll_reactor : public details::io_scheduler {
+		int m_epoll = -1;
+		int m_wake = -1;
+		details::strand_queue m_posted{ };
+		details::strand_timers m_timers{ };
+		std::chrono::microseconds m_busy_poll;
+		// Set while the reactor polls without blocking, posts need no wake then
+		std::atomic<bool> m_polling = false;
+		std::jthread m_thread;
+
+		void run( std::stop_token const &should_stop );
+		void wake( );
+
+	public:
+		/***
+		 * With a busy_poll the reactor keeps polling without blocking for that
+		 * long after its last event, trading a core for skipping the wakeup of
+		 * a sleeping thread.  Meant for a group that only latency critical
+		 * sockets use
+		 */
+		explicit epoll_reactor(
+		  std::chrono::microseconds busy_poll = std::chrono::microseconds( 0 ) );
+		~epoll_reactor( ) override;
+		epoll_reactor( epoll_reactor const & ) = delete;
+		epoll_reactor &operator=( epoll_reactor const & ) = delete;
+
+		void post( std::shared_ptr<details::io_strand> strand ) override;
+		void post_close( std::shared_ptr<details::io_strand> strand ) override;
+		std::optional<::ssize_t> start( details::io_strand &strand ) override;
+		bool cancel( details::io_strand &strand ) override;
+		void interrupt( details::io_strand &strand ) override;
+		bool in_scheduler_thread( ) const override;
+	};
+
+	using epoll_reactor_group = reactor_group<epoll_reactor>;
+
+	/***
+	 * Exec policy that runs a socket's operations on a shared epoll reactor.
+	 * Operations only occupy a thread while their fd is ready, so a handful of
+	 * reactors can serve many thousands of sockets
+	 */
+	class async_exec_policy_epoll {
+		details::duplex_strand m_strands;
+
+	public:
+		async_exec_policy_epoll( );
+		explicit async_exec_policy_epoll( epoll_reactor &reactor );
+		async_exec_policy_epoll( async_exec_policy_epoll const & ) = delete;
+		async_exec_policy_epoll &
+		operator=( async_exec_policy_epoll const & ) = delete;
+
+		template<typename Task>
+		void add_task( Task &&tsk ) {
+			add_io_task( networking::make_io_task( std::forward<Task>( tsk ) ) );
+		}
+
+		/// Queue on the write strand, in order with the other writes
+		void add_io_task( networking::io_task tsk );
+
+		/// Queue on the read strand, which runs alongside the write strand
+		void add_read_io_task( networking::io_task tsk );
+
+		/***
+		 * Queue a task that runs alone once everything queued before it is
+		 * done, e.g. a connect
+		 */
+		void add_exclusive_io_task( networking::io_task tsk );
+
+		/// Interrupt a parked request when its stop token was stopped
+		void interrupt( );
+
+		/***
+		 * Wait for all queued tasks to finish.  Must not be called from the
+		 * reactor's thread
+		 */
+		void wait( ) const;
+	};
+} // namespace daw
@@ -0,0 +1,164 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "cpu_affinity.h"
+#include "details/io_strand.h"
+#include "details/ring_buffer.h"
+#include "io_request.h"
+#include "third_party/jthread.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sys/epoll.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace daw {
+	class work_stealing_pool;
+
+	/***
+	 * One worker of a work_stealing_pool.  It owns a run queue and an epoll set
+	 * for the strands whose home it is.  When its own queue is empty it takes
+	 * ready strands from the back of its siblings' queues
+	 */
+	class pool_worker : public details::io_scheduler {
+		friend class ::daw::work_stealing_pool;
+
+		work_stealing_pool *m_pool;
+		std::size_t m_index;
+		cpu_affinity m_affinity;
+		int m_epoll = -1;
+		int m_wake = -1;
+		std::atomic<bool> m_sleeping = false;
+		mutable std::mutex m_mutex{ };
+		details::ring_buffer<std::shared_ptr<details::io_strand>> m_ready{ };
+		std::vector<std::shared_ptr<details::io_strand>> m_closing{ };
+		details::strand_timers m_timers{ };
+		// Only used by poll_events
+		std::vector<details::io_strand *> m_expired{ };
+		std::vector<std::shared_ptr<details::io_strand>> m_closing_batch{ };
+		std::vector<::epoll_event> m_events{ };
+		std::jthread m_thread;
+
+		void reserve_queues( );
+		void run( std::stop_token const &should_stop );
+		void wake( );
+		bool try_wake( );
+		void poll_events( int timeout );
+		std::shared_ptr<details::io_strand> pop_front( );
+		std::shared_ptr<details::io_strand> steal( );
+
+	public:
+		pool_worker( work_stealing_pool &pool, std::size_t index,
+		             cpu_affinity affinity = { } );
+		~pool_worker( ) override;
+		pool_worker( pool_worker const & ) = delete;
+		pool_worker &operator=( pool_worker const & ) = delete;
+
+		void launch( );
+
+		void post( std::shared_ptr<details::io_strand> strand ) override;
+		void post_close( std::shared_ptr<details::io_strand> strand ) override;
+		std::optional<::ssize_t> start( details::io_strand &strand ) override;
+		bool cancel( details::io_strand &strand ) override;
+		void interrupt( details::io_strand &strand ) override;
+		bool in_scheduler_thread( ) const override;
+
+		std::size_t index( ) const {
+			return m_index;
+		}
+
+		/// The cpu the worker is pinned to, -1 when it is not pinned
+		int cpu( ) const {
+			return m_affinity.cpu;
+		}
+	};
+
+	/***
+	 * A thread pool with one worker and run queue per core.  Each socket has a
+	 * home worker that runs its operations and waits on its fd, idle workers
+	 * steal ready sockets so a busy core does not hold up the others
+	 */
+	class work_stealing_pool {
+		friend class ::daw::pool_worker;
+
+		std::vector<std::unique_ptr<pool_worker>> m_workers;
+		std::atomic<std::size_t> m_next = 0;
+
+		std::shared_ptr<details::io_strand> steal_for( std::size_t thief );
+		void wake_idle( std::size_t except );
+
+	public:
+		/***
+		 * pin_to_cores binds worker N to cpu N % hardware_concurrency, and
+		 * allocates its queues on that cpu's NUMA node
+		 */
+		explicit work_stealing_pool(
+		  std::size_t worker_count = std::thread::hardware_concurrency( ),
+		  bool pin_to_cores = false );
+		~work_stealing_pool( );
+		work_stealing_pool( work_stealing_pool const & ) = delete;
+		work_stealing_pool &operator=( work_stealing_pool const & ) = delete;
+
+		/// The home worker for the next socket, round robin
+		pool_worker &next( );
+		pool_worker &operator[]( std::size_t idx );
+		std::size_t size( ) const;
+
+		/***
+		 * The process wide pool used by default constructed policies, one pinned
+		 * worker per hardware thread
+		 */
+		static work_stealing_pool &default_pool( );
+	};
+
+	/***
+	 * Exec policy that runs a socket's operations on a work_stealing_pool
+	 */
+	class async_exec_policy_pool {
+		details::duplex_strand m_strands;
+
+	public:
+		async_exec_policy_pool( );
+		explicit async_exec_policy_pool( work_stealing_pool &pool );
+		explicit async_exec_policy_pool( pool_worker &home );
+		async_exec_policy_pool( async_exec_policy_pool const & ) = delete;
+		async_exec_policy_pool &
+		operator=( async_exec_policy_pool const & ) = delete;
+
+		template<typename Task>
+		void add_task( Task &&tsk ) {
+			add_io_task( networking::make_io_task( std::forward<Task>( tsk ) ) );
+		}
+
+		/// Queue on the write strand, in order with the other writes
+		void add_io_task( networking::io_task tsk );
+
+		/// Queue on the read strand, which runs alongside the write strand
+		void add_read_io_task( networking::io_task tsk );
+
+		/***
+		 * Queue a task that runs alone once everything queued before it is
+		 * done, e.g. a connect
+		 */
+		void add_exclusive_io_task( networking::io_task tsk );
+
+		/// Interrupt a parked request when its stop token was stopped
+		void interrupt( );
+
+		/***
+		 * Wait for all queued tasks to finish.  Must not be called from a pool
+		 * thread
+		 */
+		void wait( ) const;
+	};
+} // namespace daw
@@ -6,59 +6,112 @@
 
 #pragma once
 
-#include "details/locked_queue.h"
-#include "task_token.h"
+#include "cpu_affinity.h"
+#include "details/io_strand.h"
+#include "details/mpsc_queue.h"
+#include "details/wakeup_fd.h"
+#include "io_request.h"
 #include "third_party/jthread.hpp"
 
-#include <daw/daw_scope_guard.h>
-#include <daw/daw_utility.h>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace daw {
-	/***
-	 * If queue is cleared witout running task, this ensures that the token
-	 * allows the waiters through
-	 */
-	struct packaged_task {
-		struct state_t {
-			mutable std::function<void( )> m_function;
-			mutable task_token m_token;
-
-			state_t( std::function<void( )> function, task_token token )
-			  : m_function( std::move( function ) )
-			  , m_token( std::move( token ) ) {}
-		};
-		std::unique_ptr<state_t> m_state;
+	namespace details {
+		/***
+		 * The worker thread of one async_exec_policy_thread.  It runs the
+		 * policy's strands and waits on their parked requests with poll.
+		 * Strands are posted through a lock free queue, and a post only writes
+		 * the wakeup fd when the worker is asleep in poll
+		 */
+		class thread_scheduler final : public io_scheduler {
+			struct posted_strand {
+				std::shared_ptr<io_strand> strand{ };
+				bool close = false;
+			};
 
-		~packaged_task( ) {
-			if( m_state and not m_state->m_token.try_wait( ) ) {
-				m_state->m_token.notify( );
-			}
-		}
-		packaged_task( packaged_task const & ) = delete;
-		packaged_task( packaged_task && ) noexcept = default;
-		packaged_task &operator=( packaged_task const & ) = delete;
-		packaged_task &operator=( packaged_task && ) noexcept = default;
-
-		packaged_task( std::function<void( )> task, task_token token )
-		  : m_state( std::make_unique<state_t>( std::move( task ),
-		                                        std::move( token ) ) ) {}
-
-		void operator( )( ) const noexcept {
-			try {
-				std::move( m_state->m_function )( );
-			} catch( ... ) {}
-		}
-	};
+			networking::details::wakeup_fd m_wake{ };
+			// A strand is only posted again once the worker has taken it, so the
+			// two lanes and their closes never fill the queue
+			mpsc_queue<posted_strand> m_posted{ 8 };
+			// Set while the worker may block in poll
+			std::atomic<bool> m_sleeping = false;
+			strand_timers m_timers{ };
+			// Only touched on the worker thread
+			std::vector<io_strand *> m_parked{ };
+			std::jthread m_thread;
 
+			void run( std::stop_token const &should_stop );
+			void unparked( io_strand &strand );
+			void wake( );
+
+		public:
+			explicit thread_scheduler( cpu_affinity affinity );
+			~thread_scheduler( ) override;
+			thread_scheduler( thread_scheduler const & ) = delete;
+			thread_scheduler &operator=( thread_scheduler const & ) = delete;
+
+			void post( std::shared_ptr<io_strand> strand ) override;
+			void post_close( std::shared_ptr<io_strand> strand ) override;
+			std::optional<::ssize_t> start( io_strand &strand ) override;
+			bool cancel( io_strand &strand ) override;
+			void interrupt( io_strand &strand ) override;
+			bool in_scheduler_thread( ) const override;
+		};
+	} // namespace details
+
+	/***
+	 * Exec policy that runs a socket's operations on a thread of its own.
+	 * Tasks that block, e.g. a DNS lookup, only hold up the one socket, but
+	 * its read and write strands share the thread, so they hold up both
+	 */
 	class async_exec_policy_thread {
-		daw::locked_queue<packaged_task> m_queue =
-		  daw::locked_queue<packaged_task>( );
-		std::jthread m_thread;
+		details::thread_scheduler m_scheduler;
+		// Shut down before the scheduler's thread stops
+		details::duplex_strand m_strands;
+
+		async_exec_policy_thread( cpu_affinity affinity,
+		                          details::prefer_numa_node const &numa_node );
 
 	public:
-		~async_exec_policy_thread( );
 		async_exec_policy_thread( );
-		task_token add_task( std::function<void( )> tsk );
+
+		/***
+		 * Run the worker thread on affinity's cpu, with its queues allocated on
+		 * the cpu's NUMA node
+		 */
+		explicit async_exec_policy_thread( cpu_affinity affinity );
+		async_exec_policy_thread( async_exec_policy_thread const & ) = delete;
+		async_exec_policy_thread &
+		operator=( async_exec_policy_thread const & ) = delete;
+
+		template<typename Task>
+		void add_task( Task &&tsk ) {
+			add_io_task( networking::make_io_task( std::forward<Task>( tsk ) ) );
+		}
+
+		/// Queue on the write strand, in order with the other writes
+		void add_io_task( networking::io_task tsk );
+
+		/// Queue on the read strand, which runs alongside the write strand
+		void add_read_io_task( networking::io_task tsk );
+
+		/***
+		 * Queue a task that runs alone once everything queued before it is
+		 * done, e.g. a connect
+		 */
+		void add_exclusive_io_task( networking::io_task tsk );
+
+		/// Interrupt a parked request when its stop token was stopped
+		void interrupt( );
+
+		/***
+		 * Wait for all queued tasks to finish.  Must not be called from the
+		 * worker thread
+		 */
 		void wait( ) const;
 	};
 } // namespace daw
@@ -0,0 +1,103 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "details/io_strand.h"
+#include "io_request.h"
+#include "reactor_group.h"
+#include "third_party/jthread.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace daw {
+	/***
+	 * A single thread driving strands through an io_uring.  Sends and receives
+	 * are submitted as SQEs and collected in batches with one io_uring_enter per
+	 * loop, their CQEs resume the strands directly.  Other requests wait for
+	 * readiness with a poll SQE and are then retried without blocking.  A
+	 * request whose deadline passes, or whose stop token is stopped, is
+	 * cancelled in the ring and its strand resumes with -ETIMEDOUT or
+	 * -ECANCELED once the cancelled SQE completes
+	 */
+	class uring_reactor : public details::io_scheduler {
+		struct ring;
+		std::unique_ptr<ring> m_ring;
+		int m_wake = -1;
+		std::uint64_t m_wake_value = 0;
+		details::strand_queue m_posted{ };
+		details::strand_timers m_timers{ };
+		std::vector<details::io_strand *> m_expired{ };
+		std::jthread m_thread;
+
+		void run( std::stop_token const &should_stop );
+		void wake( );
+		void submit_wake_read( );
+		void submit_cancel( details::io_strand &strand );
+		void submit_timeout( );
+		void reap( std::vector<std::shared_ptr<details::io_strand>> &ready );
+
+	public:
+		uring_reactor( );
+		~uring_reactor( ) override;
+		uring_reactor( uring_reactor const & ) = delete;
+		uring_reactor &operator=( uring_reactor const & ) = delete;
+
+		void post( std::shared_ptr<details::io_strand> strand ) override;
+		void post_close( std::shared_ptr<details::io_strand> strand ) override;
+		std::optional<::ssize_t> start( details::io_strand &strand ) override;
+		bool cancel( details::io_strand &strand ) override;
+		void interrupt( details::io_strand &strand ) override;
+		bool in_scheduler_thread( ) const override;
+	};
+
+	using uring_reactor_group = reactor_group<uring_reactor>;
+
+	/***
+	 * Exec policy that runs a socket's operations on a shared io_uring reactor.
+	 * Construction throws a network_exception when io_uring is unavailable
+	 */
+	class async_exec_policy_uring {
+		details::duplex_strand m_strands;
+
+	public:
+		async_exec_policy_uring( );
+		explicit async_exec_policy_uring( uring_reactor &reactor );
+		async_exec_policy_uring( async_exec_policy_uring const & ) = delete;
+		async_exec_policy_uring &
+		operator=( async_exec_policy_uring const & ) = delete;
+
+		template<typename Task>
+		void add_task( Task &&tsk ) {
+			add_io_task( networking::make_io_task( std::forward<Task>( tsk ) ) );
+		}
+
+		/// Queue on the write strand, in order with the other writes
+		void add_io_task( networking::io_task tsk );
+
+		/// Queue on the read strand, which runs alongside the write strand
+		void add_read_io_task( networking::io_task tsk );
+
+		/***
+		 * Queue a task that runs alone once everything queued before it is
+		 * done, e.g. a connect
+		 */
+		void add_exclusive_io_task( networking::io_task tsk );
+
+		/// Interrupt a parked request when its stop token was stopped
+		void interrupt( );
+
+		/***
+		 * Wait for all queued tasks to finish.  Must not be called from the
+		 * reactor's thread
+		 */
+		void wait( ) const;
+	};
+} // namespace daw
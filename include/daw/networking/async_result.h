@@ -6,164 +6,503 @@
 
 #pragma once
 
+#include "details/completion_flag.h"
+#include "details/intrusive_ptr.h"
+#include "details/object_pool.h"
+#include "details/unique_function.h"
 #include "network_exception.h"
-#include "task_token.h"
-
-#include <daw/daw_visit.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
 #include <stdexcept>
 #include <type_traits>
-#include <variant>
+#include <utility>
+#include <vector>
 
 namespace daw {
+	template<typename T>
+	class async_result;
+
+	namespace details {
+		enum class result_status : std::uint8_t { empty, value, error, exception };
+
+		/// An errno style failure, thrown as a network_exception when observed
+		struct result_error {
+			char const *what;
+			int code;
+		};
+
+		struct void_value_t {};
+
+		/***
+		 * The value or failure of an async operation in one buffer with a status
+		 * byte
+		 */
+		template<typename Value>
+		class result_storage {
+			static constexpr std::size_t storage_size = std::max(
+			  { sizeof( Value ), sizeof( std::exception_ptr ), sizeof( result_error ) } );
+			static constexpr std::size_t storage_align =
+			  std::max( { alignof( Value ), alignof( std::exception_ptr ),
+			              alignof( result_error ) } );
+
+			alignas( storage_align ) unsigned char m_buffer[storage_size];
+			result_status m_status = result_status::empty;
+
+			template<typename U>
+			U *as( ) {
+				return std::launder( reinterpret_cast<U *>( m_buffer ) );
+			}
+
+			template<typename U>
+			U const *as( ) const {
+				return std::launder( reinterpret_cast<U const *>( m_buffer ) );
+			}
+
+		protected:
+			template<typename... Args>
+			void emplace_value( Args &&...args ) {
+				clear( );
+				::new( static_cast<void *>( m_buffer ) )
+				  Value( std::forward<Args>( args )... );
+				m_status = result_status::value;
+			}
+
+			void emplace_error( result_error err ) {
+				clear( );
+				::new( static_cast<void *>( m_buffer ) ) result_error( err );
+				m_status = result_status::error;
+			}
+
+			void emplace_exception( std::exception_ptr eptr ) {
+				clear( );
+				::new( static_cast<void *>( m_buffer ) )
+				  std::exception_ptr( std::move( eptr ) );
+				m_status = result_status::exception;
+			}
+
+			void clear( ) noexcept {
+				switch( m_status ) {
+				case result_status::value:
+					as<Value>( )->~Value( );
+					break;
+				case result_status::exception:
+					as<std::exception_ptr>( )->~exception_ptr( );
+					break;
+				default:
+					break;
+				}
+				m_status = result_status::empty;
+			}
+
+		public:
+			result_storage( ) = default;
+			result_storage( result_storage const & ) = delete;
+			result_storage &operator=( result_storage const & ) = delete;
+
+			~result_storage( ) {
+				clear( );
+			}
+
+			result_status status( ) const {
+				return m_status;
+			}
+
+			bool has_failure( ) const {
+				return m_status == result_status::error or
+				       m_status == result_status::exception;
+			}
+
+			result_error const &error( ) const {
+				return *as<result_error>( );
+			}
+
+			std::exception_ptr const &exception( ) const {
+				return *as<std::exception_ptr>( );
+			}
 
+			/// The value, or throws the failure held instead
+			Value &value( ) {
+				switch( m_status ) {
+				case result_status::value:
+					return *as<Value>( );
+				case result_status::error:
+					throw networking::network_exception( as<result_error>( )->what,
+					                                     as<result_error>( )->code );
+				case result_status::exception:
+					std::rethrow_exception( *as<std::exception_ptr>( ) );
+				case result_status::empty:
+					break;
+				}
+				throw std::runtime_error( "Attempt to access an empty result" );
+			}
+		};
+	} // namespace details
+
+	/***
+	 * Shared state of an async_result.  States are reference counted in place
+	 * and recycled through an object_pool when the last reference goes away,
+	 * so starting an operation does not allocate
+	 */
 	template<typename T>
-	struct async_result_state {
-		task_token token;
-		std::variant<std::monostate, T, std::exception_ptr> result{ };
+	class async_result_state
+	  : public details::result_storage<
+	      std::conditional_t<std::is_void_v<T>, details::void_value_t, T>> {
+		enum continuation_status : std::uint8_t { none, registered, completed };
+
+		std::atomic<std::uint32_t> m_refs = 0;
+		std::atomic<std::uint8_t> m_continuation_status = none;
+		unique_function<void( async_result_state & )> m_continuation{ };
+
+		using pool_t = details::object_pool<async_result_state>;
 
-		void set_value( T const &value ) {
-			result = value;
-			token.set_latch( );
+		void finish( ) {
+			completion.set( );
+			if( m_continuation_status.exchange( completed,
+			                                    std::memory_order_acq_rel ) ==
+			    registered ) {
+				auto continuation = std::move( m_continuation );
+				continuation( *this );
+			}
 		}
 
-		void set_value( T &&value ) {
-			result = std::move( value );
-			token.set_latch( );
+		/***
+		 * Store continuation to run with this state once it completes.  Returns
+		 * false, leaving it stored, when the state has already completed.  Only
+		 * one continuation can be set
+		 */
+		template<typename Continuation>
+		bool register_continuation( Continuation &&continuation ) {
+			if( m_continuation_status.load( std::memory_order_acquire ) ==
+			    registered ) {
+				throw std::logic_error( "async_result already has a continuation" );
+			}
+			m_continuation = std::forward<Continuation>( continuation );
+			return m_continuation_status.exchange( registered,
+			                                       std::memory_order_acq_rel ) !=
+			       completed;
 		}
 
-		void set_exception( std::exception_ptr eptr ) {
-			result = eptr;
-			token.set_latch( );
+	public:
+		using value_type =
+		  std::conditional_t<std::is_void_v<T>, details::void_value_t, T>;
+
+		details::completion_flag completion{ };
+
+		static details::intrusive_ptr<async_result_state> make( ) {
+			return details::intrusive_ptr<async_result_state>( pool_t::acquire( ) );
 		}
 
-		void set_exception( ) {
-			set_exception( std::current_exception( ) );
+		void add_ref( ) noexcept {
+			m_refs.fetch_add( 1, std::memory_order_relaxed );
 		}
-	};
 
-	template<>
-	struct async_result_state<void> {
-		struct void_value_t {};
-		task_token token;
-		std::variant<std::monostate, void_value_t, std::exception_ptr> result{ };
+		void release( ) noexcept {
+			if( m_refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+				this->clear( );
+				completion.reset( );
+				m_continuation = nullptr;
+				m_continuation_status.store( none, std::memory_order_relaxed );
+				pool_t::recycle( this );
+			}
+		}
+
+		template<typename... Args>
+		void set_value( Args &&...args ) {
+			this->emplace_value( std::forward<Args>( args )... );
+			finish( );
+		}
 
-		void set_value( ) {
-			result = void_value_t( );
-			token.set_latch( );
+		/// Fail with errno style code, what must be a string literal
+		void set_error( char const *what, int code ) {
+			this->emplace_error( details::result_error{ what, code } );
+			finish( );
 		}
 
 		void set_exception( std::exception_ptr eptr ) {
-			result = eptr;
-			token.set_latch( );
+			this->emplace_exception( std::move( eptr ) );
+			finish( );
 		}
 
 		void set_exception( ) {
 			set_exception( std::current_exception( ) );
 		}
+
+		/// Fail the same way the completed other did
+		template<typename U>
+		void set_failure( async_result_state<U> const &other ) {
+			if( other.status( ) == details::result_status::error ) {
+				set_error( other.error( ).what, other.error( ).code );
+			} else if( other.status( ) == details::result_status::exception ) {
+				set_exception( other.exception( ) );
+			} else {
+				set_exception( std::make_exception_ptr(
+				  std::runtime_error( "Attempt to access an empty result" ) ) );
+			}
+		}
+
+		/***
+		 * Run continuation with this state once it completes, right away when
+		 * it already has
+		 */
+		template<typename Continuation>
+		void set_continuation( Continuation &&continuation ) {
+			if( not register_continuation(
+			      std::forward<Continuation>( continuation ) ) ) {
+				auto cont = std::move( m_continuation );
+				cont( *this );
+			}
+		}
+
+		/***
+		 * Like set_continuation but returns false without running continuation
+		 * when the state has already completed
+		 */
+		template<typename Continuation>
+		bool try_set_continuation( Continuation &&continuation ) {
+			if( register_continuation( std::forward<Continuation>( continuation ) ) ) {
+				return true;
+			}
+			m_continuation = nullptr;
+			return false;
+		}
 	};
 
 	template<typename T>
-	class async_result {
-		std::shared_ptr<async_result_state<T>> m_state;
+	using async_state_ptr = details::intrusive_ptr<async_result_state<T>>;
 
-	public:
-		inline async_result( std::shared_ptr<async_result_state<T>> state ) noexcept
-		  : m_state( std::move( state ) ) {}
+	namespace details {
+		template<typename T>
+		struct is_async_result : std::false_type {};
 
-		[[nodiscard]] bool try_wait( ) const {
-			return m_state->token.try_wait( );
-		}
+		template<typename T>
+		struct is_async_result<async_result<T>> : std::true_type {};
 
-		inline void wait( ) const {
-			m_state->token.wait( );
-		}
+		template<typename T>
+		struct unwrap_async_result {
+			using type = T;
+		};
 
-		template<typename Rep, typename Period>
-		[[nodiscard]] decltype( auto )
-		wait_for( std::chrono::duration<Rep, Period> const &rel_time ) const {
-			return m_state->token.wait_for( rel_time );
-		}
+		template<typename T>
+		struct unwrap_async_result<async_result<T>> {
+			using type = T;
+		};
 
-		template<typename Clock, typename Duration>
-		[[nodiscard]] decltype( auto ) wait_until(
-		  std::chrono::time_point<Clock, Duration> const &timeout_time ) const {
-			return m_state->token.wait_until( timeout_time );
+		/// Complete out with the value or failure of the completed from
+		template<typename T, typename U>
+		void forward_result( async_result_state<T> &out,
+		                     async_result_state<U> &from ) {
+			if( from.status( ) != result_status::value ) {
+				out.set_failure( from );
+			} else if constexpr( std::is_void_v<T> ) {
+				out.set_value( );
+			} else {
+				out.set_value( std::move( from.value( ) ) );
+			}
 		}
 
-		bool is_valid( ) const {
-			wait( );
-			return m_state->result.index( ) == 1 or m_state->result.index( ) == 2;
-		}
+		template<typename T>
+		class async_result_base {
+		protected:
+			async_state_ptr<T> m_state;
+
+		public:
+			inline async_result_base( async_state_ptr<T> state ) noexcept
+			  : m_state( std::move( state ) ) {}
+
+			[[nodiscard]] bool try_wait( ) const {
+				return m_state->completion.try_wait( );
+			}
+
+			inline void wait( ) const {
+				m_state->completion.wait( );
+			}
+
+			template<typename Rep, typename Period>
+			[[nodiscard]] bool
+			wait_for( std::chrono::duration<Rep, Period> const &rel_time ) const {
+				return m_state->completion.wait_for( rel_time );
+			}
+
+			template<typename Clock, typename Duration>
+			[[nodiscard]] bool wait_until(
+			  std::chrono::time_point<Clock, Duration> const &timeout_time ) const {
+				return m_state->completion.wait_until( timeout_time );
+			}
+
+			bool is_valid( ) const {
+				wait( );
+				return m_state->status( ) != result_status::empty;
+			}
+
+			/// The shared state, for combinators
+			async_result_state<T> &state( ) const {
+				return *m_state;
+			}
+
+			/***
+			 * Call on_ready with the completed async_result.  It runs on the thread
+			 * that completes the result, for socket operations the socket's
+			 * executor, or right away when the result is already complete.  It
+			 * must not block and a result takes only one continuation
+			 */
+			template<typename Callback>
+			void on_ready( Callback &&on_ready ) {
+				m_state->set_continuation(
+				  [on_ready = std::forward<Callback>( on_ready )](
+				    async_result_state<T> &state ) mutable {
+					  on_ready( async_result<T>( async_state_ptr<T>( &state ) ) );
+				  } );
+			}
+
+			/***
+			 * Call func with the value once it is ready, func( ) for
+			 * async_result<void>, and return the async_result of what it returns.
+			 * A failure skips func and is passed on.  When func returns an
+			 * async_result the returned result completes along with that one, so
+			 * operations can be chained without blocking
+			 */
+			template<typename Func>
+			auto then( Func &&func ) {
+				using func_result_t = typename std::conditional_t<
+				  std::is_void_v<T>, std::invoke_result<Func &>,
+				  std::invoke_result<Func &, std::add_lvalue_reference_t<
+				                               typename async_result_state<
+				                                 T>::value_type>>>::type;
+				using result_t = typename unwrap_async_result<func_result_t>::type;
+
+				auto out = async_result_state<result_t>::make( );
+				on_ready( [out, func = std::forward<Func>( func )](
+				            async_result<T> ready ) mutable {
+					auto &state = ready.state( );
+					if( state.status( ) != result_status::value ) {
+						out->set_failure( state );
+						return;
+					}
+					try {
+						auto const call = [&]( ) -> decltype( auto ) {
+							if constexpr( std::is_void_v<T> ) {
+								return func( );
+							} else {
+								return func( state.value( ) );
+							}
+						};
+						if constexpr( is_async_result<func_result_t>::value ) {
+							call( ).on_ready( [out]( auto inner ) {
+								forward_result( *out, inner.state( ) );
+							} );
+						} else if constexpr( std::is_void_v<func_result_t> ) {
+							call( );
+							out->set_value( );
+						} else {
+							out->set_value( call( ) );
+						}
+					} catch( ... ) { out->set_exception( ); }
+				} );
+				return async_result<result_t>( std::move( out ) );
+			}
+		};
+	} // namespace details
+
+	template<typename T>
+	class async_result : public details::async_result_base<T> {
+	public:
+		using details::async_result_base<T>::async_result_base;
 
 		T &get( ) {
-			wait( );
-			return daw::visit_nt(
-			  m_state->result,
-			  []( std::monostate ) -> T & {
-				  throw std::runtime_error( "Attempt to access an empty result" );
-			  },
-			  []( T &value ) -> T & { return value; },
-			  []( std::exception_ptr ep ) -> T & { std::rethrow_exception( ep ); } );
+			this->wait( );
+			return this->m_state->value( );
 		}
 
 		T const &get( ) const {
-			wait( );
-			return daw::visit_nt(
-			  m_state->result,
-			  []( std::monostate ) -> T const & {
-				  throw std::runtime_error( "Attempt to access an empty result" );
-			  },
-			  []( T &value ) -> T const & { return value; },
-			  []( std::exception_ptr ep ) -> T const & {
-				  std::rethrow_exception( ep );
-			  } );
+			this->wait( );
+			return this->m_state->value( );
 		}
 	};
 
 	template<>
-	class async_result<void> {
-		std::shared_ptr<async_result_state<void>> m_state;
-
+	class async_result<void> : public details::async_result_base<void> {
 	public:
-		inline async_result(
-		  std::shared_ptr<async_result_state<void>> state ) noexcept
-		  : m_state( std::move( state ) ) {}
+		using details::async_result_base<void>::async_result_base;
 
-		[[nodiscard]] inline bool try_wait( ) const {
-			return m_state->token.try_wait( );
-		}
-
-		inline void wait( ) const {
-			m_state->token.wait( );
+		void get( ) const {
+			wait( );
+			(void)m_state->value( );
 		}
+	};
 
-		template<typename Rep, typename Period>
-		[[nodiscard]] decltype( auto )
-		wait_for( std::chrono::duration<Rep, Period> const &rel_time ) const {
-			return m_state->token.wait_for( rel_time );
+	/***
+	 * Completes once every result has.  It fails with the failure of the first
+	 * result, in order, that failed.  Uses the continuation of each result
+	 */
+	template<typename T>
+	async_result<void> when_all( std::vector<async_result<T>> results ) {
+		struct shared_t {
+			std::atomic<std::size_t> remaining = 0;
+			std::vector<async_result<T>> results{ };
+			async_state_ptr<void> out{ };
+		};
+		auto out = async_result_state<void>::make( );
+		if( results.empty( ) ) {
+			out->set_value( );
+			return async_result<void>( std::move( out ) );
 		}
-
-		template<typename Clock, typename Duration>
-		[[nodiscard]] decltype( auto ) wait_until(
-		  std::chrono::time_point<Clock, Duration> const &timeout_time ) const {
-			return m_state->token.wait_until( timeout_time );
+		auto shared = std::make_shared<shared_t>( );
+		shared->remaining = results.size( );
+		shared->results = std::move( results );
+		shared->out = out;
+		for( auto &result : shared->results ) {
+			result.on_ready( [shared]( async_result<T> const & ) {
+				if( shared->remaining.fetch_sub( 1, std::memory_order_acq_rel ) != 1 ) {
+					return;
+				}
+				for( auto &r : shared->results ) {
+					if( r.state( ).status( ) != details::result_status::value ) {
+						shared->out->set_failure( r.state( ) );
+						return;
+					}
+				}
+				shared->out->set_value( );
+			} );
 		}
+		return async_result<void>( std::move( out ) );
+	}
 
-		bool is_valid( ) const {
-			wait( );
-			return m_state->result.index( ) == 1 or m_state->result.index( ) == 2;
+	/***
+	 * Completes with the index of the first result to complete, successfully
+	 * or not.  Uses the continuation of each result
+	 */
+	template<typename T>
+	async_result<std::size_t> when_any( std::vector<async_result<T>> results ) {
+		struct shared_t {
+			std::atomic<bool> done = false;
+			async_state_ptr<std::size_t> out;
+		};
+		auto out = async_result_state<std::size_t>::make( );
+		if( results.empty( ) ) {
+			out->set_exception( std::make_exception_ptr(
+			  std::invalid_argument( "when_any of no results" ) ) );
+			return async_result<std::size_t>( std::move( out ) );
 		}
-
-		void get( ) const {
-			wait( );
-			return daw::visit_nt(
-			  m_state->result,
-			  []( std::monostate ) -> void {
-				  throw std::runtime_error( "Attempt to access an empty result" );
-			  },
-			  []( async_result_state<void>::void_value_t ) -> void {},
-			  []( std::exception_ptr ep ) -> void { std::rethrow_exception( ep ); } );
+		auto shared = std::make_shared<shared_t>( );
+		shared->out = out;
+		for( std::size_t n = 0; n < results.size( ); ++n ) {
+			results[n].on_ready( [shared, n]( async_result<T> const & ) {
+				if( not shared->done.exchange( true, std::memory_order_acq_rel ) ) {
+					shared->out->set_value( n );
+				}
+			} );
 		}
-	};
+		return async_result<std::size_t>( std::move( out ) );
+	}
 } // namespace daw
+
+#if defined( __cpp_impl_coroutine ) and __has_include( <coroutine> )
+#include "async_coroutine.h"
+#endif
@@ -0,0 +1,216 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "async_result.h"
+#include "details/byte_ring.h"
+
+#include <daw/daw_span.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace daw::networking {
+	namespace details {
+		/***
+		 * Offset of the first delimiter in data at or after from, or npos.
+		 * memchr and memmem are vectorized in the common C libraries, so this is
+		 * the SIMD scan without carrying intrinsics per target
+		 */
+		inline std::size_t find_delimiter( daw::span<char const> data,
+		                                   std::size_t from,
+		                                   std::string_view delimiter ) {
+			if( delimiter.empty( ) ) {
+				return from;
+			}
+			auto const *first = data.data( ) + from;
+			auto const size = data.size( ) - from;
+			void const *pos =
+			  delimiter.size( ) == 1
+			    ? std::memchr( first, delimiter.front( ), size )
+			    : ::memmem( first, size, delimiter.data( ), delimiter.size( ) );
+			if( pos == nullptr ) {
+				return std::string_view::npos;
+			}
+			return static_cast<std::size_t>( static_cast<char const *>( pos ) -
+			                                 data.data( ) );
+		}
+	} // namespace details
+
+	/***
+	 * Reads a stream through a byte_ring so framing, lines or length prefixed
+	 * records, does not cost a receive per field or a copy out of the buffer.
+	 * Client is anything with read_some_async( daw::span<char> ), such as
+	 * unique_tcp_client or shared_tcp_client, and must outlive the reader.
+	 *
+	 * The spans returned point into the ring and stay valid until the next
+	 * call on the reader.  One operation runs at a time, and the reader must
+	 * outlive it.  A record that cannot fit the ring fails with EMSGSIZE, and
+	 * one cut short by the end of the stream with ENODATA
+	 */
+	template<typename Client>
+	class basic_buffered_reader {
+		using result_t = daw::span<char const>;
+		// Bytes the result has and bytes to consume, once the buffer holds them
+		using found_t = std::optional<std::pair<std::size_t, std::size_t>>;
+
+		Client *m_client;
+		::daw::details::byte_ring m_ring;
+		bool m_eof = false;
+
+		/// Commit a completed read, false after failing state with its error
+		bool received( async_result_state<result_t> &state,
+		               async_result_state<std::size_t> &read ) {
+			if( read.status( ) != ::daw::details::result_status::value ) {
+				state.set_failure( read );
+				return false;
+			}
+			auto const count = read.value( );
+			if( count == 0 ) {
+				m_eof = true;
+			} else {
+				m_ring.commit( count );
+			}
+			return true;
+		}
+
+		/***
+		 * Receive until match finds what it needs in the unread bytes.  Reads
+		 * that complete right away are handled in the loop rather than by a
+		 * nested continuation
+		 */
+		template<typename Match>
+		void fill( async_state_ptr<result_t> state, Match match ) {
+			while( true ) {
+				auto const data = m_ring.readable( );
+				auto const unread = result_t( data.data( ), data.size( ) );
+				if( found_t const found = match( unread ) ) {
+					m_ring.consume( found->second );
+					state->set_value( result_t( data.data( ), found->first ) );
+					return;
+				}
+				if( m_eof ) {
+					state->set_error( "End of stream", ENODATA );
+					return;
+				}
+				auto const space = m_ring.writable( );
+				if( space.empty( ) ) {
+					state->set_error( "Record does not fit the read buffer", EMSGSIZE );
+					return;
+				}
+				auto read = m_client->read_some_async( space );
+				if( read.state( ).try_set_continuation(
+				      [this, state, match]( async_result_state<std::size_t> &done ) mutable {
+					      if( received( *state, done ) ) {
+						      fill( std::move( state ), std::move( match ) );
+					      }
+				      } ) ) {
+					return;
+				}
+				if( not received( *state, read.state( ) ) ) {
+					return;
+				}
+			}
+		}
+
+		template<typename Match>
+		async_result<result_t> start( Match match ) {
+			auto state = async_result_state<result_t>::make( );
+			fill( state, std::move( match ) );
+			return { std::move( state ) };
+		}
+
+		async_result<result_t> too_large( ) {
+			auto state = async_result_state<result_t>::make( );
+			state->set_error( "Record does not fit the read buffer", EMSGSIZE );
+			return { std::move( state ) };
+		}
+
+	public:
+		static constexpr std::size_t default_capacity = 64U * 1024U;
+
+		/// capacity is rounded up to whole pages and bounds the longest record
+		explicit basic_buffered_reader( Client &client,
+		                                std::size_t capacity = default_capacity )
+		  : m_client( &client )
+		  , m_ring( capacity ) {}
+
+		basic_buffered_reader( basic_buffered_reader const & ) = delete;
+		basic_buffered_reader &operator=( basic_buffered_reader const & ) = delete;
+
+		std::size_t capacity( ) const {
+			return m_ring.capacity( );
+		}
+
+		/// The bytes received but not yet consumed
+		result_t buffered( ) const {
+			auto const data = m_ring.readable( );
+			return result_t( data.data( ), data.size( ) );
+		}
+
+		/// Drop count bytes of buffered( )
+		void consume( std::size_t count ) {
+			m_ring.consume( count );
+		}
+
+		/***
+		 * Everything up to and including the next delimiter, e.g. "\r\n" for a
+		 * line.  Bytes already searched are not searched again as more arrive
+		 */
+		[[nodiscard]] async_result<result_t>
+		read_until( std::string_view delimiter ) {
+			return start( [delimiter = std::string( delimiter ),
+			               scanned = std::size_t{ 0 }]( result_t data ) mutable
+			              -> found_t {
+				auto const pos = details::find_delimiter( data, scanned, delimiter );
+				if( pos == std::string_view::npos ) {
+					// A delimiter split over two reads starts in the last size - 1 bytes
+					scanned = data.size( ) >= delimiter.size( )
+					            ? data.size( ) - delimiter.size( ) + 1
+					            : 0;
+					return std::nullopt;
+				}
+				auto const end = pos + delimiter.size( );
+				return std::pair( end, end );
+			} );
+		}
+
+		/// The next count bytes
+		[[nodiscard]] async_result<result_t> read_exactly( std::size_t count ) {
+			if( count > capacity( ) ) {
+				return too_large( );
+			}
+			return start( [count]( result_t data ) -> found_t {
+				if( data.size( ) < count ) {
+					return std::nullopt;
+				}
+				return std::pair( count, count );
+			} );
+		}
+
+		/***
+		 * At least count buffered bytes, all that are buffered, without
+		 * consuming them
+		 */
+		[[nodiscard]] async_result<result_t> peek( std::size_t count ) {
+			if( count > capacity( ) ) {
+				return too_large( );
+			}
+			return start( [count]( result_t data ) -> found_t {
+				if( data.size( ) < count ) {
+					return std::nullopt;
+				}
+				return std::pair( data.size( ), std::size_t{ 0 } );
+			} );
+		}
+	};
+} // namespace daw::networking
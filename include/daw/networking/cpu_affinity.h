@@ -0,0 +1,140 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#if defined( __linux__ )
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace daw {
+	/***
+	 * The cpu an executor's thread runs on, none to leave it to the
+	 * scheduler.  A pinned executor also allocates its queues on the cpu's
+	 * NUMA node
+	 */
+	struct cpu_affinity {
+		int cpu = -1;
+
+		constexpr bool pinned( ) const {
+			return cpu >= 0;
+		}
+	};
+
+	namespace details {
+		inline int cpu_count( ) {
+			return static_cast<int>(
+			  std::max( std::thread::hardware_concurrency( ), 1U ) );
+		}
+
+		/// Pin the calling thread to cpu, returning 0 or the error
+		inline int pin_current_thread( int cpu ) {
+#if defined( __linux__ )
+			if( cpu < 0 or cpu >= CPU_SETSIZE ) {
+				return EINVAL;
+			}
+			auto cpus = ::cpu_set_t{ };
+			CPU_ZERO( &cpus );
+			CPU_SET( cpu, &cpus );
+			return ::pthread_setaffinity_np( ::pthread_self( ), sizeof( cpus ),
+			                                 &cpus );
+#else
+			(void)cpu;
+			return ENOTSUP;
+#endif
+		}
+
+		/// The NUMA node cpu belongs to, -1 when it is not known
+		inline int numa_node_of_cpu( int cpu ) {
+#if defined( __linux__ )
+			if( cpu < 0 ) {
+				return -1;
+			}
+			auto const path = "/sys/devices/system/cpu/cpu" + std::to_string( cpu );
+			auto *dir = ::opendir( path.c_str( ) );
+			if( dir == nullptr ) {
+				return -1;
+			}
+			int node = -1;
+			while( auto const *entry = ::readdir( dir ) ) {
+				if( std::strncmp( entry->d_name, "node", 4 ) == 0 ) {
+					node = std::atoi( entry->d_name + 4 );
+					break;
+				}
+			}
+			(void)::closedir( dir );
+			return node;
+#else
+			(void)cpu;
+			return -1;
+#endif
+		}
+
+		/***
+		 * While alive, memory the calling thread touches for the first time is
+		 * taken from node when it has any free.  Memory the allocator reuses
+		 * keeps the node it already had
+		 */
+		class prefer_numa_node {
+#if defined( __linux__ )
+			static constexpr unsigned long max_node = 1024;
+			static constexpr auto mask_words =
+			  max_node / ( sizeof( unsigned long ) * CHAR_BIT );
+
+			int m_old_mode = MPOL_DEFAULT;
+			unsigned long m_old_mask[mask_words]{ };
+			bool m_active = false;
+#endif
+
+		public:
+			explicit prefer_numa_node( int node ) {
+#if defined( __linux__ )
+				if( node < 0 or static_cast<unsigned long>( node ) >= max_node ) {
+					return;
+				}
+				if( ::syscall( SYS_get_mempolicy, &m_old_mode, m_old_mask, max_node,
+				               nullptr, 0 ) < 0 ) {
+					return;
+				}
+				unsigned long mask[mask_words]{ };
+				auto const bits = sizeof( unsigned long ) * CHAR_BIT;
+				mask[static_cast<unsigned long>( node ) / bits] =
+				  1UL << ( static_cast<unsigned long>( node ) % bits );
+				m_active = ::syscall( SYS_set_mempolicy, MPOL_PREFERRED, mask,
+				                      max_node + 1 ) == 0;
+#else
+				(void)node;
+#endif
+			}
+
+			prefer_numa_node( prefer_numa_node const & ) = delete;
+			prefer_numa_node &operator=( prefer_numa_node const & ) = delete;
+
+			~prefer_numa_node( ) {
+#if defined( __linux__ )
+				if( m_active ) {
+					(void)::syscall( SYS_set_mempolicy, m_old_mode,
+					                 m_old_mode == MPOL_DEFAULT ? nullptr : m_old_mask,
+					                 m_old_mode == MPOL_DEFAULT ? 0 : max_node + 1 );
+				}
+#endif
+			}
+		};
+	} // namespace details
+} // namespace daw
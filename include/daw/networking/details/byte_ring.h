@@ -0,0 +1,130 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <daw/daw_span.h>
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace daw::details {
+	/***
+	 * A fixed size byte FIFO whose unread bytes and free space are each one
+	 * contiguous span.  On Linux the storage is a memfd mapped twice back to
+	 * back, so a span running off the end carries on in the second mapping
+	 * and nothing is ever copied.  Elsewhere, or when the mapping fails, the
+	 * unread bytes move to the front before free space is handed out
+	 */
+	class byte_ring {
+		char *m_data = nullptr;
+		std::size_t m_capacity = 0;
+		std::size_t m_start = 0;
+		std::size_t m_size = 0;
+		std::unique_ptr<char[]> m_fallback{ };
+
+		bool map_mirrored( ) {
+#if defined( __linux__ )
+			int const fd = ::memfd_create( "daw_byte_ring", MFD_CLOEXEC );
+			if( fd < 0 ) {
+				return false;
+			}
+			auto mirrored = false;
+			if( ::ftruncate( fd, static_cast<::off_t>( m_capacity ) ) == 0 ) {
+				void *base = ::mmap( nullptr, 2 * m_capacity, PROT_NONE,
+				                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+				if( base != MAP_FAILED ) {
+					auto *first = static_cast<char *>( base );
+					mirrored = ::mmap( first, m_capacity, PROT_READ | PROT_WRITE,
+					                   MAP_SHARED | MAP_FIXED, fd, 0 ) != MAP_FAILED and
+					           ::mmap( first + m_capacity, m_capacity,
+					                   PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+					                   fd, 0 ) != MAP_FAILED;
+					if( mirrored ) {
+						m_data = first;
+					} else {
+						(void)::munmap( base, 2 * m_capacity );
+					}
+				}
+			}
+			(void)::close( fd );
+			return mirrored;
+#else
+			return false;
+#endif
+		}
+
+	public:
+		/// At least min_capacity bytes, rounded up to whole pages
+		explicit byte_ring( std::size_t min_capacity ) {
+			auto const page = static_cast<std::size_t>( ::sysconf( _SC_PAGESIZE ) );
+			m_capacity = ( ( min_capacity + page - 1 ) / page ) * page;
+			if( m_capacity == 0 ) {
+				m_capacity = page;
+			}
+			if( not map_mirrored( ) ) {
+				m_fallback = std::make_unique<char[]>( m_capacity );
+				m_data = m_fallback.get( );
+			}
+		}
+
+		byte_ring( byte_ring const & ) = delete;
+		byte_ring &operator=( byte_ring const & ) = delete;
+
+		~byte_ring( ) {
+			if( mirrored( ) ) {
+				(void)::munmap( m_data, 2 * m_capacity );
+			}
+		}
+
+		bool mirrored( ) const {
+			return not m_fallback;
+		}
+
+		std::size_t capacity( ) const {
+			return m_capacity;
+		}
+
+		/// The unread bytes
+		std::size_t size( ) const {
+			return m_size;
+		}
+
+		daw::span<char> readable( ) const {
+			return { m_data + m_start, m_size };
+		}
+
+		/***
+		 * The free space, fill some of it and commit that.  Without the mirror
+		 * this moves the unread bytes, so spans from readable( ) go stale
+		 */
+		daw::span<char> writable( ) {
+			if( mirrored( ) ) {
+				return { m_data + ( m_start + m_size ) % m_capacity,
+				         m_capacity - m_size };
+			}
+			if( m_start != 0 ) {
+				std::memmove( m_data, m_data + m_start, m_size );
+				m_start = 0;
+			}
+			return { m_data + m_size, m_capacity - m_size };
+		}
+
+		/// Make count bytes written to writable( ) readable
+		void commit( std::size_t count ) {
+			m_size += count;
+		}
+
+		/// Drop count unread bytes
+		void consume( std::size_t count ) {
+			m_size -= count;
+			m_start = m_size == 0 ? 0 : ( m_start + count ) % m_capacity;
+		}
+	};
+} // namespace daw::details
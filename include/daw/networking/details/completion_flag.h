@@ -0,0 +1,99 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "futex.h"
+#include "spin_wait.h"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+
+namespace daw::details {
+	/***
+	 * One shot completion signal in a single futex word, it needs no storage of
+	 * its own.  Setting it only makes the wake syscall when a thread is
+	 * blocked in wait, and wait spins adaptively before blocking
+	 */
+	class completion_flag {
+		static constexpr std::uint32_t unset = 0;
+		static constexpr std::uint32_t is_set = 1;
+		static constexpr std::uint32_t has_waiters = 2;
+
+		mutable std::atomic<std::uint32_t> m_state = unset;
+
+		/// Mark that a waiter is about to block, false when the flag got set
+		bool prepare_wait( ) const {
+			auto state = m_state.load( std::memory_order_acquire );
+			while( state == unset ) {
+				if( m_state.compare_exchange_weak( state, has_waiters,
+				                                   std::memory_order_acquire ) ) {
+					return true;
+				}
+			}
+			return state == has_waiters;
+		}
+
+	public:
+		completion_flag( ) = default;
+		completion_flag( completion_flag const & ) = delete;
+		completion_flag &operator=( completion_flag const & ) = delete;
+
+		void set( ) {
+			if( m_state.exchange( is_set, std::memory_order_release ) ==
+			    has_waiters ) {
+				futex_wake( m_state, INT_MAX );
+			}
+		}
+
+		[[nodiscard]] bool try_wait( ) const {
+			return m_state.load( std::memory_order_acquire ) == is_set;
+		}
+
+		void wait( ) const {
+			if( try_wait( ) ) {
+				return;
+			}
+			auto const spinner = adaptive_spin( );
+			if( not spinner.spin( [&] { return try_wait( ); } ) ) {
+				while( prepare_wait( ) ) {
+					futex_wait( m_state, has_waiters );
+				}
+			}
+			spinner.record( );
+		}
+
+		/// Returns true when the flag was set before timeout_time
+		template<typename Clock, typename Duration>
+		[[nodiscard]] bool
+		wait_until( std::chrono::time_point<Clock, Duration> const &timeout_time ) const {
+			while( prepare_wait( ) ) {
+				auto const now = Clock::now( );
+				if( now >= timeout_time ) {
+					return false;
+				}
+				futex_wait_for(
+				  m_state, has_waiters,
+				  std::chrono::duration_cast<std::chrono::nanoseconds>( timeout_time -
+				                                                        now ) );
+			}
+			return true;
+		}
+
+		template<typename Rep, typename Period>
+		[[nodiscard]] bool
+		wait_for( std::chrono::duration<Rep, Period> const &rel_time ) const {
+			return wait_until( std::chrono::steady_clock::now( ) + rel_time );
+		}
+
+		/// Back to unset, only valid while no thread can be waiting
+		void reset( ) {
+			m_state.store( unset, std::memory_order_relaxed );
+		}
+	};
+} // namespace daw::details
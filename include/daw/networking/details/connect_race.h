@@ -0,0 +1,214 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "../network_exception.h"
+#include "../socket_address.h"
+#include "../socket_options.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace daw::networking::details {
+	/***
+	 * Happy Eyeballs(RFC 8305) connect across every address of a name.  The
+	 * addresses are interleaved by family and a new nonblocking connect starts
+	 * each attempt_delay, or as soon as one fails, while the earlier ones keep
+	 * going.  The first to connect wins and the rest are closed.  The attempts
+	 * and the stagger timer sit in an epoll set, so a task waits for the race
+	 * with io_request::wait_readable( fd( ) ) and calls step( ) on each wakeup
+	 */
+	class connect_race {
+		std::vector<socket_address> m_addresses{ };
+		std::size_t m_next = 0;
+		std::vector<int> m_attempts{ };
+		int m_epoll = -1;
+		int m_timer = -1;
+		int m_socket_type;
+		std::chrono::milliseconds m_attempt_delay;
+		socket_option_list m_options;
+		int m_winner = -1;
+		int m_error = ECONNREFUSED;
+
+		/// Alternate families, starting with the family of the first address
+		void order( std::vector<socket_address> const &addresses ) {
+			if( addresses.empty( ) ) {
+				return;
+			}
+			auto first = std::vector<socket_address>( );
+			auto other = std::vector<socket_address>( );
+			for( auto const &address : addresses ) {
+				( address.family( ) == addresses.front( ).family( ) ? first : other )
+				  .push_back( address );
+			}
+			for( std::size_t n = 0; n < std::max( first.size( ), other.size( ) );
+			     ++n ) {
+				if( n < first.size( ) ) {
+					m_addresses.push_back( first[n] );
+				}
+				if( n < other.size( ) ) {
+					m_addresses.push_back( other[n] );
+				}
+			}
+		}
+
+		void arm_timer( bool armed ) {
+			auto spec = ::itimerspec( );
+			if( armed ) {
+				auto const ns =
+				  std::chrono::duration_cast<std::chrono::nanoseconds>( m_attempt_delay )
+				    .count( );
+				spec.it_value.tv_sec = static_cast<::time_t>( ns / 1'000'000'000 );
+				spec.it_value.tv_nsec = static_cast<long>( ns % 1'000'000'000 );
+			}
+			(void)::timerfd_settime( m_timer, 0, &spec, nullptr );
+		}
+
+		void drop_attempt( int fd ) {
+			(void)::epoll_ctl( m_epoll, EPOLL_CTL_DEL, fd, nullptr );
+			m_attempts.erase( std::find( m_attempts.begin( ), m_attempts.end( ), fd ) );
+		}
+
+		/***
+		 * Start connecting to the next address, moving past any that fail right
+		 * away.  The timer starts the one after unless this was the last
+		 */
+		void start_next( ) {
+			while( m_next < m_addresses.size( ) and m_winner < 0 ) {
+				auto const &address = m_addresses[m_next++];
+				int const fd = ::socket( address.storage.ss_family,
+				                         m_socket_type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+				if( fd < 0 ) {
+					m_error = errno;
+					continue;
+				}
+				if( int const err = apply_socket_options( fd, m_options ); err != 0 ) {
+					m_error = err;
+					(void)::close( fd );
+					continue;
+				}
+				if( ::connect( fd, address.data( ), address.size ) == 0 ) {
+					m_winner = fd;
+					return;
+				}
+				if( errno != EINPROGRESS ) {
+					m_error = errno;
+					(void)::close( fd );
+					continue;
+				}
+				auto ev = ::epoll_event( );
+				ev.events = EPOLLOUT;
+				ev.data.fd = fd;
+				if( ::epoll_ctl( m_epoll, EPOLL_CTL_ADD, fd, &ev ) < 0 ) {
+					m_error = errno;
+					(void)::close( fd );
+					continue;
+				}
+				m_attempts.push_back( fd );
+				arm_timer( m_next < m_addresses.size( ) );
+				return;
+			}
+		}
+
+	public:
+		connect_race( std::vector<socket_address> const &addresses,
+		              std::uint16_t port, socket_types st,
+		              std::chrono::milliseconds attempt_delay,
+		              socket_option_list options = { } )
+		  : m_socket_type( static_cast<int>( st ) )
+		  , m_attempt_delay( attempt_delay )
+		  , m_options( std::move( options ) ) {
+			order( addresses );
+			for( auto &address : m_addresses ) {
+				address.set_port( port );
+			}
+			m_epoll = ::epoll_create1( EPOLL_CLOEXEC );
+			m_timer = ::timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC );
+			auto ev = ::epoll_event( );
+			ev.events = EPOLLIN;
+			ev.data.fd = m_timer;
+			if( m_epoll < 0 or m_timer < 0 or
+			    ::epoll_ctl( m_epoll, EPOLL_CTL_ADD, m_timer, &ev ) < 0 ) {
+				auto const err = errno;
+				(void)::close( m_epoll );
+				(void)::close( m_timer );
+				throw network_exception( "Error creating connect race", err );
+			}
+			start_next( );
+		}
+
+		connect_race( connect_race const & ) = delete;
+		connect_race &operator=( connect_race const & ) = delete;
+
+		~connect_race( ) {
+			for( int fd : m_attempts ) {
+				(void)::close( fd );
+			}
+			if( m_winner >= 0 ) {
+				(void)::close( m_winner );
+			}
+			(void)::close( m_timer );
+			(void)::close( m_epoll );
+		}
+
+		/// Readable whenever step( ) has something to do
+		int fd( ) const {
+			return m_epoll;
+		}
+
+		/***
+		 * Advance the race.  Returns the connected socket, which the caller now
+		 * owns, -errno of the last failure when every address failed, or nullopt
+		 * to wait for fd( ) again
+		 */
+		std::optional<int> step( ) {
+			::epoll_event events[16];
+			int const count = m_winner >= 0 ? 0 : ::epoll_wait( m_epoll, events, 16, 0 );
+			for( int n = 0; n < count and m_winner < 0; ++n ) {
+				int const fd = events[n].data.fd;
+				if( fd == m_timer ) {
+					std::uint64_t expirations = 0;
+					(void)::read( m_timer, &expirations, sizeof( expirations ) );
+					start_next( );
+					continue;
+				}
+				int err = 0;
+				auto len = static_cast<::socklen_t>( sizeof( err ) );
+				if( ::getsockopt( fd, SOL_SOCKET, SO_ERROR, &err, &len ) < 0 ) {
+					err = errno;
+				}
+				drop_attempt( fd );
+				if( err == 0 ) {
+					m_winner = fd;
+					break;
+				}
+				m_error = err;
+				(void)::close( fd );
+				// A failure starts the next attempt without waiting for the timer
+				start_next( );
+			}
+			if( m_winner >= 0 ) {
+				return std::exchange( m_winner, -1 );
+			}
+			if( m_attempts.empty( ) and m_next == m_addresses.size( ) ) {
+				return -m_error;
+			}
+			return std::nullopt;
+		}
+	};
+} // namespace daw::networking::details
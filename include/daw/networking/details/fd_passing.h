@@ -0,0 +1,110 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "object_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace daw::details {
+	/***
+	 * The msghdr of a Unix domain socket send or receive that carries open file
+	 * descriptors in an SCM_RIGHTS control message along with the data
+	 */
+	class fd_passing_msg {
+	public:
+		/// Most descriptors passed in one message
+		static constexpr std::size_t max_fds = 32;
+
+	private:
+		::msghdr m_msg{ };
+		::iovec m_iov{ };
+		alignas( ::cmsghdr ) unsigned char m_control[CMSG_SPACE(
+		  sizeof( int ) * max_fds )];
+
+	public:
+		/***
+		 * Send size bytes of data with fd_count descriptors from fds, at most
+		 * max_fds of them
+		 */
+		::msghdr *send( void const *data, std::size_t size, int const *fds,
+		                std::size_t fd_count ) {
+			fd_count = std::min( fd_count, max_fds );
+			m_msg = ::msghdr{ };
+			m_iov = ::iovec{ const_cast<void *>( data ), size };
+			m_msg.msg_iov = &m_iov;
+			m_msg.msg_iovlen = 1;
+			if( fd_count > 0 ) {
+				std::memset( m_control, 0, sizeof( m_control ) );
+				m_msg.msg_control = m_control;
+				m_msg.msg_controllen = CMSG_SPACE( sizeof( int ) * fd_count );
+				auto *cm = CMSG_FIRSTHDR( &m_msg );
+				cm->cmsg_level = SOL_SOCKET;
+				cm->cmsg_type = SCM_RIGHTS;
+				cm->cmsg_len = CMSG_LEN( sizeof( int ) * fd_count );
+				std::memcpy( CMSG_DATA( cm ), fds, sizeof( int ) * fd_count );
+			}
+			return &m_msg;
+		}
+
+		/// Receive into size bytes of data with room for max_fds descriptors
+		::msghdr *receive( void *data, std::size_t size ) {
+			m_msg = ::msghdr{ };
+			m_iov = ::iovec{ data, size };
+			m_msg.msg_iov = &m_iov;
+			m_msg.msg_iovlen = 1;
+			m_msg.msg_control = m_control;
+			m_msg.msg_controllen = sizeof( m_control );
+			return &m_msg;
+		}
+
+		/***
+		 * After a receive, copy the descriptors that arrived into fds and
+		 * return how many arrived.  The ones that do not fit are closed
+		 */
+		std::size_t take_fds( int *fds, std::size_t fd_capacity ) const {
+			std::size_t count = 0;
+			for( auto *cm = CMSG_FIRSTHDR( &m_msg ); cm != nullptr;
+			     cm = CMSG_NXTHDR( const_cast<::msghdr *>( &m_msg ), cm ) ) {
+				if( cm->cmsg_level != SOL_SOCKET or cm->cmsg_type != SCM_RIGHTS ) {
+					continue;
+				}
+				auto const n = ( cm->cmsg_len - CMSG_LEN( 0 ) ) / sizeof( int );
+				for( std::size_t i = 0; i < n; ++i ) {
+					int fd = -1;
+					std::memcpy( &fd, CMSG_DATA( cm ) + i * sizeof( int ),
+					             sizeof( fd ) );
+					if( count < fd_capacity ) {
+						fds[count] = fd;
+					} else {
+						(void)::close( fd );
+					}
+					++count;
+				}
+			}
+			return count;
+		}
+
+		/// The control buffer was too small and descriptors were dropped
+		bool truncated( ) const {
+			return ( m_msg.msg_flags & MSG_CTRUNC ) != 0;
+		}
+	};
+
+	using fd_passing_msg_ptr =
+	  std::unique_ptr<fd_passing_msg, pool_recycler<fd_passing_msg>>;
+
+	inline fd_passing_msg_ptr make_fd_passing_msg( ) {
+		return fd_passing_msg_ptr( object_pool<fd_passing_msg>::acquire( ) );
+	}
+} // namespace daw::details
@@ -0,0 +1,74 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined( __linux__ )
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace daw::details {
+	static_assert( sizeof( std::atomic<std::uint32_t> ) == sizeof( std::uint32_t ),
+	               "futex words must be plain 32bit integers" );
+
+	/***
+	 * Block while word still holds expected.  May return spuriously, callers
+	 * recheck their condition
+	 */
+	inline void futex_wait( std::atomic<std::uint32_t> &word,
+	                        std::uint32_t expected ) {
+#if defined( __linux__ )
+		(void)::syscall( SYS_futex, reinterpret_cast<std::uint32_t *>( &word ),
+		                 FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0 );
+#else
+		while( word.load( std::memory_order_acquire ) == expected ) {
+			std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+		}
+#endif
+	}
+
+	/// futex_wait giving up after rel_time
+	inline void futex_wait_for( std::atomic<std::uint32_t> &word,
+	                            std::uint32_t expected,
+	                            std::chrono::nanoseconds rel_time ) {
+		if( rel_time <= std::chrono::nanoseconds( 0 ) ) {
+			return;
+		}
+#if defined( __linux__ )
+		auto const secs = std::chrono::duration_cast<std::chrono::seconds>( rel_time );
+		auto ts = ::timespec{ };
+		ts.tv_sec = static_cast<::time_t>( secs.count( ) );
+		ts.tv_nsec = static_cast<long>( ( rel_time - secs ).count( ) );
+		(void)::syscall( SYS_futex, reinterpret_cast<std::uint32_t *>( &word ),
+		                 FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0 );
+#else
+		auto const deadline = std::chrono::steady_clock::now( ) + rel_time;
+		while( word.load( std::memory_order_acquire ) == expected and
+		       std::chrono::steady_clock::now( ) < deadline ) {
+			std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+		}
+#endif
+	}
+
+	/// Wake up to count threads blocked in futex_wait on word
+	inline void futex_wake( std::atomic<std::uint32_t> &word, int count = 1 ) {
+#if defined( __linux__ )
+		(void)::syscall( SYS_futex, reinterpret_cast<std::uint32_t *>( &word ),
+		                 FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0 );
+#else
+		(void)word;
+		(void)count;
+#endif
+	}
+} // namespace daw::details
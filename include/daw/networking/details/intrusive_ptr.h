@@ -0,0 +1,72 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace daw::details {
+	/***
+	 * Shared ownership of a T that counts its own references through
+	 * T::add_ref( ) and T::release( )
+	 */
+	template<typename T>
+	class intrusive_ptr {
+		T *m_ptr = nullptr;
+
+	public:
+		intrusive_ptr( ) = default;
+		intrusive_ptr( std::nullptr_t ) noexcept {}
+
+		explicit intrusive_ptr( T *ptr ) noexcept
+		  : m_ptr( ptr ) {
+			if( m_ptr ) {
+				m_ptr->add_ref( );
+			}
+		}
+
+		intrusive_ptr( intrusive_ptr const &other ) noexcept
+		  : intrusive_ptr( other.m_ptr ) {}
+
+		intrusive_ptr( intrusive_ptr &&other ) noexcept
+		  : m_ptr( std::exchange( other.m_ptr, nullptr ) ) {}
+
+		intrusive_ptr &operator=( intrusive_ptr const &rhs ) noexcept {
+			auto tmp = rhs;
+			std::swap( m_ptr, tmp.m_ptr );
+			return *this;
+		}
+
+		intrusive_ptr &operator=( intrusive_ptr &&rhs ) noexcept {
+			auto tmp = std::move( rhs );
+			std::swap( m_ptr, tmp.m_ptr );
+			return *this;
+		}
+
+		~intrusive_ptr( ) {
+			if( m_ptr ) {
+				m_ptr->release( );
+			}
+		}
+
+		T *get( ) const noexcept {
+			return m_ptr;
+		}
+
+		T &operator*( ) const noexcept {
+			return *m_ptr;
+		}
+
+		T *operator->( ) const noexcept {
+			return m_ptr;
+		}
+
+		explicit operator bool( ) const noexcept {
+			return m_ptr != nullptr;
+		}
+	};
+} // namespace daw::details
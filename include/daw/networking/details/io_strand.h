@@ -0,0 +1,327 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "../io_request.h"
+#include "ring_buffer.h"
+#include "timer_wheel.h"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace daw::details {
+	class io_strand;
+	class duplex_strand;
+
+	/***
+	 * Runs strands on its thread(s) and waits on their pending requests
+	 */
+	class io_scheduler {
+	public:
+		virtual ~io_scheduler( ) = default;
+
+		/// Queue the strand to run on the scheduler
+		virtual void post( std::shared_ptr<io_strand> strand ) = 0;
+
+		/// Queue the strand to be closed on the scheduler
+		virtual void post_close( std::shared_ptr<io_strand> strand ) = 0;
+
+		/***
+		 * Start the strand's pending request.  Returns the result when it finished
+		 * right away, otherwise the strand is parked and posted again once it can
+		 * continue
+		 */
+		virtual std::optional<::ssize_t> start( io_strand &strand ) = 0;
+
+		/***
+		 * Stop waiting for a parked strand that is being closed.  Returns false
+		 * when a completion can still arrive for it
+		 */
+		virtual bool cancel( io_strand &strand ) = 0;
+
+		/***
+		 * Finish a parked strand's request early, with -ECANCELED as its stop
+		 * was requested.  Called from any thread with the strand's lock held
+		 */
+		virtual void interrupt( io_strand &strand ) = 0;
+
+		virtual bool in_scheduler_thread( ) const = 0;
+	};
+
+	/***
+	 * Serializes the io tasks of one socket.  Only the task at the head runs and
+	 * while its request is outstanding the strand is parked with the scheduler.
+	 * All tasks run on the scheduler's thread(s), one at a time, though a
+	 * scheduler that steals work may resume a strand on a different thread
+	 */
+	class io_strand : public std::enable_shared_from_this<io_strand> {
+		io_scheduler *m_scheduler;
+		duplex_strand *m_owner;
+		std::size_t m_lane;
+		mutable std::mutex m_mutex{ };
+		mutable std::condition_variable m_idle{ };
+		ring_buffer<networking::io_task> m_tasks{ };
+		// The task being run.  It is moved out of m_tasks so that queueing more
+		// tasks, which can grow m_tasks, never moves it while it runs
+		networking::io_task m_head{ };
+		// Keeps the strand alive while it is parked
+		std::shared_ptr<io_strand> m_self{ };
+		networking::io_request m_request{ };
+		::ssize_t m_result = 0;
+		int m_scheduler_data = -1;
+		// The pending request's deadline, while the strand is parked
+		timer_node m_timer{ };
+		int m_running = 0;
+		bool m_active = false;
+		bool m_closed = false;
+
+		void leave( ring_buffer<networking::io_task> &dropped );
+		void drop_tasks( ring_buffer<networking::io_task> &dropped );
+
+	public:
+		/***
+		 * A strand that is a lane of owner tells it each time it runs out of
+		 * tasks
+		 */
+		explicit io_strand( io_scheduler &scheduler,
+		                    duplex_strand *owner = nullptr, std::size_t lane = 0 );
+
+		void add_io_task( networking::io_task tsk );
+		void wait( ) const;
+		void shutdown( );
+
+		/// Called by the scheduler to run the head task
+		void run( );
+
+		/// Called by the scheduler to drop all tasks
+		void close( );
+
+		/***
+		 * Called from any thread once a stop is requested on a token an io task
+		 * gave its requests.  Only the parked request that carries the stopped
+		 * token is interrupted, anything else is left to the task
+		 */
+		void interrupt( );
+
+		networking::io_request &request( ) {
+			return m_request;
+		}
+
+		duplex_strand *owner( ) const {
+			return m_owner;
+		}
+
+		std::size_t lane( ) const {
+			return m_lane;
+		}
+
+		/// Whether the strand has no task queued or running
+		bool idle( ) const;
+
+		/// Bookkeeping owned by the scheduler, e.g. the fd registered with epoll
+		int &scheduler_data( ) {
+			return m_scheduler_data;
+		}
+
+		/// Owned by the scheduler's strand_timers
+		timer_node &timer( ) {
+			return m_timer;
+		}
+
+		/***
+		 * Park the strand while arm registers it with the scheduler.  arm runs
+		 * under the strand's lock so a concurrent close either sees the
+		 * registration or prevents it.  arm returns 0 or -errno and the result is
+		 * returned, -ECANCELED when the strand is already closed
+		 */
+		template<typename Arm>
+		int park( Arm &&arm ) {
+			auto const lck = std::unique_lock( m_mutex );
+			if( m_closed ) {
+				return -ECANCELED;
+			}
+			m_self = shared_from_this( );
+			int const result = arm( );
+			if( result < 0 ) {
+				m_self.reset( );
+			}
+			return result;
+		}
+
+		std::shared_ptr<io_strand> unpark( );
+
+		/// Whether close( ) has run, a parked request must not be renewed after
+		bool closed( ) const;
+
+		/// Finish the pending request with result, for completion based schedulers
+		void complete( ::ssize_t result );
+	};
+
+	/***
+	 * The fd registration of a duplex_strand's lanes, for schedulers that can
+	 * wait on an fd only once, e.g. epoll.  waiters[lane] is the lane parked on
+	 * fd and events[lane] what it waits for
+	 */
+	struct shared_fd_wait {
+		std::mutex mutex{ };
+		int fd = -1;
+		std::array<io_strand *, 2> waiters{ };
+		std::array<std::uint32_t, 2> events{ };
+	};
+
+	/***
+	 * The read and write strands of one socket, on one scheduler.  Reads and
+	 * writes each run in order, independently of each other.  An exclusive
+	 * task, e.g. a connect or a close, waits for both strands to be idle and
+	 * runs on the write strand, and everything queued after it is held until
+	 * it is done
+	 */
+	class duplex_strand {
+	public:
+		enum class task_kind { read, write, exclusive };
+
+	private:
+		struct held_task {
+			networking::io_task task{ };
+			task_kind kind = task_kind::write;
+		};
+
+		std::array<std::shared_ptr<io_strand>, 2> m_lanes;
+		shared_fd_wait m_fd_wait{ };
+		mutable std::mutex m_mutex{ };
+		mutable std::condition_variable m_released{ };
+		ring_buffer<held_task> m_held{ };
+		// Set while tasks are held, lanes only lock to advance them then
+		std::atomic<bool> m_gated = false;
+		bool m_exclusive_running = false;
+		bool m_closed = false;
+
+		io_strand &lane( task_kind kind ) {
+			return *m_lanes[kind == task_kind::read ? 0 : 1];
+		}
+
+		void advance( );
+
+	public:
+		explicit duplex_strand( io_scheduler &scheduler );
+		~duplex_strand( );
+		duplex_strand( duplex_strand const & ) = delete;
+		duplex_strand &operator=( duplex_strand const & ) = delete;
+
+		void add_io_task( task_kind kind, networking::io_task tsk );
+
+		/// Interrupt either strand's parked request when its stop was requested
+		void interrupt( );
+
+		/// Wait for all queued tasks to finish
+		void wait( ) const;
+
+		/// Close both strands and cancel the tasks still held
+		void shutdown( );
+
+		shared_fd_wait &fd_wait( ) {
+			return m_fd_wait;
+		}
+
+		/// Called by a lane's runner, without its lock, once it has no tasks
+		void lane_idle( );
+	};
+
+	/***
+	 * The deadlines of a scheduler's parked strands.  A strand whose request
+	 * has a deadline is scheduled while it parks and released when it is
+	 * unparked, and the scheduler fails the ones that expire first with
+	 * -ETIMEDOUT.  Locked so strands parked from other threads, e.g. by a work
+	 * stealing thief, can be scheduled.  Nothing else is locked while the lock
+	 * is held
+	 */
+	class strand_timers {
+		mutable std::mutex m_mutex{ };
+		timer_wheel m_wheel{ };
+
+	public:
+		/// Called while the strand parks, before it can be unparked
+		void schedule( io_strand &strand ) {
+			auto const lck = std::unique_lock( m_mutex );
+			m_wheel.cancel( strand.timer( ) );
+			m_wheel.schedule( strand.timer( ), strand.request( ).deadline );
+		}
+
+		/***
+		 * Stop timing an unparked strand.  Returns whether its deadline had
+		 * already passed
+		 */
+		bool release( io_strand &strand ) {
+			auto const lck = std::unique_lock( m_mutex );
+			auto &timer = strand.timer( );
+			m_wheel.cancel( timer );
+			return std::exchange( timer.expired, false );
+		}
+
+		/***
+		 * Expire a parked strand's timer on the next expire( ), whether or not
+		 * it has a deadline.  The scheduler must be woken to see it
+		 */
+		void interrupt( io_strand &strand ) {
+			auto const lck = std::unique_lock( m_mutex );
+			// Already expired, it is being unparked
+			if( not strand.timer( ).expired ) {
+				m_wheel.expire_now( strand.timer( ) );
+			}
+		}
+
+		/// How long a scheduler may sleep before expire( ) has work, or -1
+		int wait_ms( ) const {
+			auto const lck = std::unique_lock( m_mutex );
+			return m_wheel.wait_ms( networking::io_clock::now( ) );
+		}
+
+		/***
+		 * Append the strands whose deadline has passed.  They are still parked,
+		 * and only the scheduler thread that unparks strands may call this
+		 */
+		void expire( std::vector<io_strand *> &expired ) {
+			auto const lck = std::unique_lock( m_mutex );
+			m_wheel.advance( networking::io_clock::now( ), [&]( timer_node &node ) {
+				expired.push_back( static_cast<io_strand *>( node.owner ) );
+			} );
+		}
+	};
+
+	/// The result of a parked request whose timer expired
+	inline ::ssize_t expired_result( networking::io_request const &req ) {
+		return req.stop_requested( ) ? -ECANCELED : -ETIMEDOUT;
+	}
+
+	/***
+	 * Strands posted to a single threaded scheduler, waiting to be run or closed
+	 */
+	class strand_queue {
+		mutable std::mutex m_mutex{ };
+		std::vector<std::shared_ptr<io_strand>> m_ready{ };
+		std::vector<std::shared_ptr<io_strand>> m_closing{ };
+
+	public:
+		/// Returns true when the queue was empty and the scheduler needs waking
+		bool push( std::shared_ptr<io_strand> strand );
+		bool push_close( std::shared_ptr<io_strand> strand );
+		bool empty( ) const;
+
+		/// Move everything posted onto the end of ready and closing
+		void take( std::vector<std::shared_ptr<io_strand>> &ready,
+		           std::vector<std::shared_ptr<io_strand>> &closing );
+	};
+} // namespace daw::details
@@ -0,0 +1,136 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "object_pool.h"
+
+#include <daw/daw_span.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace daw::details {
+	template<typename Span, typename T>
+	inline constexpr bool is_span_of_v = false;
+
+	template<typename U, typename T>
+	inline constexpr bool is_span_of_v<daw::span<U>, T> =
+	  std::is_convertible_v<U ( * )[], T ( * )[]>;
+
+	/***
+	 * Buffers is a range of daw::span's whose elements convert to T, e.g. a
+	 * std::vector<daw::span<char const>>.  Used to keep the scatter/gather
+	 * overloads from competing with the single buffer ones for containers
+	 * that convert to a span
+	 */
+	template<typename Buffers, typename T, typename = void>
+	inline constexpr bool is_buffer_sequence_v = false;
+
+	template<typename Buffers, typename T>
+	inline constexpr bool is_buffer_sequence_v<
+	  Buffers, T,
+	  std::void_t<decltype( std::begin( std::declval<Buffers const &>( ) ) ),
+	              decltype( std::end( std::declval<Buffers const &>( ) ) )>> =
+	  is_span_of_v<std::remove_cv_t<std::remove_reference_t<decltype(
+	                 *std::begin( std::declval<Buffers const &>( ) ) )>>,
+	               T>;
+
+	/***
+	 * The iovecs and msghdr of a scatter/gather operation.  The list of buffers
+	 * is copied so only the buffers themselves must outlive the operation.
+	 * advance( ) consumes bytes across buffer boundaries so a partial sendmsg or
+	 * recvmsg can be resumed with the same msghdr
+	 */
+	class io_vectors {
+		std::vector<::iovec> m_iov{ };
+		std::size_t m_first = 0;
+		::msghdr m_msg{ };
+
+	public:
+		template<typename Buffers>
+		void assign( Buffers const &buffers ) {
+			m_iov.clear( );
+			m_first = 0;
+			for( auto const &buff : buffers ) {
+				// An empty buffer would make an empty recvmsg look like end of stream
+				if( not buff.empty( ) ) {
+					m_iov.push_back( ::iovec{
+					  const_cast<void *>( static_cast<void const *>( buff.data( ) ) ),
+					  buff.size( ) } );
+				}
+			}
+		}
+
+		bool empty( ) const {
+			return m_first == m_iov.size( );
+		}
+
+		/***
+		 * The msghdr for the remaining buffers, at most IOV_MAX of them at a time
+		 */
+		::msghdr *msg( ) {
+			m_msg = ::msghdr{ };
+			m_msg.msg_iov = m_iov.data( ) + m_first;
+			m_msg.msg_iovlen = std::min<std::size_t>(
+			  m_iov.size( ) - m_first, static_cast<std::size_t>( IOV_MAX ) );
+			return &m_msg;
+		}
+
+		/***
+		 * Drop count bytes from the front, trimming a partially transferred
+		 * buffer.  Returns true when all the buffers have been consumed
+		 */
+		bool advance( std::size_t count ) {
+			while( count > 0 and m_first < m_iov.size( ) ) {
+				auto &vec = m_iov[m_first];
+				if( count < vec.iov_len ) {
+					vec.iov_base = static_cast<char *>( vec.iov_base ) + count;
+					vec.iov_len -= count;
+					break;
+				}
+				count -= vec.iov_len;
+				++m_first;
+			}
+			return empty( );
+		}
+
+		/// Forget the buffers but keep the storage for the next operation
+		void clear( ) {
+			m_iov.clear( );
+			m_first = 0;
+			m_msg = ::msghdr{ };
+		}
+	};
+
+	struct io_vectors_recycler {
+		void operator( )( io_vectors *vecs ) const {
+			vecs->clear( );
+			object_pool<io_vectors>::recycle( vecs );
+		}
+	};
+
+	/***
+	 * Owns pooled io_vectors, in the steady state a scatter/gather operation
+	 * reuses the iovec storage of a previous one
+	 */
+	using io_vectors_ptr = std::unique_ptr<io_vectors, io_vectors_recycler>;
+
+	template<typename Buffers>
+	io_vectors_ptr make_io_vectors( Buffers const &buffers ) {
+		auto result = io_vectors_ptr( object_pool<io_vectors>::acquire( ) );
+		result->assign( buffers );
+		return result;
+	}
+} // namespace daw::details
@@ -0,0 +1,109 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "object_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace daw::details {
+	/***
+	 * The mmsghdr array of a sendmmsg or recvmmsg batch, one buffer per
+	 * message.  The headers point at the caller's buffers and addresses, so
+	 * those must outlive the operation.  advance( ) skips the messages already
+	 * transferred so a partial sendmmsg resumes with the rest
+	 */
+	class mmsg_batch {
+		std::vector<::mmsghdr> m_msgs{ };
+		std::vector<::iovec> m_iov{ };
+		std::size_t m_first = 0;
+		::sockaddr_storage m_name{ };
+
+	public:
+		/// Most messages the kernel takes per call
+		static constexpr std::size_t max_batch = UIO_MAXIOV;
+
+		/// Make room for count messages with every field cleared
+		void reset( std::size_t count ) {
+			m_msgs.assign( count, ::mmsghdr{ } );
+			m_iov.assign( count, ::iovec{ } );
+			m_first = 0;
+		}
+
+		/***
+		 * Message idx transfers size bytes of data, to or from the address in
+		 * name.  A null name uses the connected peer
+		 */
+		void set( std::size_t idx, void const *data, std::size_t size, void *name,
+		          ::socklen_t name_len ) {
+			m_iov[idx] = ::iovec{ const_cast<void *>( data ), size };
+			auto &hdr = m_msgs[idx].msg_hdr;
+			hdr.msg_iov = &m_iov[idx];
+			hdr.msg_iovlen = 1;
+			hdr.msg_name = name;
+			hdr.msg_namelen = name ? name_len : 0;
+		}
+
+		/***
+		 * Copy an address into the batch, for a single message whose caller
+		 * does not keep the address around
+		 */
+		void *store_name( void const *name, ::socklen_t name_len ) {
+			std::memcpy( &m_name, name,
+			             std::min<std::size_t>( name_len, sizeof( m_name ) ) );
+			return &m_name;
+		}
+
+		::mmsghdr const &operator[]( std::size_t idx ) const {
+			return m_msgs[idx];
+		}
+
+		/// The messages not yet transferred
+		::mmsghdr *remaining( ) {
+			return m_msgs.data( ) + m_first;
+		}
+
+		std::size_t remaining_count( ) const {
+			return std::min( m_msgs.size( ) - m_first, max_batch );
+		}
+
+		/// Returns true when every message has been transferred
+		bool advance( std::size_t count ) {
+			m_first = std::min( m_first + count, m_msgs.size( ) );
+			return m_first == m_msgs.size( );
+		}
+
+		/// Forget the messages but keep the storage for the next batch
+		void clear( ) {
+			m_msgs.clear( );
+			m_iov.clear( );
+			m_first = 0;
+		}
+	};
+
+	struct mmsg_batch_recycler {
+		void operator( )( mmsg_batch *batch ) const {
+			batch->clear( );
+			object_pool<mmsg_batch>::recycle( batch );
+		}
+	};
+
+	/// Pooled so that steady state batches reuse the header storage
+	using mmsg_batch_ptr = std::unique_ptr<mmsg_batch, mmsg_batch_recycler>;
+
+	inline mmsg_batch_ptr make_mmsg_batch( std::size_t count ) {
+		auto result = mmsg_batch_ptr( object_pool<mmsg_batch>::acquire( ) );
+		result->reset( count );
+		return result;
+	}
+} // namespace daw::details
@@ -0,0 +1,236 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "futex.h"
+#include "ring_buffer.h"
+#include "third_party/stop_token.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace daw {
+	/***
+	 * Bounded lock free multi producer, single consumer queue.  Each slot of the
+	 * ring carries a sequence number, producers claim a slot with one CAS on
+	 * the tail and publish it by bumping its sequence.  The consumer only parks
+	 * on a futex when the queue is empty, and a producer only makes the wake
+	 * syscall when it sees the consumer parked, so pushing to a busy consumer
+	 * never enters the kernel.
+	 *
+	 * push waits for space when the ring is full.  The consumer cannot wait
+	 * for itself, so its pushes to a full ring go to a private overflow that is
+	 * popped in order with the ring, e.g. a task on a worker queueing more
+	 * tasks than the ring holds
+	 */
+	template<typename Data>
+	class mpsc_queue {
+		struct slot {
+			std::atomic<std::size_t> sequence;
+			alignas( Data ) unsigned char storage[sizeof( Data )];
+		};
+		// Pushed by the consumer while the ring was full.  pos is the tail at the
+		// time, the ring items before it are popped first
+		struct overflow_item {
+			std::size_t pos = 0;
+			Data data{ };
+		};
+		static constexpr std::size_t cache_line = 64;
+
+		std::unique_ptr<slot[]> m_slots;
+		std::size_t m_mask;
+		std::stop_token m_should_stop{ };
+		alignas( cache_line ) std::atomic<std::size_t> m_tail = 0;
+		// Only written by the consumer
+		alignas( cache_line ) std::atomic<std::size_t> m_head = 0;
+		alignas( cache_line ) std::atomic<std::uint32_t> m_parked = 0;
+		std::atomic<std::thread::id> m_consumer{ };
+		// Only used by the consumer
+		details::ring_buffer<overflow_item> m_overflow{ };
+
+		static std::size_t round_up( std::size_t capacity ) {
+			std::size_t result = 2;
+			while( result < capacity ) {
+				result *= 2;
+			}
+			return result;
+		}
+
+		void wake_consumer( ) {
+			// Pairs with the fence in wait_and_pop, either the consumer sees the
+			// new item or we see it parked
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			if( m_parked.load( std::memory_order_relaxed ) != 0 and
+			    m_parked.exchange( 0, std::memory_order_relaxed ) != 0 ) {
+				details::futex_wake( m_parked );
+			}
+		}
+
+		bool has_item( ) const {
+			auto const head = m_head.load( std::memory_order_relaxed );
+			return m_slots[head & m_mask].sequence.load(
+			         std::memory_order_acquire ) == head + 1;
+		}
+
+		/// Consumer only, whether the overflow's front is next
+		bool overflow_ready( ) {
+			return not m_overflow.empty( ) and
+			       m_overflow.front( ).pos <= m_head.load( std::memory_order_relaxed );
+		}
+
+		bool is_consumer( ) const {
+			return m_consumer.load( std::memory_order_relaxed ) ==
+			       std::this_thread::get_id( );
+		}
+
+	public:
+		explicit mpsc_queue( std::size_t capacity = 4096 )
+		  : m_slots( std::make_unique<slot[]>( round_up( capacity ) ) )
+		  , m_mask( round_up( capacity ) - 1 ) {
+			for( std::size_t n = 0; n <= m_mask; ++n ) {
+				m_slots[n].sequence.store( n, std::memory_order_relaxed );
+			}
+		}
+
+		mpsc_queue( std::stop_token should_stop, std::size_t capacity = 4096 )
+		  : mpsc_queue( capacity ) {
+			m_should_stop = std::move( should_stop );
+		}
+
+		~mpsc_queue( ) {
+			clear( );
+		}
+
+		mpsc_queue( mpsc_queue const & ) = delete;
+		mpsc_queue &operator=( mpsc_queue const & ) = delete;
+
+		/***
+		 * Returns false, leaving data untouched, when the queue is full
+		 */
+		bool try_push( Data &&data ) {
+			auto pos = m_tail.load( std::memory_order_relaxed );
+			slot *s = nullptr;
+			while( true ) {
+				s = &m_slots[pos & m_mask];
+				auto const seq = s->sequence.load( std::memory_order_acquire );
+				auto const diff = static_cast<std::ptrdiff_t>( seq - pos );
+				if( diff == 0 ) {
+					if( m_tail.compare_exchange_weak( pos, pos + 1,
+					                                  std::memory_order_relaxed ) ) {
+						break;
+					}
+				} else if( diff < 0 ) {
+					return false;
+				} else {
+					pos = m_tail.load( std::memory_order_relaxed );
+				}
+			}
+			::new( static_cast<void *>( s->storage ) ) Data( std::move( data ) );
+			s->sequence.store( pos + 1, std::memory_order_release );
+			wake_consumer( );
+			return true;
+		}
+
+		/***
+		 * Waits for space when the ring is full, except on the consumer's thread
+		 * where the item goes to the overflow.  Once it has, the consumer's later
+		 * pushes follow it there to stay in order
+		 */
+		void push( Data &&data ) {
+			if( is_consumer( ) ) {
+				if( m_overflow.empty( ) and try_push( std::move( data ) ) ) {
+					return;
+				}
+				m_overflow.push_back( overflow_item{
+				  m_tail.load( std::memory_order_relaxed ), std::move( data ) } );
+				return;
+			}
+			while( not try_push( std::move( data ) ) ) {
+				std::this_thread::yield( );
+			}
+		}
+
+		void push( Data const &data ) {
+			push( Data( data ) );
+		}
+
+		/// On the consumer's thread this includes its overflow
+		bool empty( ) const {
+			return not has_item( ) and ( not is_consumer( ) or m_overflow.empty( ) );
+		}
+
+		/// Consumer only, the thread that calls it is taken to be the consumer
+		std::optional<Data> try_pop( ) {
+			if( not is_consumer( ) ) {
+				m_consumer.store( std::this_thread::get_id( ),
+				                  std::memory_order_relaxed );
+			}
+			if( overflow_ready( ) ) {
+				return std::optional<Data>( std::move( m_overflow.pop_front( ).data ) );
+			}
+			auto const head = m_head.load( std::memory_order_relaxed );
+			auto &s = m_slots[head & m_mask];
+			if( s.sequence.load( std::memory_order_acquire ) != head + 1 ) {
+				return { };
+			}
+			auto *item = std::launder( reinterpret_cast<Data *>( s.storage ) );
+			auto result = std::optional<Data>( std::move( *item ) );
+			item->~Data( );
+			s.sequence.store( head + m_mask + 1, std::memory_order_release );
+			m_head.store( head + 1, std::memory_order_relaxed );
+			return result;
+		}
+
+		/***
+		 * Consumer only.  Parks until an item arrives or a stop is requested, an
+		 * empty result means stop
+		 */
+		std::optional<Data> wait_and_pop( std::stop_token const &should_stop ) {
+			while( not should_stop.stop_requested( ) ) {
+				if( auto result = try_pop( ) ) {
+					return result;
+				}
+				m_parked.store( 1, std::memory_order_relaxed );
+				std::atomic_thread_fence( std::memory_order_seq_cst );
+				if( should_stop.stop_requested( ) or has_item( ) or
+				    overflow_ready( ) ) {
+					m_parked.store( 0, std::memory_order_relaxed );
+					continue;
+				}
+				details::futex_wait( m_parked, 1 );
+			}
+			return { };
+		}
+
+		std::optional<Data> wait_and_pop( ) {
+			return wait_and_pop( m_should_stop );
+		}
+
+		/// Consumer only, or when no consumer is running
+		void clear( ) {
+			while( try_pop( ) ) {}
+		}
+
+		/// Must not be called while the consumer is running
+		void reset( std::stop_token should_stop ) {
+			clear( );
+			m_should_stop = std::move( should_stop );
+		}
+
+		/// Wake a parked consumer so it can observe a stop request
+		void notify_all( ) {
+			m_parked.store( 0, std::memory_order_seq_cst );
+			details::futex_wake( m_parked );
+		}
+	}; // class mpsc_queue
+} // namespace daw
@@ -9,36 +9,56 @@
 #include "../../../third_party/jthread.hpp"
 #include "../async_exec_policy_thread.h"
 #include "../async_result.h"
+#include "../dns_resolver.h"
+#include "../io_request.h"
 #include "../network_exception.h"
+#include "../socket_address.h"
+#include "../socket_options.h"
+#include "fd_passing.h"
+#include "io_vectors.h"
+#include "object_pool.h"
+#include "wakeup_fd.h"
+#include "write_batch.h"
+
+#if defined( __linux__ )
+#include "../async_exec_policy_epoll.h"
+#include "../async_exec_policy_pool.h"
+#include "../async_exec_policy_uring.h"
+#include "connect_race.h"
+#include "mmsg_batch.h"
+#include "udp_segments.h"
+#include "zerocopy.h"
+#endif
 
 #include <daw/daw_exception.h>
 #include <daw/daw_span.h>
+#include <daw/daw_utility.h>
 #include <daw/parallel/daw_shared_mutex.h>
 
+#include <algorithm>
 #include <arpa/inet.h>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
+#include <cstddef>
 #include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <optional>
+#include <poll.h>
+#include <string>
+#include <string_view>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <unistd.h>
+#include <utility>
 
 namespace daw::networking {
-	enum class socket_types : int {
-		Stream = SOCK_STREAM,
-		Dgram = SOCK_DGRAM,
-		Raw = SOCK_RAW
-	};
-
-	enum class address_family : int {
-		Unspecified = AF_UNSPEC,
-		Unix = AF_UNIX,
-		IPv4 = AF_INET,
-		IPv6 = AF_INET6
-	};
-
 	enum class shutdown_how : int {
 		DisallowReceive = 0,
 		DisallowSend = 1,
@@ -88,19 +108,322 @@ namespace daw::networking {
 		}
 	};
 
+	/***
+	 * A datagram to send to peer, or to the connected address when peer is
+	 * empty
+	 */
+	struct outgoing_datagram {
+		daw::span<char const> data{ };
+		socket_address peer{ };
+	};
+
+	/// Room for a received datagram, size, peer and truncated are filled in
+	struct datagram {
+		daw::span<char> buffer{ };
+		socket_address peer{ };
+		std::size_t size = 0;
+		// The datagram was larger than buffer and the rest was dropped
+		bool truncated = false;
+	};
+
+	/// The result of receiving data along with file descriptors
+	struct received_fds {
+		std::size_t size = 0;
+		// The descriptors received, a prefix of the caller's span.  The receiver
+		// owns them
+		daw::span<int> fds{ };
+		// More descriptors were sent than fit and the rest were closed
+		bool truncated = false;
+	};
+
+	/***
+	 * Datagrams received in one coalesced read.  They lie back to back in data,
+	 * every one segment_size bytes except the last which can be shorter
+	 */
+	struct datagram_segments {
+		daw::span<char> data{ };
+		std::size_t segment_size = 0;
+		socket_address peer{ };
+
+		/// The count of datagrams
+		std::size_t size( ) const {
+			return segment_size == 0
+			         ? 0
+			         : ( data.size( ) + segment_size - 1 ) / segment_size;
+		}
+
+		/// The datagram at idx, a view into data
+		daw::span<char> operator[]( std::size_t idx ) const {
+			auto const first = idx * segment_size;
+			return data.subspan( first,
+			                     std::min( segment_size, data.size( ) - first ) );
+		}
+	};
+
+	namespace details {
+		/***
+		 * Closes the fd it refers to, when open, on destruction
+		 */
+		class fd_closer {
+			int const *m_fd;
+
+		public:
+			explicit fd_closer( int const &fd )
+			  : m_fd( &fd ) {}
+
+			fd_closer( fd_closer const & ) = delete;
+			fd_closer &operator=( fd_closer const & ) = delete;
+
+			~fd_closer( ) {
+				if( *m_fd >= 0 ) {
+					(void)::close( *m_fd );
+				}
+			}
+		};
+
+		/***
+		 * Owns an fd until release( ) hands it on, closing it if that never
+		 * happens, e.g. when the code taking it over throws first
+		 */
+		class owned_fd {
+			int m_fd;
+
+		public:
+			explicit owned_fd( int fd )
+			  : m_fd( fd ) {}
+
+			owned_fd( owned_fd const & ) = delete;
+			owned_fd &operator=( owned_fd const & ) = delete;
+
+			~owned_fd( ) {
+				if( m_fd >= 0 ) {
+					(void)::close( m_fd );
+				}
+			}
+
+			int get( ) const {
+				return m_fd;
+			}
+
+			int release( ) {
+				return std::exchange( m_fd, -1 );
+			}
+		};
+
+		/***
+		 * Owns a batch of fds, e.g. one batch of accepted connections, and
+		 * hands them on in order with take( ).  The ones not taken yet are
+		 * closed with it, so an exception partway through leaks none
+		 */
+		class owned_fds {
+			daw::span<int const> m_fds;
+			std::size_t m_taken = 0;
+
+		public:
+			explicit owned_fds( daw::span<int const> fds )
+			  : m_fds( fds ) {}
+
+			owned_fds( owned_fds const & ) = delete;
+			owned_fds &operator=( owned_fds const & ) = delete;
+
+			~owned_fds( ) {
+				for( ; m_taken < m_fds.size( ); ++m_taken ) {
+					(void)::close( m_fds[m_taken] );
+				}
+			}
+
+			bool empty( ) const {
+				return m_taken == m_fds.size( );
+			}
+
+			/// The next fd, the caller owns it from now on
+			owned_fd take( ) {
+				return owned_fd( m_fds[m_taken++] );
+			}
+		};
+	} // namespace details
+
+	namespace details {
+		/***
+		 * The stop token of a running operation and the callback that has the
+		 * exec policy interrupt the operation's parked request.  On the heap so
+		 * the token its requests point to stays put
+		 */
+		template<typename ExecPolicy>
+		struct operation_stop {
+			struct interrupter {
+				ExecPolicy *exec;
+
+				void operator( )( ) const {
+					exec->interrupt( );
+				}
+			};
+
+			std::stop_token token;
+			std::stop_callback<interrupter> on_stop;
+
+			operation_stop( std::stop_token stop, ExecPolicy &exec )
+			  : token( std::move( stop ) )
+			  , on_stop( token, interrupter{ &exec } ) {}
+		};
+
+		struct socket_address_recycler {
+			void operator( )( socket_address *address ) const {
+				*address = socket_address( );
+				::daw::details::object_pool<socket_address>::recycle( address );
+			}
+		};
+
+		/***
+		 * A connect's address.  The connect request points at it, so it stays
+		 * put while the task moves, and pooled so a connect does not allocate
+		 */
+		using socket_address_ptr =
+		  std::unique_ptr<socket_address, socket_address_recycler>;
+
+		inline socket_address_ptr
+		make_socket_address( socket_address const &address ) {
+			auto result = socket_address_ptr(
+			  ::daw::details::object_pool<socket_address>::acquire( ) );
+			*result = address;
+			return result;
+		}
+	} // namespace details
+
+	/***
+	 * Takes ownership of an already open socket, e.g. an accepted connection.
+	 * The fd stays with the caller when the constructor taking it throws
+	 */
+	struct adopt_socket {
+		int fd;
+	};
+
+	/***
+	 * Receives and accepts run in order on the exec policy's read strand and
+	 * the other operations in order on its write strand, so a pending receive
+	 * does not hold up a send.  Connects and closes wait for both strands
+	 */
 	template<typename ExecPolicy>
 	struct basic_network_socket {
 		using async_exec_policy = ExecPolicy;
-		async_exec_policy m_exec{ };
-		std::mutex m_mutex{ };
 		int m_socket = -1;
+		// Declared ahead of m_exec so an open socket is only closed after the exec
+		// policy has stopped running tasks that use it
+		details::fd_closer m_closer{ m_socket };
+		async_exec_policy m_exec;
+		mutable std::mutex m_mutex{ };
+		// Orders the read strand's operations, taken after m_mutex
+		std::mutex m_read_mutex{ };
 		address_family m_family;
 		socket_types m_socket_type;
-		void connect_impl( std::string host, std::uint16_t port );
+		// Sequence number of the next MSG_ZEROCOPY send, only used by io tasks.
+		// Like the enabled flags it belongs to the open fd, every fd is opened
+		// after close_socket( ) resets them
+		std::uint32_t m_zerocopy_next = 0;
+		bool m_zerocopy_enabled = false;
+		bool m_gro_enabled = false;
+		// The resolver for connects by name, dns_resolver::system( ) when null
+		dns_resolver *m_resolver = nullptr;
+		// Set on every fd the socket opens, including connect race attempts
+		socket_option_list m_options{ };
+		bool m_coalesce_writes = false;
+		// The batch coalesced writes join while its flush task runs
+		std::shared_ptr<details::write_batch> m_write_batch{ };
+		// How long each operation may take once it starts, zero for no limit
+		std::atomic<std::chrono::milliseconds> m_timeout{ };
+
+		address_info resolve( std::string const &host, std::uint16_t port,
+		                      int flags = 0 ) const;
+		dns_resolver &resolver( ) const {
+			return m_resolver ? *m_resolver : dns_resolver::system( );
+		}
+		io_request connect_impl( socket_address const &address );
+		void close_socket( );
+		async_result<void>
+		connect_address_async( socket_address address,
+		                       std::function<void( )> on_completion,
+		                       std::stop_token stop );
+		async_result<void>
+		connect_host_async( std::string_view host, std::uint16_t port,
+		                    std::function<void( )> on_completion,
+		                    std::stop_token stop,
+		                    std::optional<std::chrono::milliseconds> attempt_delay =
+		                      std::nullopt );
+		void finish_connect( ::ssize_t result );
+		async_result<void> send_vectors( ::daw::details::io_vectors_ptr vecs,
+		                                 int flags, std::stop_token stop );
+		async_result<void> send_coalesced( daw::span<char const> buffer,
+		                                   int flags );
+		void end_write_batch( );
+		template<typename Task>
+		io_task make_io_op( async_exec_policy &exec, Task &&task,
+		                    std::stop_token stop );
+		template<typename Task>
+		void queue_read_task( Task &&task, std::stop_token stop = { } );
+		template<typename Task>
+		void queue_write_task( Task &&task, std::stop_token stop = { } );
+		template<typename Task>
+		void queue_exclusive_task( Task &&task, std::stop_token stop = { } );
+		void apply_timeout( io_request &req ) const;
+		int apply_options( int fd ) const;
+		void set_raw_option( raw_socket_option option );
+		async_result<std::size_t>
+		receive_vectors( ::daw::details::io_vectors_ptr vecs, int flags,
+		                 std::stop_token stop );
+		int enable_zerocopy( );
+		int enable_gro( );
 
 	public:
-		basic_network_socket( address_family af, socket_types st );
+		/***
+		 * Any trailing arguments construct the exec policy, e.g. the reactor the
+		 * socket runs on
+		 */
+		template<typename... ExecArgs>
+		basic_network_socket( address_family af, socket_types st,
+		                      ExecArgs &&...exec_args );
+
+		template<typename... ExecArgs>
+		basic_network_socket( adopt_socket sock, address_family af, socket_types st,
+		                      ExecArgs &&...exec_args );
+
+		basic_network_socket( basic_network_socket const & ) = delete;
+		basic_network_socket &operator=( basic_network_socket const & ) = delete;
+
+		/***
+		 * Open the socket and bind it to an address of host, or to every local
+		 * address when host is empty.  reuse_port sets SO_REUSEPORT so several
+		 * sockets can bind the same port and have the kernel spread incoming
+		 * connections across them.  A Unix domain socket binds the path in host
+		 * and ignores port
+		 */
+		void bind( std::string_view host, std::uint16_t port,
+		           bool reuse_port = false );
+
+		/***
+		 * Open the socket and bind it to address, e.g. a Unix domain path.  A
+		 * filesystem path must not exist yet
+		 */
+		void bind( socket_address const &address );
+		void listen( int backlog = SOMAXCONN );
+
+		/// The port the socket is bound to, e.g. the one picked for port 0
+		[[nodiscard]] std::uint16_t local_port( ) const;
+
+		/// The address family.  A bind by name sets it to the bound address's
+		[[nodiscard]] address_family family( ) const {
+			auto const lck = std::unique_lock( m_mutex );
+			return m_family;
+		}
+
+		/// A Unix domain socket connects to the path in host and ignores port
 		void connect( std::string_view host, std::uint16_t port );
+		void connect( socket_address const &address );
+
+		/***
+		 * Open the socket, when it is not already, without binding or
+		 * connecting it.  e.g. to send datagrams with send_to_async
+		 */
+		void open( );
 		void close( );
 		int shutdown( shutdown_how how );
 
@@ -113,25 +436,296 @@ namespace daw::networking {
 			return m_socket >= 0;
 		}
 
-		[[nodiscard]] async_result<void> connect_async( std::string_view host,
-		                                                std::uint16_t port );
+		/***
+		 * Set option now when the socket is open, and on the fd of every later
+		 * connect, bind or open.  Set options before starting a connect or
+		 * after it completes, not while it runs
+		 */
+		template<typename Option,
+		         std::enable_if_t<is_socket_option_v<Option>, std::nullptr_t> =
+		           nullptr>
+		void set_option( Option const &option ) {
+			set_raw_option( option.raw( ) );
+		}
 
+		/// set_option for each of options, e.g. a socket_profiles set
+		void set_options( socket_option_list const &options ) {
+			for( auto const &option : options ) {
+				set_raw_option( option );
+			}
+		}
+
+		/// The current value of Option on the open socket
+		template<typename Option,
+		         std::enable_if_t<is_socket_option_v<Option>, std::nullptr_t> =
+		           nullptr>
+		[[nodiscard]] typename Option::value_type get_option( ) const {
+			auto const lck = std::unique_lock( m_mutex );
+			int value = 0;
+			auto len = static_cast<::socklen_t>( sizeof( value ) );
+			if( ::getsockopt( m_socket, Option::level, Option::name, &value, &len ) <
+			    0 ) {
+				throw network_exception( "Error getting socket option", errno );
+			}
+			return Option::from_raw( value );
+		}
+
+		/***
+		 * Whether an idle connection can still be used.  It must be open with no
+		 * error, hang up or unread data waiting, as data on an idle connection is
+		 * either the peer closing or outside of the protocol
+		 */
+		bool is_alive( ) const {
+			auto const lck = std::unique_lock( m_mutex );
+			if( m_socket < 0 ) {
+				return false;
+			}
+			auto pfd = ::pollfd{ m_socket, POLLIN, 0 };
+			return ::poll( &pfd, 1, 0 ) == 0;
+		}
+
+		/***
+		 * The *_async operations, except send_zerocopy_async and the callback
+		 * forms, take a trailing stop token.  Requesting a stop fails the
+		 * operation with ECANCELED whether it is queued or waiting on the fd,
+		 * and the socket's other operations carry on.  A stream may have sent
+		 * or received part of it already
+		 */
 		[[nodiscard]] async_result<void>
 		connect_async( std::string_view host, std::uint16_t port,
-		               std::function<void( )> on_completion );
+		               std::stop_token stop = { } );
+
+		[[nodiscard]] async_result<void>
+		connect_async( std::string_view host, std::uint16_t port,
+		               std::function<void( )> on_completion,
+		               std::stop_token stop = { } );
+
+		[[nodiscard]] async_result<void>
+		connect_async( socket_address const &address, std::stop_token stop = { } );
+
+		/***
+		 * Connect to whichever address of host answers first, Happy Eyeballs
+		 * style.  Attempts alternate between IPv6 and IPv4 and a new one starts
+		 * every attempt_delay, or right after one fails, without abandoning the
+		 * earlier ones.  A dead first address then costs attempt_delay rather
+		 * than a full connect timeout.  Only the first address is tried outside
+		 * of Linux
+		 */
+		[[nodiscard]] async_result<void>
+		connect_any_async( std::string_view host, std::uint16_t port,
+		                   std::chrono::milliseconds attempt_delay =
+		                     std::chrono::milliseconds( 250 ),
+		                   std::stop_token stop = { } );
+
+		/***
+		 * Resolve names with resolver for later connects instead of
+		 * dns_resolver::system( ).  It must outlive the socket
+		 */
+		void set_resolver( dns_resolver &resolver ) {
+			auto const lck = std::unique_lock( m_mutex );
+			m_resolver = &resolver;
+		}
+
+		/***
+		 * While on, send_async( buffer ) calls made while earlier ones are still
+		 * in flight join them in a single sendmsg, turning many small sends from
+		 * many threads into a few large ones.  Each still completes on its own.
+		 * Other sends are ordered after the writes queued before them.  Only
+		 * stream sockets can coalesce
+		 */
+		void set_write_coalescing( bool enabled ) {
+			auto const lck = std::unique_lock( m_mutex );
+			if( enabled and m_socket_type != socket_types::Stream ) {
+				throw network_exception( "Write coalescing needs a stream socket",
+				                         EINVAL );
+			}
+			m_coalesce_writes = enabled;
+			if( not enabled ) {
+				end_write_batch( );
+			}
+		}
+
+		/***
+		 * Fail each operation that has not finished within timeout of starting
+		 * with a network_exception carrying ETIMEDOUT, zero to wait forever.
+		 * Time spent queued behind the socket's earlier operations does not
+		 * count.  The executor drops the operation and the socket stays usable,
+		 * though a stream may have sent or received part of it
+		 */
+		void set_timeout( std::chrono::milliseconds timeout ) {
+			m_timeout = std::max( timeout, std::chrono::milliseconds( 0 ) );
+		}
 
 		[[nodiscard]] async_result<void> close_async( );
 
+		/***
+		 * Accept connections on a listening socket until on_accepted returns
+		 * false.  Each wakeup drains the backlog into fds and hands the batch of
+		 * new nonblocking sockets to on_accepted, which takes ownership of them.
+		 * fds must outlive the operation
+		 */
+		async_result<void>
+		accept_async( daw::span<int> fds,
+		              std::function<bool( daw::span<int const> )> on_accepted,
+		              std::stop_token stop = { } );
+
+		/// A single send, which can be partial, queued behind the earlier ones
 		[[nodiscard]] std::size_t send( daw::span<char const> buffer,
 		                                int flags = 0 );
 
-		[[nodiscard]] async_result<void> send_async( daw::span<char const> buffer,
-		                                             int flags = 0 );
+		/***
+		 * A single send of buffer, completing with the count of bytes the socket
+		 * took
+		 */
+		[[nodiscard]] async_result<std::size_t>
+		send_some_async( daw::span<char const> buffer, int flags = 0,
+		                 std::stop_token stop = { } );
+
+		/***
+		 * Send buffer with the descriptors in fds over a Unix domain socket, the
+		 * receiver gets its own copies of them.  buffer must not be empty and at
+		 * most fd_passing_msg::max_fds go per call.  Stream sockets can send part
+		 * of buffer, the result is the count of bytes sent, and the descriptors
+		 * go with the first byte
+		 */
+		[[nodiscard]] async_result<std::size_t>
+		send_fds_async( daw::span<char const> buffer, daw::span<int const> fds,
+		                int flags = 0, std::stop_token stop = { } );
+
+		/***
+		 * Receive data into buffer and any descriptors sent with it into fds, as
+		 * close on exec descriptors
+		 */
+		[[nodiscard]] async_result<received_fds>
+		receive_fds_async( daw::span<char> buffer, daw::span<int> fds,
+		                   int flags = 0, std::stop_token stop = { } );
+
+		/// Not coalesced when given a stop token
+		[[nodiscard]] async_result<void>
+		send_async( daw::span<char const> buffer, int flags = 0,
+		            std::stop_token stop = { } );
+
+		/***
+		 * Send all the buffers, a range of daw::span<char const>, in order with
+		 * as few sendmsg calls as the socket allows.  The buffers must outlive
+		 * the operation, the range of them need not
+		 */
+		template<typename Buffers,
+		         std::enable_if_t<
+		           ::daw::details::is_buffer_sequence_v<Buffers, char const>,
+		           std::nullptr_t> = nullptr>
+		[[nodiscard]] async_result<void> send_async( Buffers const &buffers,
+		                                             int flags = 0,
+		                                             std::stop_token stop = { } ) {
+			return send_vectors( ::daw::details::make_io_vectors( buffers ), flags,
+			                     std::move( stop ) );
+		}
+
+#if defined( __linux__ )
+		/***
+		 * Send the buffer with MSG_ZEROCOPY, the kernel reads it in place instead
+		 * of copying it.  The result completes once the kernel has released the
+		 * buffer and it can be reused, later operations on the socket wait until
+		 * then.  The socket's timeout only limits the sending, waiting for the
+		 * release is not cut short even when the send failed part way.
+		 * Worthwhile for large buffers only, loopback and some devices copy
+		 * anyway
+		 */
+		[[nodiscard]] async_result<void>
+		send_zerocopy_async( daw::span<char const> buffer, int flags = 0 );
+
+		/***
+		 * Send count bytes of the file fd starting at offset with sendfile.  The
+		 * result is the count sent, less than count when the file ends first
+		 */
+		[[nodiscard]] async_result<std::size_t>
+		send_file_async( int fd, ::off_t offset, std::size_t count,
+		                 std::stop_token stop = { } );
+#endif
+
+#if defined( __linux__ )
+		/***
+		 * Send the datagrams with as few sendmmsg calls as possible.  The
+		 * datagrams must outlive the operation.  The result is the count sent
+		 */
+		[[nodiscard]] async_result<std::size_t>
+		send_batch_async( daw::span<outgoing_datagram const> datagrams,
+		                  int flags = 0, std::stop_token stop = { } );
+
+		/***
+		 * Receive between 1 and datagrams.size( ) datagrams with one recvmmsg,
+		 * waiting until at least one is available.  The datagrams must outlive
+		 * the operation.  The result is the count received
+		 */
+		[[nodiscard]] async_result<std::size_t>
+		receive_batch_async( daw::span<datagram> datagrams, int flags = 0,
+		                     std::stop_token stop = { } );
+
+		/// Send one datagram to peer
+		[[nodiscard]] async_result<void>
+		send_to_async( daw::span<char const> buffer, socket_address const &peer,
+		               int flags = 0, std::stop_token stop = { } );
+
+		/***
+		 * Send buffer as datagrams of segment_size bytes, the last one can be
+		 * shorter, to peer or the connected address when peer is empty.  UDP GSO
+		 * lets the kernel split up to 64 of them out of one sendmsg
+		 */
+		[[nodiscard]] async_result<void>
+		send_segments_async( daw::span<char const> buffer,
+		                     std::uint16_t segment_size,
+		                     socket_address const &peer = { }, int flags = 0,
+		                     std::stop_token stop = { } );
+
+		/***
+		 * Receive with UDP GRO, turning it on for the socket first.  Datagrams
+		 * of the same size from one sender can arrive coalesced in one read and
+		 * the result views them in place.  buffer should hold 64KiB so a
+		 * coalesced read is not truncated
+		 */
+		[[nodiscard]] async_result<datagram_segments>
+		receive_segments_async( daw::span<char> buffer, int flags = 0,
+		                        std::stop_token stop = { } );
 
+		/***
+		 * Receive one datagram into buffer and its sender into peer, both must
+		 * outlive the operation.  The result is the datagram's size, bytes that
+		 * did not fit are dropped
+		 */
+		[[nodiscard]] async_result<std::size_t>
+		receive_from_async( daw::span<char> buffer, socket_address &peer,
+		                    int flags = 0, std::stop_token stop = { } );
+#endif
+
+		/// A single receive queued behind the earlier ones
 		[[nodiscard]] std::size_t receive( daw::span<char> buffer, int flags = 0 );
 
 		[[nodiscard]] async_result<std::size_t>
-		receive_async( daw::span<char> buffer, int flags = 0 );
+		receive_async( daw::span<char> buffer, int flags = 0,
+		               std::stop_token stop = { } );
+
+		/***
+		 * A single receive into buffer, completing with whatever arrived, 0 when
+		 * the peer closed the connection
+		 */
+		[[nodiscard]] async_result<std::size_t>
+		receive_some_async( daw::span<char> buffer, int flags = 0,
+		                    std::stop_token stop = { } );
+
+		/***
+		 * Fills the buffers, a range of daw::span<char>, in order.  Completes
+		 * early with the count received when the peer closes the connection
+		 */
+		template<
+		  typename Buffers,
+		  std::enable_if_t<::daw::details::is_buffer_sequence_v<Buffers, char>,
+		                   std::nullptr_t> = nullptr>
+		[[nodiscard]] async_result<std::size_t>
+		receive_async( Buffers const &buffers, int flags = 0,
+		               std::stop_token stop = { } ) {
+			return receive_vectors( ::daw::details::make_io_vectors( buffers ), flags,
+			                        std::move( stop ) );
+		}
 
 		async_result<void> receive_async(
 		  daw::span<char> buffer,
@@ -150,152 +744,737 @@ namespace daw::networking {
 
 	using network_socket = basic_network_socket<async_exec_policy_thread>;
 
+#if defined( __linux__ )
+	using epoll_network_socket = basic_network_socket<async_exec_policy_epoll>;
+	using uring_network_socket = basic_network_socket<async_exec_policy_uring>;
+	using pool_network_socket = basic_network_socket<async_exec_policy_pool>;
+#endif
+
 	template<typename ExecPolicy>
-	void basic_network_socket<ExecPolicy>::connect_impl( std::string host,
-	                                                     std::uint16_t port ) {
+	address_info
+	basic_network_socket<ExecPolicy>::resolve( std::string const &host,
+	                                           std::uint16_t port,
+	                                           int flags ) const {
 		auto const port_str = std::to_string( port );
 		auto hints = ::addrinfo( );
 		hints.ai_family = static_cast<int>( m_family );
 		hints.ai_socktype = static_cast<int>( m_socket_type );
+		hints.ai_flags = flags;
 		auto res = address_info( );
-		if( getaddrinfo( host.c_str( ), port_str.c_str( ), &hints,
-		                 &res.m_addresses ) < 0 ) {
-			throw network_exception( "Error resolving addresses", errno );
+		// getaddrinfo returns an EAI_* code, errno only means something for
+		// EAI_SYSTEM
+		if( int const rc = getaddrinfo( host.empty( ) ? nullptr : host.c_str( ),
+		                                port_str.c_str( ), &hints,
+		                                &res.m_addresses );
+		    rc != 0 ) {
+			throw network_exception( "Error resolving addresses",
+			                         rc == EAI_SYSTEM ? errno : rc );
 		}
-		m_socket = ::socket( res->ai_family, res->ai_socktype, res->ai_protocol );
+		return res;
+	}
+
+	/***
+	 * Opens a nonblocking socket for the address and returns the connect
+	 * request for the exec policy to complete
+	 */
+	template<typename ExecPolicy>
+	io_request basic_network_socket<ExecPolicy>::connect_impl(
+	  socket_address const &address ) {
+		m_socket = ::socket( address.storage.ss_family,
+		                     static_cast<int>( m_socket_type ) | SOCK_NONBLOCK |
+		                       SOCK_CLOEXEC,
+		                     0 );
 		if( m_socket < 0 ) {
 			throw network_exception( "Error creating socket", errno );
 		}
+		if( int const err = apply_options( m_socket ); err != 0 ) {
+			close_socket( );
+			throw network_exception( "Error setting socket option", err );
+		}
+		return io_request::connect( m_socket, address.data( ), address.size );
+	}
 
-		if( ::connect( m_socket, res->ai_addr, res->ai_addrlen ) < 0 ) {
-			(void)::close( m_socket );
-			throw network_exception( "error connecting", errno );
+	/***
+	 * A new fd has SO_ZEROCOPY and UDP_GRO off and the kernel numbers its
+	 * zerocopy sends from 0
+	 */
+	template<typename ExecPolicy>
+	void basic_network_socket<ExecPolicy>::close_socket( ) {
+		(void)::close( m_socket );
+		m_socket = -1;
+		m_zerocopy_next = 0;
+		m_zerocopy_enabled = false;
+		m_gro_enabled = false;
+	}
+
+	template<typename ExecPolicy>
+	void basic_network_socket<ExecPolicy>::finish_connect( ::ssize_t result ) {
+		if( result < 0 ) {
+			close_socket( );
+			throw network_exception( "error connecting",
+			                         static_cast<long long>( -result ) );
 		}
 	}
 
 	template<typename ExecPolicy>
 	void basic_network_socket<ExecPolicy>::connect( std::string_view host,
 	                                                std::uint16_t port ) {
-		auto const lck = std::unique_lock( m_mutex );
+		auto const lck = std::scoped_lock( m_mutex, m_read_mutex );
 		m_exec.wait( );
 		daw::exception::dbg_precondition_check( not is_open_no_lock( ),
 		                                        "Expecting disconnected socket" );
-		connect_impl( static_cast<std::string>( host ), port );
+		if( m_family == address_family::Unix ) {
+			auto const address = socket_address::from_unix_path( host );
+			auto req = connect_impl( address );
+			apply_timeout( req );
+			finish_connect( details::perform_blocking( req ) );
+			return;
+		}
+		auto address =
+		  resolver( ).resolve( host, m_family, m_socket_type ).get( )->front( );
+		address.set_port( port );
+		auto req = connect_impl( address );
+		apply_timeout( req );
+		finish_connect( details::perform_blocking( req ) );
 	}
 
 	template<typename ExecPolicy>
-	async_result<void>
-	basic_network_socket<ExecPolicy>::connect_async( std::string_view host,
-	                                                 std::uint16_t port ) {
+	void
+	basic_network_socket<ExecPolicy>::connect( socket_address const &address ) {
+		auto const lck = std::scoped_lock( m_mutex, m_read_mutex );
+		m_exec.wait( );
+		daw::exception::dbg_precondition_check( not is_open_no_lock( ),
+		                                        "Expecting disconnected socket" );
+		auto req = connect_impl( address );
+		apply_timeout( req );
+		finish_connect( details::perform_blocking( req ) );
+	}
 
-		auto state = std::make_shared<async_result_state<void>>( );
-		m_exec.add_task(
-		  [&, host = static_cast<std::string>( host ), port, state]( ) noexcept {
+	template<typename ExecPolicy>
+	async_result<void> basic_network_socket<ExecPolicy>::connect_address_async(
+	  socket_address address, std::function<void( )> on_completion,
+	  std::stop_token stop ) {
+		auto const lck = std::scoped_lock( m_mutex, m_read_mutex );
+		auto state = async_result_state<void>::make( );
+		queue_exclusive_task(
+		  [this, address = details::make_socket_address( address ), state,
+		   on_completion = std::move( on_completion ),
+		   started = false]( ::ssize_t r ) mutable -> io_request {
 			  try {
-				  daw::exception::dbg_precondition_check(
-				    not is_open_no_lock( ), "Expecting disconnected socket" );
-				  connect_impl( host, port );
+				  if( r < 0 ) {
+					  throw network_exception( "error connecting", -r );
+				  }
+				  if( not started ) {
+					  started = true;
+					  daw::exception::dbg_precondition_check(
+					    not is_open_no_lock( ), "Expecting disconnected socket" );
+					  return connect_impl( *address );
+				  }
+				  finish_connect( r );
+				  if( on_completion ) {
+					  on_completion( );
+				  }
+				  state->set_value( );
 			  } catch( ... ) { state->set_exception( ); }
-			  state->set_value( );
-		  } );
+			  return { };
+		  },
+		  std::move( stop ) );
 		return async_result<void>( std::move( state ) );
 	}
 
 	template<typename ExecPolicy>
 	async_result<void> basic_network_socket<ExecPolicy>::connect_async(
-	  std::string_view host, std::uint16_t port,
-	  std::function<void( )> on_completion ) {
+	  socket_address const &address, std::stop_token stop ) {
+		return connect_address_async( address, { }, std::move( stop ) );
+	}
 
-		auto state = std::make_shared<async_result_state<void>>( );
-		m_exec.add_task( [&, host = static_cast<std::string>( host ), port, state,
-		                  on_completion = daw::mutable_capture(
-		                    std::move( on_completion ) )]( ) noexcept {
-			try {
-				daw::exception::dbg_precondition_check(
-				  not is_open_no_lock( ), "Expecting disconnected socket" );
-				connect_impl( host, port );
-				( std::move( *on_completion ) )( );
-			} catch( ... ) { state->set_exception( ); }
-			state->set_value( );
-		} );
+	/***
+	 * Connects to the first address host resolves to, or races all of them
+	 * when given an attempt_delay.  A lookup that is not cached parks the task
+	 * on a wakeup_fd until the resolver answers, so the exec policy keeps
+	 * running other sockets and the operations queued after the connect still
+	 * wait for it
+	 */
+	template<typename ExecPolicy>
+	async_result<void> basic_network_socket<ExecPolicy>::connect_host_async(
+	  std::string_view host, std::uint16_t port,
+	  std::function<void( )> on_completion, std::stop_token stop,
+	  std::optional<std::chrono::milliseconds> attempt_delay ) {
+		if( m_family == address_family::Unix ) {
+			return connect_address_async( socket_address::from_unix_path( host ),
+			                              std::move( on_completion ),
+			                              std::move( stop ) );
+		}
+		struct connect_op {
+			std::string host{ };
+			std::uint16_t port = 0;
+			std::function<void( )> on_completion{ };
+			std::optional<async_result<address_list>> lookup{ };
+			std::optional<details::wakeup_fd> wakeup{ };
+			// The connect request points here
+			socket_address address{ };
+			bool connecting = false;
+			std::optional<std::chrono::milliseconds> attempt_delay{ };
+#if defined( __linux__ )
+			std::optional<details::connect_race> race{ };
+#endif
+		};
+		auto op = std::make_unique<connect_op>( );
+		op->host = static_cast<std::string>( host );
+		op->port = port;
+		op->on_completion = std::move( on_completion );
+		op->attempt_delay = attempt_delay;
+		auto const lck = std::scoped_lock( m_mutex, m_read_mutex );
+		auto state = async_result_state<void>::make( );
+		queue_exclusive_task(
+		  [this, state, op = std::move( op )]( ::ssize_t r ) mutable -> io_request {
+			  try {
+				  if( not op->lookup ) {
+					  if( r < 0 ) {
+						  throw network_exception( "error connecting", -r );
+					  }
+					  daw::exception::dbg_precondition_check(
+					    not is_open_no_lock( ), "Expecting disconnected socket" );
+					  op->lookup = resolver( ).resolve( op->host, m_family, m_socket_type );
+					  if( not op->lookup->try_wait( ) ) {
+						  op->wakeup.emplace( );
+						  op->lookup->on_ready(
+						    [notifier = op->wakeup->make_notifier( )](
+						      async_result<address_list> const & ) { notifier.notify( ); } );
+						  return io_request::wait_readable( op->wakeup->fd( ) );
+					  }
+				  }
+				  if( not op->connecting ) {
+					  if( r < 0 ) {
+						  // The wait for the lookup timed out
+						  throw network_exception( "error connecting", -r );
+					  }
+					  op->connecting = true;
+					  auto const &addresses = *op->lookup->get( );
+#if defined( __linux__ )
+					  if( op->attempt_delay and addresses.size( ) > 1 ) {
+						  op->race.emplace( addresses, op->port, m_socket_type,
+						                    *op->attempt_delay, m_options );
+						  r = 0;
+					  }
+					  if( not op->race ) {
+#endif
+						  op->address = addresses.front( );
+						  op->address.set_port( op->port );
+						  return connect_impl( op->address );
+#if defined( __linux__ )
+					  }
+#endif
+				  }
+#if defined( __linux__ )
+				  if( op->race ) {
+					  if( r < 0 ) {
+						  throw network_exception( "error connecting", -r );
+					  }
+					  auto const result = op->race->step( );
+					  if( not result ) {
+						  return io_request::wait_readable( op->race->fd( ) );
+					  }
+					  if( *result < 0 ) {
+						  throw network_exception( "error connecting", -*result );
+					  }
+					  m_socket = *result;
+					  op->race.reset( );
+				  } else {
+					  finish_connect( r );
+				  }
+#else
+				  finish_connect( r );
+#endif
+				  if( op->on_completion ) {
+					  op->on_completion( );
+				  }
+				  state->set_value( );
+			  } catch( ... ) { state->set_exception( ); }
+			  return { };
+		  },
+		  std::move( stop ) );
 		return async_result<void>( std::move( state ) );
 	}
 
+	template<typename ExecPolicy>
+	async_result<void>
+	basic_network_socket<ExecPolicy>::connect_async( std::string_view host,
+	                                                 std::uint16_t port,
+	                                                 std::stop_token stop ) {
+		return connect_host_async( host, port, { }, std::move( stop ) );
+	}
+
+	template<typename ExecPolicy>
+	async_result<void> basic_network_socket<ExecPolicy>::connect_async(
+	  std::string_view host, std::uint16_t port,
+	  std::function<void( )> on_completion, std::stop_token stop ) {
+		return connect_host_async( host, port, std::move( on_completion ),
+		                           std::move( stop ) );
+	}
+
+	template<typename ExecPolicy>
+	async_result<void> basic_network_socket<ExecPolicy>::connect_any_async(
+	  std::string_view host, std::uint16_t port,
+	  std::chrono::milliseconds attempt_delay, std::stop_token stop ) {
+		return connect_host_async( host, port, { }, std::move( stop ),
+		                           attempt_delay );
+	}
+
+	template<typename ExecPolicy>
+	void basic_network_socket<ExecPolicy>::open( ) {
+		auto const lck = std::scoped_lock( m_mutex, m_read_mutex );
+		if( is_open_no_lock( ) ) {
+			return;
+		}
+		m_socket = ::socket( static_cast<int>( m_family ),
+		                     static_cast<int>( m_socket_type ) | SOCK_NONBLOCK |
+		                       SOCK_CLOEXEC,
+		                     0 );
+		if( m_socket < 0 ) {
+			throw network_exception( "Error creating socket", errno );
+		}
+		if( int const err = apply_options( m_socket ); err != 0 ) {
+			close_socket( );
+			throw network_exception( "Error setting socket option", err );
+		}
+	}
+
 	template<typename ExecPolicy>
 	void basic_network_socket<ExecPolicy>::close( ) {
-		auto const lck = std::unique_lock( m_mutex );
+		auto const lck = std::scoped_lock( m_mutex, m_read_mutex );
 		m_exec.wait( );
 		daw::exception::dbg_precondition_check( is_open_no_lock( ),
 		                                        "Expecting connected socket" );
-		::close( m_socket );
-		m_socket = -1;
+		close_socket( );
 	}
 
 	template<typename ExecPolicy>
 	async_result<void> basic_network_socket<ExecPolicy>::close_async( ) {
-		auto const lck = std::unique_lock( m_mutex );
+		auto const lck = std::scoped_lock( m_mutex, m_read_mutex );
 
-		auto state = std::make_shared<async_result_state<void>>( );
-		m_exec.add_task( [&, state]( ) noexcept {
+		auto state = async_result_state<void>::make( );
+		queue_exclusive_task( [this, state]( ::ssize_t r ) -> io_request {
 			try {
+				if( r < 0 ) {
+					throw network_exception( "Error closing socket", -r );
+				}
 				daw::exception::dbg_precondition_check( is_open_no_lock( ),
 				                                        "Expecting connected socket" );
-				::close( m_socket );
-				m_socket = -1;
+				close_socket( );
+				state->set_value( );
 			} catch( ... ) { state->set_exception( ); }
-			state->set_value( );
+			return { };
 		} );
 		return async_result<void>( std::move( state ) );
 	}
 
 	template<typename ExecPolicy>
-	basic_network_socket<ExecPolicy>::basic_network_socket( address_family af,
-	                                                        socket_types st )
-	  : m_family( af )
+	template<typename... ExecArgs>
+	basic_network_socket<ExecPolicy>::basic_network_socket(
+	  address_family af, socket_types st, ExecArgs &&...exec_args )
+	  : m_exec( std::forward<ExecArgs>( exec_args )... )
+	  , m_family( af )
 	  , m_socket_type( st ) {}
 
 	template<typename ExecPolicy>
+	template<typename... ExecArgs>
+	basic_network_socket<ExecPolicy>::basic_network_socket(
+	  adopt_socket sock, address_family af, socket_types st,
+	  ExecArgs &&...exec_args )
+	  : m_exec( std::forward<ExecArgs>( exec_args )... )
+	  , m_family( af )
+	  , m_socket_type( st ) {
+		// Only owned once nothing can throw, until then it is the caller's
+		m_socket = sock.fd;
+	}
+
+	template<typename ExecPolicy>
+	void basic_network_socket<ExecPolicy>::bind( std::string_view host,
+	                                             std::uint16_t port,
+	                                             bool reuse_port ) {
+		if( m_family == address_family::Unix ) {
+			bind( socket_address::from_unix_path( host ) );
+			return;
+		}
+		auto const lck = std::scoped_lock( m_mutex, m_read_mutex );
+		m_exec.wait( );
+		daw::exception::dbg_precondition_check( not is_open_no_lock( ),
+		                                        "Expecting disconnected socket" );
+		auto const addresses =
+		  resolve( static_cast<std::string>( host ), port, AI_PASSIVE );
+		m_socket =
+		  ::socket( addresses->ai_family,
+		            addresses->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+		            addresses->ai_protocol );
+		if( m_socket < 0 ) {
+			throw network_exception( "Error creating socket", errno );
+		}
+		int const one = 1;
+		int err = apply_options( m_socket );
+		if( err == 0 and
+		    ( ::setsockopt( m_socket, SOL_SOCKET, SO_REUSEADDR, &one,
+		                    sizeof( one ) ) < 0 or
+		      ( reuse_port and ::setsockopt( m_socket, SOL_SOCKET, SO_REUSEPORT,
+		                                     &one, sizeof( one ) ) < 0 ) or
+		      ::bind( m_socket, addresses->ai_addr, addresses->ai_addrlen ) < 0 ) ) {
+			err = errno;
+		}
+		if( err != 0 ) {
+			close_socket( );
+			throw network_exception( "Error binding socket", err );
+		}
+		m_family = static_cast<address_family>( addresses->ai_family );
+	}
+
+	template<typename ExecPolicy>
+	void basic_network_socket<ExecPolicy>::bind( socket_address const &address ) {
+		auto const lck = std::scoped_lock( m_mutex, m_read_mutex );
+		m_exec.wait( );
+		daw::exception::dbg_precondition_check( not is_open_no_lock( ),
+		                                        "Expecting disconnected socket" );
+		m_socket = ::socket( address.storage.ss_family,
+		                     static_cast<int>( m_socket_type ) | SOCK_NONBLOCK |
+		                       SOCK_CLOEXEC,
+		                     0 );
+		if( m_socket < 0 ) {
+			throw network_exception( "Error creating socket", errno );
+		}
+		int err = apply_options( m_socket );
+		if( err == 0 and ::bind( m_socket, address.data( ), address.size ) < 0 ) {
+			err = errno;
+		}
+		if( err != 0 ) {
+			close_socket( );
+			throw network_exception( "Error binding socket", err );
+		}
+		m_family = address.family( );
+	}
+
+	template<typename ExecPolicy>
+	void basic_network_socket<ExecPolicy>::listen( int backlog ) {
+		auto const lck = std::unique_lock( m_mutex );
+		daw::exception::dbg_precondition_check( is_open_no_lock( ),
+		                                        "Expecting bound socket" );
+		if( ::listen( m_socket, backlog ) < 0 ) {
+			throw network_exception( "Error listening on socket", errno );
+		}
+	}
+
+	template<typename ExecPolicy>
+	std::uint16_t basic_network_socket<ExecPolicy>::local_port( ) const {
+		auto const lck = std::unique_lock( m_mutex );
+		auto addr = ::sockaddr_storage( );
+		auto len = static_cast<::socklen_t>( sizeof( addr ) );
+		if( ::getsockname( m_socket, reinterpret_cast<::sockaddr *>( &addr ),
+		                   &len ) < 0 ) {
+			throw network_exception( "Error getting socket name", errno );
+		}
+		if( addr.ss_family == AF_INET6 ) {
+			return ntohs( reinterpret_cast<::sockaddr_in6 const &>( addr ).sin6_port );
+		}
+		return ntohs( reinterpret_cast<::sockaddr_in const &>( addr ).sin_port );
+	}
+
+	template<typename ExecPolicy>
+	async_result<void> basic_network_socket<ExecPolicy>::accept_async(
+	  daw::span<int> fds,
+	  std::function<bool( daw::span<int const> )> on_accepted,
+	  std::stop_token stop ) {
+		auto const lck = std::unique_lock( m_read_mutex );
+		auto state = async_result_state<void>::make( );
+
+		queue_read_task(
+		  [this, fds, on_accepted = std::move( on_accepted ), state,
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  try {
+				  if( r < 0 ) {
+					  throw network_exception{ "accept error", -r };
+				  }
+				  if( started and
+				      not on_accepted( daw::span<int const>(
+				        fds.data( ), static_cast<std::size_t>( r ) ) ) ) {
+					  state->set_value( );
+					  return { };
+				  }
+				  started = true;
+				  return io_request::accept( m_socket, fds );
+			  } catch( ... ) { state->set_exception( ); }
+			  return { };
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	/***
+	 * Waits for the queued send outside of the lock, so other threads can keep
+	 * queueing operations meanwhile
+	 */
+	template<typename ExecPolicy>
 	std::size_t
 	basic_network_socket<ExecPolicy>::send( daw::span<const char> buffer,
 	                                        int flags ) {
-		auto const lck = std::unique_lock( m_mutex );
-		daw::exception::dbg_precondition_check( is_open_no_lock( ),
+		daw::exception::dbg_precondition_check( is_open( ),
 		                                        "Expecting connected socket" );
-		m_exec.wait( );
-		auto result = ::send( m_socket, buffer.data( ), buffer.size( ), flags );
-		if( result < 0 ) {
-			throw network_exception{ "send error", errno };
-		}
-		return static_cast<std::size_t>( result );
+		return send_some_async( buffer, flags ).get( );
+	}
+
+	template<typename ExecPolicy>
+	async_result<std::size_t> basic_network_socket<ExecPolicy>::send_some_async(
+	  daw::span<char const> buffer, int flags, std::stop_token stop ) {
+		auto const lck = std::unique_lock( m_mutex );
+		end_write_batch( );
+		auto state = async_result_state<std::size_t>::make( );
+
+		queue_write_task(
+		  [this, buffer, state, flags,
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "send error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( started ) {
+				  state->set_value( static_cast<std::size_t>( r ) );
+				  return { };
+			  }
+			  started = true;
+			  return io_request::send( m_socket, buffer, flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
 	}
 
-	// TODO: account for return 0, closure
 	template<typename ExecPolicy>
 	async_result<void>
 	basic_network_socket<ExecPolicy>::send_async( daw::span<const char> buffer,
-	                                              int flags ) {
+	                                              int flags,
+	                                              std::stop_token stop ) {
 		auto const lck = std::unique_lock( m_mutex );
-		auto state = std::make_shared<async_result_state<void>>( );
-
-		m_exec.add_task(
-		  [&, buffer = daw::mutable_capture( buffer ), state, flags]( ) noexcept {
-			  daw::exception::dbg_precondition_check( is_open_no_lock( ),
-			                                          "Expecting connected socket" );
-			  std::size_t const expected_total = buffer->size( );
-			  while( not buffer->empty( ) ) {
-				  auto r = ::send( m_socket, buffer->data( ), buffer->size( ), flags );
-				  if( r < 0 ) {
-					  state->set_exception( std::make_exception_ptr(
-					    network_exception{ "send error", errno } ) );
-					  return;
-				  }
-				  buffer->remove_prefix( r );
+		if( m_coalesce_writes ) {
+			if( not stop.stop_possible( ) ) {
+				return send_coalesced( buffer, flags );
+			}
+			// One write of a shared sendmsg cannot be cancelled on its own
+			end_write_batch( );
+		}
+		auto state = async_result_state<void>::make( );
+
+		queue_write_task(
+		  [this, buffer, state, flags]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "send error", static_cast<int>( -r ) );
+				  return { };
 			  }
-			  state->set_value( );
+			  buffer.remove_prefix( static_cast<std::size_t>( r ) );
+			  if( buffer.empty( ) ) {
+				  state->set_value( );
+				  return { };
+			  }
+			  return io_request::send( m_socket, buffer, flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	/***
+	 * Join the open write batch, or start one with a flush task that sends
+	 * whatever has been queued each time its previous sendmsg completes.
+	 * Called with m_mutex held
+	 */
+	template<typename ExecPolicy>
+	async_result<void>
+	basic_network_socket<ExecPolicy>::send_coalesced( daw::span<char const> buffer,
+	                                                  int flags ) {
+		auto state = async_result_state<void>::make( );
+		if( buffer.empty( ) ) {
+			state->set_value( );
+			return { std::move( state ) };
+		}
+		if( m_write_batch and m_write_batch->flags( ) == flags and
+		    m_write_batch->add( buffer, state ) ) {
+			return { std::move( state ) };
+		}
+		end_write_batch( );
+		m_write_batch = std::make_shared<details::write_batch>( flags );
+		(void)m_write_batch->add( buffer, state );
+		queue_write_task(
+		  [this, batch = m_write_batch,
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  batch->fail( static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( started ) {
+				  batch->advance( static_cast<std::size_t>( r ) );
+			  }
+			  started = true;
+			  if( not batch->refill( ) ) {
+				  return { };
+			  }
+			  auto const [msg, msg_flags] = batch->next( );
+			  return io_request::sendmsg( m_socket, msg, msg_flags );
 		  } );
 		return { std::move( state ) };
 	}
 
+	/***
+	 * Stop coalescing into the current batch so a send queued next goes after
+	 * it.  Called with m_mutex held
+	 */
+	template<typename ExecPolicy>
+	void basic_network_socket<ExecPolicy>::end_write_batch( ) {
+		if( m_write_batch ) {
+			m_write_batch->close( );
+			m_write_batch.reset( );
+		}
+	}
+
+	/***
+	 * Wrap an io task for exec, giving its requests the operation's deadline
+	 * when the socket has a timeout and stop when it can be stopped.  Both are
+	 * set up when the task first runs.  Once a stop is requested the requests
+	 * the task makes are not performed, it is handed -ECANCELED for them
+	 * instead.  Reaping a zerocopy send's completion gets neither, the kernel
+	 * holds the buffer until it arrives
+	 */
+	template<typename ExecPolicy>
+	template<typename Task>
+	io_task basic_network_socket<ExecPolicy>::make_io_op( async_exec_policy &exec,
+	                                                      Task &&task,
+	                                                      std::stop_token stop ) {
+		auto const timeout = m_timeout.load( );
+		if( timeout == std::chrono::milliseconds( 0 ) and
+		    not stop.stop_possible( ) ) {
+			return std::forward<Task>( task );
+		}
+		return
+		  [exec = &exec, task = std::forward<Task>( task ), timeout,
+		   stop = std::move( stop ),
+		   deadline = std::optional<io_clock::time_point>( ),
+		   on_stop = std::unique_ptr<details::operation_stop<ExecPolicy>>( )](
+		    ::ssize_t r ) mutable -> io_request {
+			  if( not deadline ) {
+				  deadline = timeout == std::chrono::milliseconds( 0 )
+				               ? io_clock::time_point::max( )
+				               : io_clock::now( ) + timeout;
+				  if( stop.stop_possible( ) ) {
+					  on_stop = std::make_unique<details::operation_stop<ExecPolicy>>(
+					    std::move( stop ), *exec );
+				  }
+			  }
+			  auto req = task( r );
+			  if( req.op == io_op_type::recv_errqueue ) {
+				  return req;
+			  }
+			  if( on_stop ) {
+				  while( req and on_stop->token.stop_requested( ) ) {
+					  req = task( -ECANCELED );
+				  }
+				  if( not req ) {
+					  // Here rather than with the task, which a strand destroys under
+					  // the lock the callback can be waiting for
+					  on_stop.reset( );
+					  return req;
+				  }
+				  req.stop = &on_stop->token;
+			  }
+			  req.deadline = *deadline;
+			  return req;
+		  };
+	}
+
+	/// Queue a receive or accept.  Called with m_read_mutex held
+	template<typename ExecPolicy>
+	template<typename Task>
+	void basic_network_socket<ExecPolicy>::queue_read_task( Task &&task,
+	                                                        std::stop_token stop ) {
+		m_exec.add_read_io_task(
+		  make_io_op( m_exec, std::forward<Task>( task ), std::move( stop ) ) );
+	}
+
+	/// Queue a send.  Called with m_mutex held
+	template<typename ExecPolicy>
+	template<typename Task>
+	void
+	basic_network_socket<ExecPolicy>::queue_write_task( Task &&task,
+	                                                    std::stop_token stop ) {
+		m_exec.add_io_task(
+		  make_io_op( m_exec, std::forward<Task>( task ), std::move( stop ) ) );
+	}
+
+	/***
+	 * Queue a task that changes the fd both strands use, e.g. a connect or a
+	 * close.  It runs once the operations queued before it are done, and the
+	 * ones queued after it wait until it is.  Called with both locks held
+	 */
+	template<typename ExecPolicy>
+	template<typename Task>
+	void
+	basic_network_socket<ExecPolicy>::queue_exclusive_task( Task &&task,
+	                                                        std::stop_token stop ) {
+		m_exec.add_exclusive_io_task(
+		  make_io_op( m_exec, std::forward<Task>( task ), std::move( stop ) ) );
+	}
+
+	template<typename ExecPolicy>
+	void basic_network_socket<ExecPolicy>::apply_timeout( io_request &req ) const {
+		auto const timeout = m_timeout.load( );
+		if( timeout != std::chrono::milliseconds( 0 ) ) {
+			req.deadline = io_clock::now( ) + timeout;
+		}
+	}
+
+	/// Returns 0 or the errno of the first option fd rejects
+	template<typename ExecPolicy>
+	int basic_network_socket<ExecPolicy>::apply_options( int fd ) const {
+		return details::apply_socket_options( fd, m_options );
+	}
+
+	template<typename ExecPolicy>
+	void
+	basic_network_socket<ExecPolicy>::set_raw_option( raw_socket_option option ) {
+		auto const lck = std::unique_lock( m_mutex );
+		if( m_socket >= 0 and ::setsockopt( m_socket, option.level, option.name,
+		                                    &option.value,
+		                                    sizeof( option.value ) ) < 0 ) {
+			throw network_exception( "Error setting socket option", errno );
+		}
+		auto pos = std::find_if( m_options.begin( ), m_options.end( ),
+		                         [&]( raw_socket_option const &o ) {
+			                         return o.level == option.level and
+			                                o.name == option.name;
+		                         } );
+		if( pos == m_options.end( ) ) {
+			m_options.push_back( option );
+		} else {
+			*pos = option;
+		}
+	}
+
+	template<typename ExecPolicy>
+	async_result<void> basic_network_socket<ExecPolicy>::send_vectors(
+	  ::daw::details::io_vectors_ptr vecs, int flags, std::stop_token stop ) {
+		auto const lck = std::unique_lock( m_mutex );
+		end_write_batch( );
+		auto state = async_result_state<void>::make( );
+
+		queue_write_task(
+		  [this, vecs = std::move( vecs ), state,
+		   flags]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "send error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( vecs->advance( static_cast<std::size_t>( r ) ) ) {
+				  state->set_value( );
+				  return { };
+			  }
+			  return io_request::sendmsg( m_socket, vecs->msg( ), flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
 	template<typename ExecPolicy>
 	async_result<void> basic_network_socket<ExecPolicy>::send_async(
 	  daw::span<char const> buffer,
@@ -304,76 +1483,548 @@ namespace daw::networking {
 	    on_completion,
 	  int flags ) {
 		auto const lck = std::unique_lock( m_mutex );
-		auto state = std::make_shared<async_result_state<void>>( );
-
-		m_exec.add_task(
-		  [&, buff = daw::mutable_capture( buffer ),
-		   on_completion = daw::mutable_capture( std::move( on_completion ) ),
-		   state, flags]( ) noexcept {
-			  daw::exception::dbg_precondition_check( is_open_no_lock( ),
-			                                          "Expecting connected socket" );
-			  daw::span<char const> buffer = *buff;
-			  std::size_t const expected_total = buffer.size( );
-			  ::ssize_t r = -1;
-			  auto on_completion_result = std::optional<daw::span<char const>>( );
-			  do {
-				  auto r = ::send( m_socket, buffer.data( ), buffer.size( ), flags );
+		end_write_batch( );
+		auto state = async_result_state<void>::make( );
+
+		queue_write_task(
+		  [this, buffer, on_completion = std::move( on_completion ), state, flags,
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  try {
 				  if( r < 0 ) {
-					  state->set_exception( std::make_exception_ptr(
-					    network_exception{ "send error", errno } ) );
-					  return;
+					  throw network_exception{ "send error", -r };
 				  }
-				  on_completion_result =
-				    ( *on_completion )( buffer, static_cast<std::size_t>( r ) );
-				  if( on_completion_result ) {
-					  buffer = *on_completion_result;
+				  if( started ) {
+					  auto next = on_completion( buffer, static_cast<std::size_t>( r ) );
+					  if( r == 0 or not next ) {
+						  state->set_value( );
+						  return { };
+					  }
+					  buffer = *next;
 				  }
-			  } while( r != 0 and on_completion_result );
-			  state->set_value( );
+				  started = true;
+				  return io_request::send( m_socket, buffer, flags );
+			  } catch( ... ) { state->set_exception( ); }
+			  return { };
 		  } );
 		return { std::move( state ) };
 	}
 
+#if defined( __linux__ )
+	/// Returns 0 or the errno from turning on SO_ZEROCOPY
+	template<typename ExecPolicy>
+	int basic_network_socket<ExecPolicy>::enable_zerocopy( ) {
+		if( not m_zerocopy_enabled ) {
+			int const one = 1;
+			if( ::setsockopt( m_socket, SOL_SOCKET, SO_ZEROCOPY, &one,
+			                  sizeof( one ) ) < 0 ) {
+				return errno;
+			}
+			m_zerocopy_enabled = true;
+		}
+		return 0;
+	}
+
+	template<typename ExecPolicy>
+	async_result<void> basic_network_socket<ExecPolicy>::send_zerocopy_async(
+	  daw::span<char const> buffer, int flags ) {
+		auto const lck = std::unique_lock( m_mutex );
+		end_write_batch( );
+		auto state = async_result_state<void>::make( );
+
+		queue_write_task(
+		  [this, buffer, state, flags,
+		   note = ::daw::details::make_zerocopy_notification( ),
+		   released = std::uint32_t{ 0 }, error = 0, reaping = false,
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( not started ) {
+				  started = true;
+				  if( r < 0 ) {
+					  state->set_error( "send error", static_cast<int>( -r ) );
+					  return { };
+				  }
+				  if( int const err = enable_zerocopy( ); err != 0 ) {
+					  state->set_error( "zerocopy error", err );
+					  return { };
+				  }
+				  // Earlier sends have all been released before this task runs
+				  released = m_zerocopy_next;
+			  } else if( reaping ) {
+				  int const err = r < 0 ? static_cast<int>( r ) : note->update( released );
+				  if( err < 0 ) {
+					  state->set_error( "zerocopy error", -err );
+					  return { };
+				  }
+			  } else if( r >= 0 ) {
+				  ++m_zerocopy_next;
+				  buffer.remove_prefix( static_cast<std::size_t>( r ) );
+				  reaping = buffer.empty( );
+			  } else if( r == -ENOBUFS and released != m_zerocopy_next ) {
+				  // Too many pages pinned, wait for the kernel to release ours
+				  reaping = true;
+			  } else {
+				  // The part already sent is released before the failure is reported
+				  error = static_cast<int>( -r );
+				  reaping = true;
+			  }
+			  if( reaping and released != m_zerocopy_next ) {
+				  return io_request::recv_errqueue( m_socket, note->msg( ) );
+			  }
+			  reaping = false;
+			  if( error != 0 ) {
+				  state->set_error( "send error", error );
+				  return { };
+			  }
+			  if( buffer.empty( ) ) {
+				  state->set_value( );
+				  return { };
+			  }
+			  return io_request::send( m_socket, buffer, flags | MSG_ZEROCOPY );
+		  } );
+		return { std::move( state ) };
+	}
+
+	template<typename ExecPolicy>
+	async_result<std::size_t>
+	basic_network_socket<ExecPolicy>::send_file_async( int fd, ::off_t offset,
+	                                                   std::size_t count,
+	                                                   std::stop_token stop ) {
+		auto const lck = std::unique_lock( m_mutex );
+		end_write_batch( );
+		auto state = async_result_state<std::size_t>::make( );
+
+		queue_write_task(
+		  [this, state, fd, offset, count, total = std::size_t{ 0 },
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "send file error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( started ) {
+				  if( r == 0 ) {
+					  state->set_value( total );
+					  return { };
+				  }
+				  total += static_cast<std::size_t>( r );
+				  offset += static_cast<::off_t>( r );
+				  count -= static_cast<std::size_t>( r );
+			  }
+			  started = true;
+			  if( count == 0 ) {
+				  state->set_value( total );
+				  return { };
+			  }
+			  return io_request::sendfile( m_socket, fd, offset, count );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+#endif
+
+#if defined( __linux__ )
+	template<typename ExecPolicy>
+	async_result<std::size_t> basic_network_socket<ExecPolicy>::send_batch_async(
+	  daw::span<outgoing_datagram const> datagrams, int flags,
+	  std::stop_token stop ) {
+		auto batch = ::daw::details::make_mmsg_batch( datagrams.size( ) );
+		for( std::size_t n = 0; n < datagrams.size( ); ++n ) {
+			auto const &dg = datagrams[n];
+			batch->set( n, dg.data.data( ), dg.data.size( ),
+			            dg.peer.size > 0 ? const_cast<::sockaddr_storage *>(
+			                                 &dg.peer.storage )
+			                             : nullptr,
+			            dg.peer.size );
+		}
+		auto const lck = std::unique_lock( m_mutex );
+		auto state = async_result_state<std::size_t>::make( );
+
+		queue_write_task(
+		  [this, batch = std::move( batch ), state, flags, total = std::size_t{ 0 },
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "send error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( started ) {
+				  total += static_cast<std::size_t>( r );
+				  if( r == 0 or batch->advance( static_cast<std::size_t>( r ) ) ) {
+					  state->set_value( total );
+					  return { };
+				  }
+			  }
+			  started = true;
+			  if( batch->remaining_count( ) == 0 ) {
+				  state->set_value( total );
+				  return { };
+			  }
+			  return io_request::sendmmsg( m_socket, batch->remaining( ),
+			                               batch->remaining_count( ), flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	template<typename ExecPolicy>
+	async_result<std::size_t>
+	basic_network_socket<ExecPolicy>::receive_batch_async(
+	  daw::span<datagram> datagrams, int flags, std::stop_token stop ) {
+		auto batch = ::daw::details::make_mmsg_batch( datagrams.size( ) );
+		for( std::size_t n = 0; n < datagrams.size( ); ++n ) {
+			auto &dg = datagrams[n];
+			batch->set( n, dg.buffer.data( ), dg.buffer.size( ), &dg.peer.storage,
+			            sizeof( dg.peer.storage ) );
+		}
+		auto const lck = std::unique_lock( m_read_mutex );
+		auto state = async_result_state<std::size_t>::make( );
+
+		queue_read_task(
+		  [this, batch = std::move( batch ), datagrams, state, flags,
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "receive error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( started or batch->remaining_count( ) == 0 ) {
+				  for( std::size_t n = 0; n < static_cast<std::size_t>( r ); ++n ) {
+					  auto const &msg = ( *batch )[n];
+					  datagrams[n].size = msg.msg_len;
+					  datagrams[n].peer.size = msg.msg_hdr.msg_namelen;
+					  datagrams[n].truncated = ( msg.msg_hdr.msg_flags & MSG_TRUNC ) != 0;
+				  }
+				  state->set_value( static_cast<std::size_t>( r ) );
+				  return { };
+			  }
+			  started = true;
+			  return io_request::recvmmsg( m_socket, batch->remaining( ),
+			                               batch->remaining_count( ), flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	template<typename ExecPolicy>
+	async_result<void> basic_network_socket<ExecPolicy>::send_to_async(
+	  daw::span<char const> buffer, socket_address const &peer, int flags,
+	  std::stop_token stop ) {
+		auto batch = ::daw::details::make_mmsg_batch( 1 );
+		batch->set( 0, buffer.data( ), buffer.size( ),
+		            peer.size > 0 ? batch->store_name( &peer.storage, peer.size )
+		                          : nullptr,
+		            peer.size );
+		auto const lck = std::unique_lock( m_mutex );
+		auto state = async_result_state<void>::make( );
+
+		queue_write_task(
+		  [this, batch = std::move( batch ), state,
+		   flags]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "send error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( batch->advance( static_cast<std::size_t>( r ) ) ) {
+				  state->set_value( );
+				  return { };
+			  }
+			  return io_request::sendmmsg( m_socket, batch->remaining( ), 1, flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	/// Returns 0 or the errno from turning on UDP_GRO
+	template<typename ExecPolicy>
+	int basic_network_socket<ExecPolicy>::enable_gro( ) {
+		if( not m_gro_enabled ) {
+			int const one = 1;
+			if( ::setsockopt( m_socket, SOL_UDP, UDP_GRO, &one, sizeof( one ) ) <
+			    0 ) {
+				return errno;
+			}
+			m_gro_enabled = true;
+		}
+		return 0;
+	}
+
+	template<typename ExecPolicy>
+	async_result<void> basic_network_socket<ExecPolicy>::send_segments_async(
+	  daw::span<char const> buffer, std::uint16_t segment_size,
+	  socket_address const &peer, int flags, std::stop_token stop ) {
+		auto msg = ::daw::details::make_udp_segment_msg( );
+		auto const chunk_size =
+		  segment_size * ::daw::details::udp_segment_msg::segments_per_send(
+		                   segment_size );
+		auto const lck = std::unique_lock( m_mutex );
+		auto state = async_result_state<void>::make( );
+		if( chunk_size == 0 ) {
+			state->set_error( "send error", EINVAL );
+			return { std::move( state ) };
+		}
+		queue_write_task(
+		  [this, buffer, msg = std::move( msg ), peer, segment_size, chunk_size,
+		   state, flags]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "send error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  buffer.remove_prefix( static_cast<std::size_t>( r ) );
+			  if( buffer.empty( ) ) {
+				  state->set_value( );
+				  return { };
+			  }
+			  auto const chunk = std::min( buffer.size( ), chunk_size );
+			  return io_request::sendmsg(
+			    m_socket,
+			    msg->send( buffer.data( ), chunk, segment_size, &peer.storage,
+			               peer.size ),
+			    flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	template<typename ExecPolicy>
+	async_result<datagram_segments>
+	basic_network_socket<ExecPolicy>::receive_segments_async(
+	  daw::span<char> buffer, int flags, std::stop_token stop ) {
+		auto const lck = std::unique_lock( m_read_mutex );
+		auto state = async_result_state<datagram_segments>::make( );
+
+		queue_read_task(
+		  [this, buffer, msg = ::daw::details::make_udp_segment_msg( ), state,
+		   flags, started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "receive error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( not started ) {
+				  started = true;
+				  if( int const err = enable_gro( ); err != 0 ) {
+					  state->set_error( "gro error", err );
+					  return { };
+				  }
+				  return io_request::recvmsg(
+				    m_socket, msg->receive( buffer.data( ), buffer.size( ) ),
+				    flags );
+			  }
+			  auto result = datagram_segments( );
+			  result.data = buffer.subspan( 0, static_cast<std::size_t>( r ) );
+			  // A datagram that was not coalesced is a single segment
+			  result.segment_size = msg->segment_size( );
+			  if( result.segment_size == 0 ) {
+				  result.segment_size = result.data.size( );
+			  }
+			  std::memcpy( &result.peer.storage, &msg->name( ),
+			               sizeof( result.peer.storage ) );
+			  result.peer.size = msg->name_size( );
+			  state->set_value( result );
+			  return { };
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	template<typename ExecPolicy>
+	async_result<std::size_t>
+	basic_network_socket<ExecPolicy>::receive_from_async( daw::span<char> buffer,
+	                                                      socket_address &peer,
+	                                                      int flags,
+	                                                      std::stop_token stop ) {
+		auto batch = ::daw::details::make_mmsg_batch( 1 );
+		batch->set( 0, buffer.data( ), buffer.size( ), &peer.storage,
+		            sizeof( peer.storage ) );
+		auto const lck = std::unique_lock( m_read_mutex );
+		auto state = async_result_state<std::size_t>::make( );
+
+		queue_read_task(
+		  [this, batch = std::move( batch ), &peer, state, flags,
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "receive error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( started ) {
+				  peer.size = ( *batch )[0].msg_hdr.msg_namelen;
+				  state->set_value( static_cast<std::size_t>( ( *batch )[0].msg_len ) );
+				  return { };
+			  }
+			  started = true;
+			  return io_request::recvmmsg( m_socket, batch->remaining( ), 1,
+			                               flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+#endif
+
+	template<typename ExecPolicy>
+	async_result<std::size_t> basic_network_socket<ExecPolicy>::send_fds_async(
+	  daw::span<char const> buffer, daw::span<int const> fds, int flags,
+	  std::stop_token stop ) {
+		auto const lck = std::unique_lock( m_mutex );
+		end_write_batch( );
+		auto state = async_result_state<std::size_t>::make( );
+		if( buffer.empty( ) or
+		    fds.size( ) > ::daw::details::fd_passing_msg::max_fds ) {
+			state->set_error( "send error", EINVAL );
+			return { std::move( state ) };
+		}
+		queue_write_task(
+		  [this, buffer, fds, msg = ::daw::details::make_fd_passing_msg( ), state,
+		   flags, started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "send error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( started ) {
+				  state->set_value( static_cast<std::size_t>( r ) );
+				  return { };
+			  }
+			  started = true;
+			  return io_request::sendmsg(
+			    m_socket,
+			    msg->send( buffer.data( ), buffer.size( ), fds.data( ), fds.size( ) ),
+			    flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	template<typename ExecPolicy>
+	async_result<received_fds> basic_network_socket<ExecPolicy>::receive_fds_async(
+	  daw::span<char> buffer, daw::span<int> fds, int flags,
+	  std::stop_token stop ) {
+		auto const lck = std::unique_lock( m_read_mutex );
+		auto state = async_result_state<received_fds>::make( );
+#if defined( MSG_CMSG_CLOEXEC )
+		flags |= MSG_CMSG_CLOEXEC;
+#endif
+		queue_read_task(
+		  [this, buffer, fds, msg = ::daw::details::make_fd_passing_msg( ), state,
+		   flags, started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "receive error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( not started ) {
+				  started = true;
+				  return io_request::recvmsg(
+				    m_socket, msg->receive( buffer.data( ), buffer.size( ) ),
+				    flags );
+			  }
+			  auto const count = msg->take_fds( fds.data( ), fds.size( ) );
+			  auto result = received_fds( );
+			  result.size = static_cast<std::size_t>( r );
+			  result.fds = fds.subspan( 0, std::min( count, fds.size( ) ) );
+			  result.truncated = msg->truncated( ) or count > fds.size( );
+			  state->set_value( result );
+			  return { };
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	/// Like send( ), waits for the queued receive outside of the lock
 	template<typename ExecPolicy>
 	std::size_t basic_network_socket<ExecPolicy>::receive( daw::span<char> buffer,
 	                                                       int flags ) {
-		auto const lck = std::unique_lock( m_mutex );
-		m_exec.wait( );
-		daw::exception::dbg_precondition_check( is_open_no_lock( ),
+		daw::exception::dbg_precondition_check( is_open( ),
 		                                        "Expecting connected socket" );
-		auto result = ::recv( m_socket, buffer.data( ), buffer.size( ), flags );
-		if( result < 0 ) {
-			throw network_exception{ "receive error", errno };
-		}
-		return static_cast<std::size_t>( result );
+		return receive_some_async( buffer, flags ).get( );
 	}
 
+	/***
+	 * Fills the buffer, completing early with the count received when the peer
+	 * closes the connection
+	 */
 	template<typename ExecPolicy>
 	async_result<std::size_t>
 	basic_network_socket<ExecPolicy>::receive_async( daw::span<char> buffer,
-	                                                 int flags ) {
-		auto const lck = std::unique_lock( m_mutex );
-		auto state = std::make_shared<async_result_state<std::size_t>>( );
-
-		m_exec.add_task(
-		  [&, buffer = daw::mutable_capture( buffer ), state, flags]( ) noexcept {
-			  daw::exception::dbg_precondition_check( is_open_no_lock( ),
-			                                          "Expecting connected socket" );
-			  std::size_t const expected_total = buffer->size( );
-			  ::ssize_t r = 1;
-			  std::size_t total = 0;
-			  while( r > 0 and not buffer->empty( ) ) {
-				  auto r = ::recv( m_socket, buffer->data( ), buffer->size( ), flags );
-				  if( r < 0 ) {
-					  state->set_exception( std::make_exception_ptr(
-					    network_exception{ "receive error", errno } ) );
-					  return;
+	                                                 int flags,
+	                                                 std::stop_token stop ) {
+		auto const lck = std::unique_lock( m_read_mutex );
+		auto state = async_result_state<std::size_t>::make( );
+
+		queue_read_task(
+		  [this, buffer, state, flags, total = std::size_t{ 0 },
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "receive error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( started ) {
+				  if( r == 0 ) {
+					  state->set_value( total );
+					  return { };
 				  }
 				  total += static_cast<std::size_t>( r );
-				  buffer->remove_prefix( static_cast<std::size_t>( r ) );
+				  buffer.remove_prefix( static_cast<std::size_t>( r ) );
 			  }
-			  state->set_value( total );
-		  } );
+			  started = true;
+			  if( buffer.empty( ) ) {
+				  state->set_value( total );
+				  return { };
+			  }
+			  return io_request::recv( m_socket, buffer, flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	template<typename ExecPolicy>
+	async_result<std::size_t>
+	basic_network_socket<ExecPolicy>::receive_some_async( daw::span<char> buffer,
+	                                                      int flags,
+	                                                      std::stop_token stop ) {
+		auto const lck = std::unique_lock( m_read_mutex );
+		auto state = async_result_state<std::size_t>::make( );
+
+		queue_read_task(
+		  [this, buffer, state, flags,
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "receive error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( started ) {
+				  state->set_value( static_cast<std::size_t>( r ) );
+				  return { };
+			  }
+			  started = true;
+			  return io_request::recv( m_socket, buffer, flags );
+		  },
+		  std::move( stop ) );
+		return { std::move( state ) };
+	}
+
+	template<typename ExecPolicy>
+	async_result<std::size_t> basic_network_socket<ExecPolicy>::receive_vectors(
+	  ::daw::details::io_vectors_ptr vecs, int flags, std::stop_token stop ) {
+		auto const lck = std::unique_lock( m_read_mutex );
+		auto state = async_result_state<std::size_t>::make( );
+
+		queue_read_task(
+		  [this, vecs = std::move( vecs ), state, flags,
+		   total = std::size_t{ 0 },
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  if( r < 0 ) {
+				  state->set_error( "receive error", static_cast<int>( -r ) );
+				  return { };
+			  }
+			  if( started ) {
+				  if( r == 0 ) {
+					  state->set_value( total );
+					  return { };
+				  }
+				  total += static_cast<std::size_t>( r );
+				  vecs->advance( static_cast<std::size_t>( r ) );
+			  }
+			  started = true;
+			  if( vecs->empty( ) ) {
+				  state->set_value( total );
+				  return { };
+			  }
+			  return io_request::recvmsg( m_socket, vecs->msg( ), flags );
+		  },
+		  std::move( stop ) );
 		return { std::move( state ) };
 	}
 
@@ -384,33 +2035,28 @@ namespace daw::networking {
 	                                                std::size_t )>
 	    on_completion,
 	  int flags ) {
-		auto const lck = std::unique_lock( m_mutex );
-		auto state = std::make_shared<async_result_state<void>>( );
-
-		m_exec.add_task(
-		  [&, buff = daw::mutable_capture( buffer ),
-		   on_completion = daw::mutable_capture( std::move( on_completion ) ),
-		   state, flags]( ) noexcept {
-			  daw::exception::dbg_precondition_check( is_open_no_lock( ),
-			                                          "Expecting connected socket" );
-			  daw::span<char> buffer = *buff;
-			  std::size_t const expected_total = buffer.size( );
-			  ::ssize_t r = -1;
-			  auto on_completion_result = std::optional<daw::span<char>>( );
-			  do {
-				  auto r = ::recv( m_socket, buffer.data( ), buffer.size( ), flags );
+		auto const lck = std::unique_lock( m_read_mutex );
+		auto state = async_result_state<void>::make( );
+
+		queue_read_task(
+		  [this, buffer, on_completion = std::move( on_completion ), state, flags,
+		   started = false]( ::ssize_t r ) mutable -> io_request {
+			  try {
 				  if( r < 0 ) {
-					  state->set_exception( std::make_exception_ptr(
-					    network_exception{ "receive error", errno } ) );
-					  return;
+					  throw network_exception{ "receive error", -r };
 				  }
-				  on_completion_result =
-				    ( *on_completion )( buffer, static_cast<std::size_t>( r ) );
-				  if( on_completion_result ) {
-					  buffer = *on_completion_result;
+				  if( started ) {
+					  auto next = on_completion( buffer, static_cast<std::size_t>( r ) );
+					  if( r == 0 or not next ) {
+						  state->set_value( );
+						  return { };
+					  }
+					  buffer = *next;
 				  }
-			  } while( r != 0 and on_completion_result );
-			  state->set_value( );
+				  started = true;
+				  return io_request::recv( m_socket, buffer, flags );
+			  } catch( ... ) { state->set_exception( ); }
+			  return { };
 		  } );
 		return { std::move( state ) };
 	}
@@ -420,4 +2066,36 @@ namespace daw::networking {
 		return ::shutdown( m_socket, static_cast<int>( how ) );
 	}
 
+	/***
+	 * A connected pair of Unix domain sockets, e.g. to talk to a thread or a
+	 * forked child without a listener
+	 */
+	template<typename ExecPolicy>
+	using socket_pair = std::pair<std::unique_ptr<basic_network_socket<ExecPolicy>>,
+	                              std::unique_ptr<basic_network_socket<ExecPolicy>>>;
+
+	/***
+	 * Create a socket_pair of type st, Stream or SeqPacket.  Both sockets
+	 * construct their exec policy from exec_args, e.g. the reactor they run on
+	 */
+	template<typename ExecPolicy, typename... ExecArgs>
+	socket_pair<ExecPolicy> make_socket_pair( socket_types st,
+	                                          ExecArgs &...exec_args ) {
+		int fds[2];
+		if( ::socketpair( AF_UNIX,
+		                  static_cast<int>( st ) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0,
+		                  fds ) < 0 ) {
+			throw network_exception( "Error creating socket pair", errno );
+		}
+		auto first_fd = details::owned_fd( fds[0] );
+		auto second_fd = details::owned_fd( fds[1] );
+		auto first = std::make_unique<basic_network_socket<ExecPolicy>>(
+		  adopt_socket{ first_fd.get( ) }, address_family::Unix, st, exec_args... );
+		(void)first_fd.release( );
+		auto second = std::make_unique<basic_network_socket<ExecPolicy>>(
+		  adopt_socket{ second_fd.get( ) }, address_family::Unix, st,
+		  exec_args... );
+		(void)second_fd.release( );
+		return { std::move( first ), std::move( second ) };
+	}
 } // namespace daw::networking
@@ -0,0 +1,145 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace daw::details {
+	/***
+	 * Recycles objects of type T.  Every object belongs to the thread that
+	 * created it and goes back to that thread's free list when recycled.  A
+	 * recycle on the owning thread is a plain list push, one from another
+	 * thread is a lock free push onto the owner's remote list which the owner
+	 * takes in one exchange once its local list runs dry.  The number of
+	 * objects a thread ever creates is bounded by how many of them it has
+	 * outstanding at once.
+	 *
+	 * Objects recycled to a thread that has exited are deleted, and a thread's
+	 * cache is deleted once it has exited and none of its objects remain
+	 */
+	template<typename T>
+	class object_pool {
+		struct cache_t;
+
+		struct node_t : T {
+			node_t *next = nullptr;
+			cache_t *home = nullptr;
+		};
+
+		/***
+		 * Counts a reference for its thread and one for each object it created
+		 * that has not been deleted, as other threads can still be returning
+		 * objects to it after its thread exits
+		 */
+		struct cache_t {
+			node_t *local = nullptr;
+			std::atomic<node_t *> remote = nullptr;
+			std::atomic<bool> alive = true;
+			std::atomic<std::size_t> refs = 1;
+
+			void add_ref( ) {
+				refs.fetch_add( 1, std::memory_order_relaxed );
+			}
+
+			void release( ) {
+				if( refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+					delete this;
+				}
+			}
+
+			/// Callers hold a reference, so this cannot delete the cache
+			void destroy_list( node_t *head ) {
+				std::size_t count = 0;
+				while( head ) {
+					delete std::exchange( head, head->next );
+					++count;
+				}
+				refs.fetch_sub( count, std::memory_order_acq_rel );
+			}
+
+			void push_remote( node_t *node ) {
+				// node's reference keeps the cache alive until it is pushed
+				add_ref( );
+				node->next = remote.load( std::memory_order_relaxed );
+				while( not remote.compare_exchange_weak( node->next, node,
+				                                         std::memory_order_seq_cst ) ) {}
+				// Pairs with exit, either it sees this node or we see it has gone
+				if( not alive.load( std::memory_order_seq_cst ) ) {
+					destroy_list( remote.exchange( nullptr ) );
+				}
+				release( );
+			}
+
+			void exit( ) {
+				alive.store( false, std::memory_order_seq_cst );
+				destroy_list( std::exchange( local, nullptr ) );
+				destroy_list( remote.exchange( nullptr ) );
+				release( );
+			}
+		};
+
+		struct cache_handle {
+			cache_t *cache = new cache_t( );
+
+			cache_handle( ) {
+				t_cache = cache;
+			}
+
+			~cache_handle( ) {
+				t_cache = nullptr;
+				cache->exit( );
+			}
+		};
+
+		/***
+		 * The calling thread's cache once it has acquired, so a thread that
+		 * only recycles does not create one
+		 */
+		static inline thread_local cache_t *t_cache = nullptr;
+
+		static cache_t &cache( ) {
+			thread_local auto handle = cache_handle( );
+			return *handle.cache;
+		}
+
+	public:
+		static T *acquire( ) {
+			auto &c = cache( );
+			if( not c.local ) {
+				c.local = c.remote.exchange( nullptr, std::memory_order_acquire );
+			}
+			if( auto *node = c.local ) {
+				c.local = std::exchange( node->next, nullptr );
+				return node;
+			}
+			auto *node = new node_t( );
+			node->home = &c;
+			c.add_ref( );
+			return node;
+		}
+
+		/// p must have come from acquire and be in the state of a new T
+		static void recycle( T *p ) {
+			auto *node = static_cast<node_t *>( p );
+			if( node->home == t_cache ) {
+				node->next = std::exchange( t_cache->local, node );
+			} else {
+				node->home->push_remote( node );
+			}
+		}
+	};
+
+	/// unique_ptr deleter that hands the object back to its object_pool
+	template<typename T>
+	struct pool_recycler {
+		void operator( )( T *p ) const {
+			object_pool<T>::recycle( p );
+		}
+	};
+} // namespace daw::details
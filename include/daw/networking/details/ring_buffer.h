@@ -0,0 +1,120 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace daw::details {
+	/***
+	 * Growable FIFO on a power of 2 circular buffer.  Unlike std::deque it
+	 * keeps its storage when drained, so a queue that reaches a steady size
+	 * stops allocating.  Slots hold default constructed values when unused
+	 */
+	template<typename T>
+	class ring_buffer {
+		std::vector<T> m_items{ };
+		std::size_t m_head = 0;
+		std::size_t m_size = 0;
+
+		std::size_t mask( ) const {
+			return m_items.size( ) - 1;
+		}
+
+		void reallocate( std::size_t capacity ) {
+			auto items = std::vector<T>( capacity );
+			for( std::size_t n = 0; n < m_size; ++n ) {
+				items[n] = std::move( m_items[( m_head + n ) & mask( )] );
+			}
+			m_items = std::move( items );
+			m_head = 0;
+		}
+
+		void grow( ) {
+			reallocate( m_items.empty( ) ? 8 : m_items.size( ) * 2 );
+		}
+
+	public:
+		ring_buffer( ) = default;
+
+		ring_buffer( ring_buffer &&other ) noexcept
+		  : m_items( std::move( other.m_items ) )
+		  , m_head( std::exchange( other.m_head, 0 ) )
+		  , m_size( std::exchange( other.m_size, 0 ) ) {
+			other.m_items.clear( );
+		}
+
+		ring_buffer &operator=( ring_buffer &&rhs ) noexcept {
+			if( this != &rhs ) {
+				m_items = std::move( rhs.m_items );
+				rhs.m_items.clear( );
+				m_head = std::exchange( rhs.m_head, 0 );
+				m_size = std::exchange( rhs.m_size, 0 );
+			}
+			return *this;
+		}
+
+		ring_buffer( ring_buffer const & ) = delete;
+		ring_buffer &operator=( ring_buffer const & ) = delete;
+
+		bool empty( ) const {
+			return m_size == 0;
+		}
+
+		std::size_t size( ) const {
+			return m_size;
+		}
+
+		/// Allocate room for at least capacity items now rather than as they come
+		void reserve( std::size_t capacity ) {
+			auto size = m_items.empty( ) ? std::size_t{ 8 } : m_items.size( );
+			while( size < capacity ) {
+				size *= 2;
+			}
+			if( size != m_items.size( ) ) {
+				reallocate( size );
+			}
+		}
+
+		void push_back( T &&value ) {
+			if( m_size == m_items.size( ) ) {
+				grow( );
+			}
+			m_items[( m_head + m_size ) & mask( )] = std::move( value );
+			++m_size;
+		}
+
+		T &front( ) {
+			return m_items[m_head];
+		}
+
+		T pop_front( ) {
+			auto result = std::move( m_items[m_head] );
+			m_items[m_head] = T( );
+			m_head = ( m_head + 1 ) & mask( );
+			--m_size;
+			return result;
+		}
+
+		T pop_back( ) {
+			auto &slot = m_items[( m_head + m_size - 1 ) & mask( )];
+			auto result = std::move( slot );
+			slot = T( );
+			--m_size;
+			return result;
+		}
+
+		/// Move every item out, in order, onto the end of out
+		template<typename Container>
+		void drain_into( Container &out ) {
+			while( not empty( ) ) {
+				out.push_back( pop_front( ) );
+			}
+		}
+	};
+} // namespace daw::details
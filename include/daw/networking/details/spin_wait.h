@@ -0,0 +1,89 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#endif
+
+namespace daw {
+	namespace details {
+		/// Tell the core it is in a spin loop, easing off its sibling hyperthread
+		inline void cpu_relax( ) {
+#if defined( __x86_64__ ) || defined( __i386__ )
+			_mm_pause( );
+#elif defined( __aarch64__ )
+			asm volatile( "yield" );
+#endif
+		}
+
+		inline std::atomic<std::int64_t> &spin_limit_ns( ) {
+			static auto limit = std::atomic<std::int64_t>( 50'000 );
+			return limit;
+		}
+
+		/***
+		 * Spins a waiting thread for about as long as its recent waits took, so
+		 * a result that arrives soon skips the futex sleep and wake.  The
+		 * expectation is a moving average per thread, with waits longer than the
+		 * spin limit counted as zero, so a thread whose waits are long soon
+		 * stops spinning
+		 */
+		class adaptive_spin {
+			using clock = std::chrono::steady_clock;
+
+			static inline thread_local std::int64_t t_expected_ns = 0;
+
+			clock::time_point m_start = clock::now( );
+			std::int64_t m_limit = spin_limit_ns( ).load( std::memory_order_relaxed );
+
+		public:
+			/// Spin until done( ) or the spin budget runs out, returning done( )
+			template<typename Done>
+			bool spin( Done &&done ) const {
+				auto const budget = std::min( m_limit, 2 * t_expected_ns );
+				if( budget > 0 ) {
+					auto const until = m_start + std::chrono::nanoseconds( budget );
+					do {
+						for( int n = 0; n < 16; ++n ) {
+							if( done( ) ) {
+								return true;
+							}
+							cpu_relax( );
+						}
+					} while( clock::now( ) < until );
+				}
+				return done( );
+			}
+
+			/// Fold the whole wait, spun or parked, into the expectation
+			void record( ) const {
+				auto const took =
+				  std::chrono::duration_cast<std::chrono::nanoseconds>( clock::now( ) -
+				                                                        m_start )
+				    .count( );
+				auto const sample = took <= m_limit ? took : 0;
+				t_expected_ns += ( sample - t_expected_ns ) / 8;
+			}
+		};
+	} // namespace details
+
+	/***
+	 * The longest a thread waiting on an async_result spins before parking.
+	 * Zero parks right away, e.g. when waiting threads outnumber the cores
+	 */
+	inline void set_wait_spin_limit( std::chrono::nanoseconds limit ) {
+		details::spin_limit_ns( ).store(
+		  std::max( limit, std::chrono::nanoseconds( 0 ) ).count( ),
+		  std::memory_order_relaxed );
+	}
+} // namespace daw
@@ -0,0 +1,234 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace daw::details {
+	/***
+	 * A timer, embedded in whatever it times so scheduling and cancelling do
+	 * not allocate
+	 */
+	struct timer_node {
+		timer_node *prev = nullptr;
+		timer_node *next = nullptr;
+		std::uint64_t expiry = 0;
+		// What the timer belongs to, for the expiry callback
+		void *owner = nullptr;
+		// Set when the timer fired, for schedulers that finish the timeout later
+		bool expired = false;
+
+		bool linked( ) const {
+			return next != nullptr;
+		}
+	};
+
+	/***
+	 * Hierarchical timing wheel with 1ms ticks.  Four levels of 64 slots cover
+	 * about 4.6 hours, and later timers wait in the top level until they come
+	 * into range.  Scheduling and cancelling are O(1), and advancing a tick
+	 * touches one slot plus, every 64 ticks, the timers cascading down a
+	 * level.  Not thread safe, the owning scheduler serializes access
+	 */
+	class timer_wheel {
+	public:
+		using clock = std::chrono::steady_clock;
+
+	private:
+		static constexpr unsigned slot_bits = 6;
+		static constexpr std::uint64_t slot_count = 1U << slot_bits;
+		static constexpr std::uint64_t slot_mask = slot_count - 1;
+		static constexpr unsigned level_count = 4;
+
+		clock::time_point m_epoch = clock::now( );
+		// Every tick up to and including m_now has been processed
+		std::uint64_t m_now = 0;
+		std::size_t m_size = 0;
+		// Slot heads are sentinels of circular lists
+		std::array<std::array<timer_node, slot_count>, level_count> m_slots{ };
+		// Timers fired early, expired by the next advance( )
+		timer_node m_due{ };
+
+		static std::uint64_t slot_of( std::uint64_t tick, unsigned level ) {
+			return ( tick >> ( slot_bits * level ) ) & slot_mask;
+		}
+
+		static void link( timer_node &head, timer_node &node ) {
+			node.prev = head.prev;
+			node.next = &head;
+			head.prev->next = &node;
+			head.prev = &node;
+		}
+
+		static void unlink( timer_node &node ) {
+			node.prev->next = node.next;
+			node.next->prev = node.prev;
+			node.prev = node.next = nullptr;
+		}
+
+		/***
+		 * The lowest level whose current revolution contains the expiry, so the
+		 * timer is reached either directly or by cascading when its slot at
+		 * that level comes up
+		 */
+		void place( timer_node &node ) {
+			for( unsigned level = 0; level < level_count; ++level ) {
+				auto const span_bits = slot_bits * ( level + 1 );
+				if( ( node.expiry >> span_bits ) == ( m_now >> span_bits ) ) {
+					link( m_slots[level][slot_of( node.expiry, level )], node );
+					return;
+				}
+			}
+			// Beyond the wheel, park in the top slot that comes up last
+			auto const top = level_count - 1;
+			link( m_slots[top][( slot_of( m_now, top ) + slot_mask ) & slot_mask],
+			      node );
+		}
+
+		/// Move the timers of a slot down, they land in lower levels now
+		void cascade( unsigned level ) {
+			auto &head = m_slots[level][slot_of( m_now, level )];
+			while( head.next != &head ) {
+				auto &node = *head.next;
+				unlink( node );
+				place( node );
+			}
+		}
+
+		/// The first tick at or after t
+		std::uint64_t tick_of( clock::time_point t ) const {
+			if( t <= m_epoch ) {
+				return 0;
+			}
+			auto const ms = std::chrono::ceil<std::chrono::milliseconds>( t - m_epoch );
+			return static_cast<std::uint64_t>( ms.count( ) );
+		}
+
+		/// The last tick at or before t
+		std::uint64_t ticks_passed( clock::time_point t ) const {
+			if( t <= m_epoch ) {
+				return 0;
+			}
+			auto const ms =
+			  std::chrono::floor<std::chrono::milliseconds>( t - m_epoch );
+			return static_cast<std::uint64_t>( ms.count( ) );
+		}
+
+	public:
+		timer_wheel( ) {
+			for( auto &level : m_slots ) {
+				for( auto &head : level ) {
+					head.prev = head.next = &head;
+				}
+			}
+			m_due.prev = m_due.next = &m_due;
+		}
+
+		timer_wheel( timer_wheel const & ) = delete;
+		timer_wheel &operator=( timer_wheel const & ) = delete;
+
+		bool empty( ) const {
+			return m_size == 0;
+		}
+
+		/// Fire node at deadline, rounded up to the next tick
+		void schedule( timer_node &node, clock::time_point deadline ) {
+			auto expiry = tick_of( deadline );
+			if( expiry <= m_now ) {
+				expiry = m_now + 1;
+			}
+			node.expiry = expiry;
+			node.expired = false;
+			place( node );
+			++m_size;
+		}
+
+		void cancel( timer_node &node ) {
+			if( node.linked( ) ) {
+				unlink( node );
+				--m_size;
+			}
+		}
+
+		/// Fire node, scheduled or not, on the next advance( )
+		void expire_now( timer_node &node ) {
+			cancel( node );
+			node.expired = false;
+			link( m_due, node );
+			++m_size;
+		}
+
+		/***
+		 * Milliseconds until advance( ) next has work, for an epoll_wait style
+		 * timeout.  -1 when there are no timers
+		 */
+		int wait_ms( clock::time_point now ) const {
+			if( m_size == 0 ) {
+				return -1;
+			}
+			if( m_due.next != &m_due ) {
+				return 0;
+			}
+			auto next = m_now + 1;
+			while( ( next & slot_mask ) != 0 and
+			       m_slots[0][next & slot_mask].next == &m_slots[0][next & slot_mask] ) {
+				++next;
+			}
+			auto const at = m_epoch + std::chrono::milliseconds( next );
+			if( at <= now ) {
+				return 0;
+			}
+			return static_cast<int>(
+			  std::chrono::ceil<std::chrono::milliseconds>( at - now ).count( ) );
+		}
+
+		/***
+		 * Process every tick up to now, calling on_expired( node ) for each timer
+		 * that is due.  The node is unlinked first, so on_expired may reuse it
+		 */
+		template<typename OnExpired>
+		void advance( clock::time_point now, OnExpired &&on_expired ) {
+			auto const target = ticks_passed( now );
+			while( m_due.next != &m_due ) {
+				auto &node = *m_due.next;
+				unlink( node );
+				--m_size;
+				node.expired = true;
+				on_expired( node );
+			}
+			if( m_size == 0 ) {
+				m_now = std::max( m_now, target );
+				return;
+			}
+			while( m_now < target and m_size > 0 ) {
+				++m_now;
+				// Cascade from the highest level whose slot boundary this tick is
+				unsigned level = 0;
+				while( level + 1 < level_count and
+				       slot_of( m_now, level ) == 0 ) {
+					++level;
+				}
+				for( ; level > 0; --level ) {
+					cascade( level );
+				}
+				auto &head = m_slots[0][slot_of( m_now, 0 )];
+				while( head.next != &head ) {
+					auto &node = *head.next;
+					unlink( node );
+					--m_size;
+					node.expired = true;
+					on_expired( node );
+				}
+			}
+			m_now = std::max( m_now, target );
+		}
+	};
+} // namespace daw::details
@@ -0,0 +1,118 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "object_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace daw::details {
+	/***
+	 * The msghdr of a UDP GSO send or GRO receive.  A send carries the segment
+	 * size in a UDP_SEGMENT control message and a receive gets the size the
+	 * kernel coalesced datagrams at back in a UDP_GRO one
+	 */
+	class udp_segment_msg {
+		::msghdr m_msg{ };
+		::iovec m_iov{ };
+		::sockaddr_storage m_name{ };
+		alignas( ::cmsghdr ) unsigned char m_control[CMSG_SPACE( sizeof( int ) )];
+
+	public:
+		/// Most segments the kernel takes in one send
+		static constexpr std::size_t max_segments = 64;
+		/// Most payload bytes in one send, it must fit in one IP datagram
+		static constexpr std::size_t max_bytes = 65000;
+
+		/// Segments per send, 0 when segment_size is too large to offload
+		static constexpr std::size_t segments_per_send( std::size_t segment_size ) {
+			return segment_size == 0
+			         ? 0
+			         : std::min( max_segments, max_bytes / segment_size );
+		}
+
+		/***
+		 * Send size bytes of data as segment_size byte datagrams to name, or to
+		 * the connected peer when name_len is 0
+		 */
+		::msghdr *send( void const *data, std::size_t size,
+		                std::uint16_t segment_size, void const *name,
+		                ::socklen_t name_len ) {
+			m_msg = ::msghdr{ };
+			m_iov = ::iovec{ const_cast<void *>( data ), size };
+			m_msg.msg_iov = &m_iov;
+			m_msg.msg_iovlen = 1;
+			if( name_len > 0 ) {
+				std::memcpy( &m_name, name,
+				             std::min<std::size_t>( name_len, sizeof( m_name ) ) );
+				m_msg.msg_name = &m_name;
+				m_msg.msg_namelen = name_len;
+			}
+			std::memset( m_control, 0, sizeof( m_control ) );
+			m_msg.msg_control = m_control;
+			m_msg.msg_controllen = CMSG_SPACE( sizeof( std::uint16_t ) );
+			auto *cm = CMSG_FIRSTHDR( &m_msg );
+			cm->cmsg_level = SOL_UDP;
+			cm->cmsg_type = UDP_SEGMENT;
+			cm->cmsg_len = CMSG_LEN( sizeof( std::uint16_t ) );
+			std::memcpy( CMSG_DATA( cm ), &segment_size, sizeof( segment_size ) );
+			return &m_msg;
+		}
+
+		/// Receive into size bytes of data, the sender goes in name( )
+		::msghdr *receive( void *data, std::size_t size ) {
+			m_msg = ::msghdr{ };
+			m_iov = ::iovec{ data, size };
+			m_msg.msg_iov = &m_iov;
+			m_msg.msg_iovlen = 1;
+			m_msg.msg_name = &m_name;
+			m_msg.msg_namelen = sizeof( m_name );
+			m_msg.msg_control = m_control;
+			m_msg.msg_controllen = sizeof( m_control );
+			return &m_msg;
+		}
+
+		/***
+		 * After a receive, the size of the datagrams the kernel coalesced, 0
+		 * when a single datagram arrived
+		 */
+		std::size_t segment_size( ) const {
+			for( auto *cm = CMSG_FIRSTHDR( &m_msg ); cm != nullptr;
+			     cm = CMSG_NXTHDR( const_cast<::msghdr *>( &m_msg ), cm ) ) {
+				if( cm->cmsg_level == SOL_UDP and cm->cmsg_type == UDP_GRO ) {
+					int gso_size = 0;
+					std::memcpy( &gso_size, CMSG_DATA( cm ), sizeof( gso_size ) );
+					return static_cast<std::size_t>( gso_size );
+				}
+			}
+			return 0;
+		}
+
+		::sockaddr_storage const &name( ) const {
+			return m_name;
+		}
+
+		::socklen_t name_size( ) const {
+			return m_msg.msg_namelen;
+		}
+	};
+
+	using udp_segment_msg_ptr =
+	  std::unique_ptr<udp_segment_msg, pool_recycler<udp_segment_msg>>;
+
+	inline udp_segment_msg_ptr make_udp_segment_msg( ) {
+		return udp_segment_msg_ptr( object_pool<udp_segment_msg>::acquire( ) );
+	}
+} // namespace daw::details
@@ -0,0 +1,146 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace daw {
+	template<typename Signature, std::size_t Capacity = 64>
+	class unique_function;
+
+	/***
+	 * Move only type erased callable.  Callables up to Capacity bytes with a
+	 * noexcept move are stored inline, larger ones fall back to the heap
+	 */
+	template<typename R, typename... Args, std::size_t Capacity>
+	class unique_function<R( Args... ), Capacity> {
+		struct vtable_t {
+			R ( *invoke )( void *, Args &&... );
+			void ( *move )( void *dst, void *src ) noexcept;
+			void ( *destroy )( void * ) noexcept;
+		};
+
+		template<typename Fn>
+		struct inline_ops {
+			static R invoke( void *p, Args &&...args ) {
+				return std::invoke( *static_cast<Fn *>( p ),
+				                    std::forward<Args>( args )... );
+			}
+
+			static void move( void *dst, void *src ) noexcept {
+				::new( dst ) Fn( std::move( *static_cast<Fn *>( src ) ) );
+				static_cast<Fn *>( src )->~Fn( );
+			}
+
+			static void destroy( void *p ) noexcept {
+				static_cast<Fn *>( p )->~Fn( );
+			}
+
+			static constexpr vtable_t vtable{ &invoke, &move, &destroy };
+		};
+
+		template<typename Fn>
+		struct heap_ops {
+			static Fn *&get( void *p ) {
+				return *static_cast<Fn **>( p );
+			}
+
+			static R invoke( void *p, Args &&...args ) {
+				return std::invoke( *get( p ), std::forward<Args>( args )... );
+			}
+
+			static void move( void *dst, void *src ) noexcept {
+				::new( dst ) Fn *( get( src ) );
+			}
+
+			static void destroy( void *p ) noexcept {
+				delete get( p );
+			}
+
+			static constexpr vtable_t vtable{ &invoke, &move, &destroy };
+		};
+
+		alignas( std::max_align_t ) unsigned char m_storage[Capacity];
+		vtable_t const *m_vtable = nullptr;
+
+		void reset( ) noexcept {
+			if( m_vtable ) {
+				m_vtable->destroy( m_storage );
+				m_vtable = nullptr;
+			}
+		}
+
+	public:
+		template<typename Fn>
+		static constexpr bool fits_inline =
+		  sizeof( Fn ) <= Capacity and
+		  alignof( Fn ) <= alignof( std::max_align_t ) and
+		  std::is_nothrow_move_constructible_v<Fn>;
+
+		unique_function( ) = default;
+		unique_function( std::nullptr_t ) noexcept {}
+
+		template<typename Fn,
+		         std::enable_if_t<
+		           not std::is_same_v<std::decay_t<Fn>, unique_function> and
+		             std::is_invocable_r_v<R, std::decay_t<Fn> &, Args...>,
+		           std::nullptr_t> = nullptr>
+		unique_function( Fn &&fn ) {
+			using func_t = std::decay_t<Fn>;
+			if constexpr( fits_inline<func_t> ) {
+				::new( static_cast<void *>( m_storage ) )
+				  func_t( std::forward<Fn>( fn ) );
+				m_vtable = &inline_ops<func_t>::vtable;
+			} else {
+				::new( static_cast<void *>( m_storage ) )
+				  func_t *( new func_t( std::forward<Fn>( fn ) ) );
+				m_vtable = &heap_ops<func_t>::vtable;
+			}
+		}
+
+		unique_function( unique_function &&other ) noexcept
+		  : m_vtable( std::exchange( other.m_vtable, nullptr ) ) {
+			if( m_vtable ) {
+				m_vtable->move( m_storage, other.m_storage );
+			}
+		}
+
+		unique_function &operator=( unique_function &&rhs ) noexcept {
+			if( this != &rhs ) {
+				reset( );
+				m_vtable = std::exchange( rhs.m_vtable, nullptr );
+				if( m_vtable ) {
+					m_vtable->move( m_storage, rhs.m_storage );
+				}
+			}
+			return *this;
+		}
+
+		unique_function( unique_function const & ) = delete;
+		unique_function &operator=( unique_function const & ) = delete;
+
+		~unique_function( ) {
+			reset( );
+		}
+
+		explicit operator bool( ) const noexcept {
+			return m_vtable != nullptr;
+		}
+
+		R operator( )( Args... args ) {
+			if( not m_vtable ) {
+				throw std::bad_function_call( );
+			}
+			return m_vtable->invoke( m_storage, std::forward<Args>( args )... );
+		}
+	};
+} // namespace daw
@@ -0,0 +1,111 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "../network_exception.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utility>
+
+#if defined( __linux__ )
+#include <sys/eventfd.h>
+#endif
+
+namespace daw::networking::details {
+	/***
+	 * An fd that becomes readable once notify( ) is called, so an io task can
+	 * wait for work done on another thread with io_request::wait_readable.
+	 * An eventfd on Linux and a pipe elsewhere
+	 */
+	class wakeup_fd {
+		int m_read = -1;
+		int m_write = -1;
+
+	public:
+		wakeup_fd( ) {
+#if defined( __linux__ )
+			m_read = m_write = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+			if( m_read < 0 ) {
+				throw network_exception( "Error creating eventfd", errno );
+			}
+#else
+			int fds[2];
+			if( ::pipe( fds ) < 0 ) {
+				throw network_exception( "Error creating pipe", errno );
+			}
+			for( int fd : fds ) {
+				(void)::fcntl( fd, F_SETFL, ::fcntl( fd, F_GETFL ) | O_NONBLOCK );
+				(void)::fcntl( fd, F_SETFD, FD_CLOEXEC );
+			}
+			m_read = fds[0];
+			m_write = fds[1];
+#endif
+		}
+
+		wakeup_fd( wakeup_fd const & ) = delete;
+		wakeup_fd &operator=( wakeup_fd const & ) = delete;
+
+		~wakeup_fd( ) {
+			(void)::close( m_read );
+			if( m_write != m_read ) {
+				(void)::close( m_write );
+			}
+		}
+
+		/// The fd to wait on
+		int fd( ) const {
+			return m_read;
+		}
+
+		void notify( ) {
+			std::uint64_t const one = 1;
+			(void)::write( m_write, &one, sizeof( one ) );
+		}
+
+		/// Consume every notify( ) so far, making the fd unreadable again
+		void drain( ) {
+			std::uint64_t value = 0;
+			while( ::read( m_read, &value, sizeof( value ) ) > 0 ) {}
+		}
+
+		/***
+		 * Signals the wakeup_fd through its own copy of the descriptor, so it
+		 * can outlive the wakeup_fd, e.g. in a continuation that may run after
+		 * the waiting task has gone
+		 */
+		class notifier {
+			int m_fd;
+
+		public:
+			explicit notifier( int fd )
+			  : m_fd( ::fcntl( fd, F_DUPFD_CLOEXEC, 0 ) ) {}
+
+			notifier( notifier &&other ) noexcept
+			  : m_fd( std::exchange( other.m_fd, -1 ) ) {}
+
+			notifier &operator=( notifier && ) = delete;
+
+			~notifier( ) {
+				if( m_fd >= 0 ) {
+					(void)::close( m_fd );
+				}
+			}
+
+			void notify( ) const {
+				std::uint64_t const one = 1;
+				(void)::write( m_fd, &one, sizeof( one ) );
+			}
+		};
+
+		notifier make_notifier( ) const {
+			return notifier( m_write );
+		}
+	};
+} // namespace daw::networking::details
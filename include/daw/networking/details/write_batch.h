@@ -0,0 +1,153 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "../async_result.h"
+
+#include <daw/daw_span.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <mutex>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <utility>
+#include <vector>
+
+namespace daw::networking::details {
+	/***
+	 * The writes a coalescing socket has queued for its flush task.  Writers
+	 * add to the batch from any thread while the flush task sends everything
+	 * queued so far with one sendmsg, so a burst of small writes becomes a few
+	 * large sends.  Each write still completes on its own once all of its
+	 * bytes are accepted.  A batch stops taking writes when the flush task
+	 * finds it empty or another kind of send is queued behind it, and the
+	 * next write then starts a new batch
+	 */
+	class write_batch {
+		struct pending_write {
+			daw::span<char const> buffer;
+			async_state_ptr<void> state;
+		};
+
+		std::mutex m_mutex{ };
+		std::vector<pending_write> m_queued{ };
+		bool m_accepting = true;
+		// Only used by the flush task
+		std::vector<pending_write> m_sending{ };
+		std::size_t m_first = 0;
+		std::vector<::iovec> m_iov{ };
+		::msghdr m_msg{ };
+		int m_flags;
+
+	public:
+		explicit write_batch( int flags )
+		  : m_flags( flags ) {}
+
+		int flags( ) const {
+			return m_flags;
+		}
+
+		/***
+		 * Queue a non-empty write, false when the batch no longer takes them
+		 */
+		bool add( daw::span<char const> buffer, async_state_ptr<void> const &state ) {
+			auto const lck = std::unique_lock( m_mutex );
+			if( not m_accepting ) {
+				return false;
+			}
+			m_queued.push_back( pending_write{ buffer, state } );
+			return true;
+		}
+
+		/// Take no more writes, those queued are still sent
+		void close( ) {
+			auto const lck = std::unique_lock( m_mutex );
+			m_accepting = false;
+		}
+
+		/***
+		 * Move the queued writes behind those still being sent.  Returns false,
+		 * and stops taking writes, once there is nothing left to send
+		 */
+		bool refill( ) {
+			m_sending.erase( m_sending.begin( ),
+			                 m_sending.begin( ) +
+			                   static_cast<std::ptrdiff_t>( m_first ) );
+			m_first = 0;
+			auto const lck = std::unique_lock( m_mutex );
+			for( auto &w : m_queued ) {
+				m_sending.push_back( std::move( w ) );
+			}
+			m_queued.clear( );
+			if( m_sending.empty( ) ) {
+				m_accepting = false;
+				return false;
+			}
+			return true;
+		}
+
+		/***
+		 * The msghdr for the next sendmsg, at most IOV_MAX writes.  MSG_MORE is
+		 * set when writes remain past those, so the kernel does not push out a
+		 * short segment between the two sends
+		 */
+		std::pair<::msghdr *, int> next( ) {
+			auto const count = std::min<std::size_t>(
+			  m_sending.size( ) - m_first, static_cast<std::size_t>( IOV_MAX ) );
+			m_iov.clear( );
+			for( std::size_t n = m_first; n < m_first + count; ++n ) {
+				auto const &buffer = m_sending[n].buffer;
+				m_iov.push_back( ::iovec{
+				  const_cast<void *>( static_cast<void const *>( buffer.data( ) ) ),
+				  buffer.size( ) } );
+			}
+			m_msg = ::msghdr{ };
+			m_msg.msg_iov = m_iov.data( );
+			m_msg.msg_iovlen = count;
+			auto flags = m_flags;
+			if( m_first + count < m_sending.size( ) ) {
+				flags |= MSG_MORE;
+			}
+			return { &m_msg, flags };
+		}
+
+		/// Account for count bytes sent, completing the writes now fully sent
+		void advance( std::size_t count ) {
+			while( m_first < m_sending.size( ) ) {
+				auto &w = m_sending[m_first];
+				if( count < w.buffer.size( ) ) {
+					w.buffer.remove_prefix( count );
+					break;
+				}
+				count -= w.buffer.size( );
+				w.state->set_value( );
+				w.state = nullptr;
+				++m_first;
+			}
+		}
+
+		/// Fail every write not yet sent and take no more
+		void fail( int code ) {
+			auto queued = std::vector<pending_write>( );
+			{
+				auto const lck = std::unique_lock( m_mutex );
+				m_accepting = false;
+				queued.swap( m_queued );
+			}
+			for( std::size_t n = m_first; n < m_sending.size( ); ++n ) {
+				m_sending[n].state->set_error( "send error", code );
+			}
+			m_sending.clear( );
+			m_first = 0;
+			for( auto &w : queued ) {
+				w.state->set_error( "send error", code );
+			}
+		}
+	};
+} // namespace daw::networking::details
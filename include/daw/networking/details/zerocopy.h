@@ -0,0 +1,84 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "object_pool.h"
+
+#include <cstdint>
+#include <cstring>
+#include <linux/errqueue.h>
+#include <memory>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace daw::details {
+	/***
+	 * Reads MSG_ZEROCOPY completions from a socket's error queue.  Each
+	 * successful zerocopy send on a socket takes the next 32 bit sequence
+	 * number and the kernel reports ranges of them once it no longer
+	 * references their buffers
+	 */
+	class zerocopy_notification {
+		::msghdr m_msg{ };
+		alignas( ::cmsghdr ) unsigned char m_control[CMSG_SPACE(
+		  sizeof( ::sock_extended_err ) + sizeof( ::sockaddr_in6 ) )];
+
+	public:
+		/// The msghdr for a recv_errqueue request
+		::msghdr *msg( ) {
+			m_msg = ::msghdr{ };
+			m_msg.msg_control = m_control;
+			m_msg.msg_controllen = sizeof( m_control );
+			return &m_msg;
+		}
+
+		/// true when sequence number a comes before b, allowing for wrap around
+		static constexpr bool precedes( std::uint32_t a, std::uint32_t b ) {
+			return static_cast<std::int32_t>( a - b ) < 0;
+		}
+
+		/***
+		 * Apply the message last read to released, the sequence number after the
+		 * last released send.  Returns 0 or the -errno of a socket error that was
+		 * queued instead
+		 */
+		int update( std::uint32_t &released ) const {
+			auto const *msg = &m_msg;
+			for( auto *cm = CMSG_FIRSTHDR( msg ); cm != nullptr;
+			     cm = CMSG_NXTHDR( const_cast<::msghdr *>( msg ), cm ) ) {
+				bool const is_recverr =
+				  ( cm->cmsg_level == SOL_IP and cm->cmsg_type == IP_RECVERR ) or
+				  ( cm->cmsg_level == SOL_IPV6 and cm->cmsg_type == IPV6_RECVERR );
+				if( not is_recverr ) {
+					continue;
+				}
+				auto err = ::sock_extended_err{ };
+				std::memcpy( &err, CMSG_DATA( cm ), sizeof( err ) );
+				if( err.ee_errno != 0 ) {
+					return -static_cast<int>( err.ee_errno );
+				}
+				if( err.ee_origin == SO_EE_ORIGIN_ZEROCOPY ) {
+					// ee_info to ee_data inclusive, the code says if the kernel copied
+					std::uint32_t const next = err.ee_data + 1U;
+					if( precedes( released, next ) ) {
+						released = next;
+					}
+				}
+			}
+			return 0;
+		}
+	};
+
+	using zerocopy_notification_ptr =
+	  std::unique_ptr<zerocopy_notification,
+	                  pool_recycler<zerocopy_notification>>;
+
+	inline zerocopy_notification_ptr make_zerocopy_notification( ) {
+		return zerocopy_notification_ptr(
+		  object_pool<zerocopy_notification>::acquire( ) );
+	}
+} // namespace daw::details
@@ -0,0 +1,123 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "async_exec_policy_thread.h"
+#include "async_result.h"
+#include "socket_address.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace daw::networking {
+	/***
+	 * The addresses a name resolved to, with port 0.  Every lookup served from
+	 * the same cache entry shares the list
+	 */
+	using address_list = std::shared_ptr<std::vector<socket_address> const>;
+
+	/***
+	 * What a lookup source found.  error is 0 or an EAI_* code from netdb.h, and
+	 * a ttl of 0 uses the resolver's default
+	 */
+	struct dns_answer {
+		std::vector<socket_address> addresses{ };
+		int error = 0;
+		std::chrono::milliseconds ttl{ 0 };
+	};
+
+	struct dns_resolver_options {
+		// How long found addresses are served from the cache
+		std::chrono::milliseconds positive_ttl = std::chrono::seconds( 30 );
+		// How long a failed lookup is, so a missing name is not retried per call
+		std::chrono::milliseconds negative_ttl = std::chrono::seconds( 5 );
+		// Threads running the blocking lookups
+		std::size_t worker_count = 2;
+		// Past this many names expired entries are dropped
+		std::size_t max_entries = 4096;
+	};
+
+	/***
+	 * Resolves names off the calling thread and caches the answers.  Lookups
+	 * run on worker threads, concurrent ones for the same name share a single
+	 * lookup, and answers, failures included, are served from the cache until
+	 * their ttl runs out.  Numeric hosts complete right away
+	 */
+	class dns_resolver {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		/***
+		 * A blocking lookup of host for the family and socket type, run on a
+		 * worker thread
+		 */
+		using lookup_function = std::function<dns_answer(
+		  std::string const &host, address_family af, socket_types st )>;
+
+	private:
+		struct entry {
+			address_list addresses{ };
+			int error = 0;
+			clock::time_point expires{ };
+			bool pending = false;
+			std::vector<async_state_ptr<address_list>> waiters{ };
+		};
+
+		dns_resolver_options m_options;
+		lookup_function m_lookup;
+		std::mutex m_mutex{ };
+		std::unordered_map<std::string, entry> m_cache{ };
+		std::atomic<std::size_t> m_next_worker = 0;
+		// Last so that running lookups finish before the cache goes away
+		std::vector<std::unique_ptr<async_exec_policy_thread>> m_workers{ };
+
+		void finish_lookup( std::string const &key, dns_answer answer );
+		void drop_expired( clock::time_point now );
+
+	public:
+		explicit dns_resolver( dns_resolver_options options = { },
+		                       lookup_function lookup = &system_lookup );
+
+		dns_resolver( dns_resolver const & ) = delete;
+		dns_resolver &operator=( dns_resolver const & ) = delete;
+
+		/***
+		 * The addresses of host, from the cache when it holds a live answer.  A
+		 * failure has the EAI_* code of the lookup as its error code
+		 */
+		[[nodiscard]] async_result<address_list>
+		resolve( std::string_view host,
+		         address_family af = address_family::Unspecified,
+		         socket_types st = socket_types::Stream );
+
+		/// Forget every cached answer, lookups in flight still complete
+		void clear( );
+
+		/***
+		 * Look host up with getaddrinfo.  An empty host is the loopback address
+		 */
+		static dns_answer system_lookup( std::string const &host,
+		                                 address_family af, socket_types st );
+
+		/***
+		 * A lookup source answering from text in the /etc/hosts format, lines of
+		 * an address followed by its names with # starting a comment
+		 */
+		static lookup_function hosts_lookup( std::string_view hosts );
+
+		/// The resolver sockets use unless given another
+		static dns_resolver &system( );
+	};
+} // namespace daw::networking
@@ -0,0 +1,206 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "details/unique_function.h"
+#include "third_party/jthread.hpp"
+
+#include <daw/daw_span.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+namespace daw::networking {
+	using io_clock = std::chrono::steady_clock;
+
+	enum class io_op_type : int {
+		none,
+		connect,
+		send,
+		recv,
+		sendmsg,
+		recvmsg,
+		recv_errqueue,
+		sendfile,
+		accept,
+		sendmmsg,
+		recvmmsg,
+		wait_readable
+	};
+
+	/***
+	 * What to wait for before retrying a request.  Error waits for POLLERR only,
+	 * which poll and epoll always report
+	 */
+	enum class io_event : short { Error = 0, Read = POLLIN, Write = POLLOUT };
+
+	/***
+	 * Describes the next system call an io_task needs.  The exec policy decides
+	 * how it is performed(e.g. blocking in poll or parking in an epoll set) and
+	 * hands the result back to the task
+	 */
+	struct io_request {
+		io_op_type op = io_op_type::none;
+		int fd = -1;
+		void *buffer = nullptr;
+		std::size_t size = 0;
+		int flags = 0;
+		// Set by the exec policy once a connect has returned EINPROGRESS
+		bool in_progress = false;
+		// The file and offset a sendfile reads from
+		int src_fd = -1;
+		::off_t offset = 0;
+		// Waiting for the fd past this fails the request with -ETIMEDOUT
+		io_clock::time_point deadline = io_clock::time_point::max( );
+
+		// A stop requested on it abandons the request with -ECANCELED.  It is
+		// owned by the task and outlives the request
+		std::stop_token const *stop = nullptr;
+
+		bool has_deadline( ) const {
+			return deadline != io_clock::time_point::max( );
+		}
+
+		bool stop_requested( ) const {
+			return stop != nullptr and stop->stop_requested( );
+		}
+
+		static inline io_request send( int fd, daw::span<char const> buffer,
+		                               int flags ) {
+			return { io_op_type::send, fd, const_cast<char *>( buffer.data( ) ),
+			         buffer.size( ), flags };
+		}
+
+		static inline io_request recv( int fd, daw::span<char> buffer,
+		                               int flags ) {
+			return { io_op_type::recv, fd, buffer.data( ), buffer.size( ), flags };
+		}
+
+		/// Scatter/gather send of the msghdr, which must outlive the request
+		static inline io_request sendmsg( int fd, ::msghdr *msg, int flags ) {
+			return { io_op_type::sendmsg, fd, msg, 0, flags };
+		}
+
+		static inline io_request recvmsg( int fd, ::msghdr *msg, int flags ) {
+			return { io_op_type::recvmsg, fd, msg, 0, flags };
+		}
+
+#if defined( __linux__ )
+		/***
+		 * Send or receive up to count datagrams in one call.  The result is the
+		 * count of messages transferred
+		 */
+		static inline io_request sendmmsg( int fd, ::mmsghdr *msgs,
+		                                   std::size_t count, int flags ) {
+			return { io_op_type::sendmmsg, fd, msgs, count, flags };
+		}
+
+		static inline io_request recvmmsg( int fd, ::mmsghdr *msgs,
+		                                   std::size_t count, int flags ) {
+			return { io_op_type::recvmmsg, fd, msgs, count, flags };
+		}
+#endif
+
+		/***
+		 * Read one message from the socket's error queue, e.g. MSG_ZEROCOPY
+		 * notifications, into the msghdr.  Waits for POLLERR only
+		 */
+		static inline io_request recv_errqueue( int fd, ::msghdr *msg ) {
+			return { io_op_type::recv_errqueue, fd, msg, 0, 0 };
+		}
+
+		/// Send up to count bytes of src_fd, starting at offset, with sendfile
+		static inline io_request sendfile( int fd, int src_fd, ::off_t offset,
+		                                   std::size_t count ) {
+			auto req = io_request{ io_op_type::sendfile, fd, nullptr, count, 0 };
+			req.src_fd = src_fd;
+			req.offset = offset;
+			return req;
+		}
+
+		/***
+		 * Accept as many waiting connections as fit in fds, as nonblocking
+		 * close on exec sockets.  The result is the count accepted
+		 */
+		static inline io_request accept( int fd, daw::span<int> fds ) {
+			return { io_op_type::accept, fd, fds.data( ), fds.size( ), 0 };
+		}
+
+		/***
+		 * No io, completes with 0 once fd is readable.  e.g. to park a task on an
+		 * eventfd until another thread signals it
+		 */
+		static inline io_request wait_readable( int fd ) {
+			return { io_op_type::wait_readable, fd, nullptr, 0, 0 };
+		}
+
+		static inline io_request connect( int fd, ::sockaddr const *addr,
+		                                  ::socklen_t addr_len ) {
+			return { io_op_type::connect, fd, const_cast<::sockaddr *>( addr ),
+			         static_cast<std::size_t>( addr_len ), 0 };
+		}
+
+		constexpr explicit operator bool( ) const {
+			return op != io_op_type::none;
+		}
+	};
+
+	/***
+	 * An asynchronous operation.  It is called first with 0 and then with the
+	 * result of each io_request it returns, negative results are -errno.  The
+	 * task is finished when it returns an empty io_request.  A task the exec
+	 * policy drops before it finishes, e.g. while shutting down, is called with
+	 * -ECANCELED instead and must finish without making a request.  Tasks are
+	 * move only and the socket operations fit in the inline storage
+	 */
+	using io_task = unique_function<io_request( ::ssize_t )>;
+
+	/// An io_task that calls tsk once and needs no io.  A dropped tsk never runs
+	template<typename Task>
+	io_task make_io_task( Task &&tsk ) {
+		return
+		  [tsk = std::forward<Task>( tsk )]( ::ssize_t r ) mutable -> io_request {
+			  if( r >= 0 ) {
+				  tsk( );
+			  }
+			  return { };
+		  };
+	}
+
+	/***
+	 * Finish a dropped task with -ECANCELED.  Called without any lock held as
+	 * the task completes its operation
+	 */
+	inline void cancel_io_task( io_task tsk ) noexcept {
+		try {
+			while( tsk( -ECANCELED ) ) {}
+		} catch( ... ) {}
+	}
+
+	namespace details {
+		/***
+		 * Attempt the request without blocking.  An empty result means the fd is
+		 * not ready and the caller must wait for wait_event( req ) before retrying
+		 */
+		std::optional<::ssize_t> perform_nonblocking( io_request &req );
+
+		io_event wait_event( io_request const &req );
+
+		/***
+		 * Perform the request, blocking in poll until the fd is ready.  Fails
+		 * with -ETIMEDOUT once the request's deadline passes and -ECANCELED once
+		 * a stop is requested on its token
+		 */
+		::ssize_t perform_blocking( io_request &req );
+	} // namespace details
+} // namespace daw::networking
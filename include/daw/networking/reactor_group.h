@@ -0,0 +1,62 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace daw {
+	/***
+	 * A fixed set of reactors that sockets are spread across round robin
+	 */
+	template<typename Reactor>
+	class reactor_group {
+		std::vector<std::unique_ptr<Reactor>> m_reactors;
+		std::atomic<std::size_t> m_next = 0;
+
+	public:
+		/// Each reactor is constructed from reactor_args, e.g. a busy poll time
+		template<typename... ReactorArgs>
+		explicit reactor_group(
+		  std::size_t reactor_count = std::thread::hardware_concurrency( ),
+		  ReactorArgs const &...reactor_args ) {
+			reactor_count = std::max( reactor_count, std::size_t{ 1 } );
+			m_reactors.reserve( reactor_count );
+			for( std::size_t n = 0; n < reactor_count; ++n ) {
+				m_reactors.push_back( std::make_unique<Reactor>( reactor_args... ) );
+			}
+		}
+
+		Reactor &next( ) {
+			auto const idx = m_next.fetch_add( 1, std::memory_order_relaxed );
+			return *m_reactors[idx % m_reactors.size( )];
+		}
+
+		Reactor &operator[]( std::size_t idx ) {
+			return *m_reactors[idx];
+		}
+
+		std::size_t size( ) const {
+			return m_reactors.size( );
+		}
+
+		/***
+		 * The process wide group used by default constructed policies.  It has one
+		 * reactor per hardware thread
+		 */
+		static reactor_group &default_group( ) {
+			// Intentionally leaked so sockets destroyed during static destruction
+			// still have a reactor
+			static auto *group = new reactor_group( );
+			return *group;
+		}
+	};
+} // namespace daw
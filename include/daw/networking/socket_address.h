@@ -0,0 +1,154 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "network_exception.h"
+
+#include <arpa/inet.h>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace daw::networking {
+	enum class socket_types : int {
+		Stream = SOCK_STREAM,
+		Dgram = SOCK_DGRAM,
+		SeqPacket = SOCK_SEQPACKET,
+		Raw = SOCK_RAW
+	};
+
+	enum class address_family : int {
+		Unspecified = AF_UNSPEC,
+		Unix = AF_UNIX,
+		IPv4 = AF_INET,
+		IPv6 = AF_INET6
+	};
+
+	/***
+	 * A socket address, e.g. the peer of a datagram
+	 */
+	struct socket_address {
+		::sockaddr_storage storage{ };
+		::socklen_t size = 0;
+
+		/***
+		 * The address of a numeric IPv4 or IPv6 host, or nullopt when host is
+		 * not numeric.  No name lookup is done
+		 */
+		static std::optional<socket_address> try_numeric( std::string const &host,
+		                                                  std::uint16_t port ) {
+			auto result = socket_address( );
+			auto &v4 = reinterpret_cast<::sockaddr_in &>( result.storage );
+			if( ::inet_pton( AF_INET, host.c_str( ), &v4.sin_addr ) == 1 ) {
+				v4.sin_family = AF_INET;
+				v4.sin_port = htons( port );
+				result.size = sizeof( ::sockaddr_in );
+				return result;
+			}
+			auto &v6 = reinterpret_cast<::sockaddr_in6 &>( result.storage );
+			if( ::inet_pton( AF_INET6, host.c_str( ), &v6.sin6_addr ) == 1 ) {
+				v6.sin6_family = AF_INET6;
+				v6.sin6_port = htons( port );
+				result.size = sizeof( ::sockaddr_in6 );
+				return result;
+			}
+			return std::nullopt;
+		}
+
+		/***
+		 * The address of a numeric IPv4 or IPv6 host.  No name lookup is done
+		 */
+		static socket_address from_numeric( std::string const &host,
+		                                    std::uint16_t port ) {
+			if( auto result = try_numeric( host, port ) ) {
+				return *result;
+			}
+			throw network_exception( "Invalid numeric address", EINVAL );
+		}
+
+		/***
+		 * The address of a Unix domain socket at path.  A path starting with a
+		 * NUL is in the Linux abstract namespace and never touches the
+		 * filesystem
+		 */
+		static socket_address from_unix_path( std::string_view path ) {
+			auto result = socket_address( );
+			auto &un = reinterpret_cast<::sockaddr_un &>( result.storage );
+			if( path.empty( ) or path.size( ) >= sizeof( un.sun_path ) ) {
+				throw network_exception( "Invalid unix socket path", ENAMETOOLONG );
+			}
+			un.sun_family = AF_UNIX;
+			std::memcpy( un.sun_path, path.data( ), path.size( ) );
+			// Abstract names are not NUL terminated, their length is the size
+			result.size = static_cast<::socklen_t>(
+			  offsetof( ::sockaddr_un, sun_path ) + path.size( ) +
+			  ( path.front( ) == '\0' ? 0 : 1 ) );
+			return result;
+		}
+
+		address_family family( ) const {
+			return static_cast<address_family>( storage.ss_family );
+		}
+
+		/// The port of an IPv4 or IPv6 address, 0 otherwise
+		std::uint16_t port( ) const {
+			switch( storage.ss_family ) {
+			case AF_INET6:
+				return ntohs(
+				  reinterpret_cast<::sockaddr_in6 const &>( storage ).sin6_port );
+			case AF_INET:
+				return ntohs(
+				  reinterpret_cast<::sockaddr_in const &>( storage ).sin_port );
+			default:
+				return 0;
+			}
+		}
+
+		/// Set the port of an IPv4 or IPv6 address
+		void set_port( std::uint16_t port ) {
+			switch( storage.ss_family ) {
+			case AF_INET6:
+				reinterpret_cast<::sockaddr_in6 &>( storage ).sin6_port = htons( port );
+				break;
+			case AF_INET:
+				reinterpret_cast<::sockaddr_in &>( storage ).sin_port = htons( port );
+				break;
+			default:
+				break;
+			}
+		}
+
+		/// The path of a Unix domain address, abstract ones start with a NUL
+		std::string_view unix_path( ) const {
+			constexpr auto offset = offsetof( ::sockaddr_un, sun_path );
+			if( storage.ss_family != AF_UNIX or size <= offset ) {
+				return { };
+			}
+			auto const &un = reinterpret_cast<::sockaddr_un const &>( storage );
+			auto len = static_cast<std::size_t>( size ) - offset;
+			if( un.sun_path[0] != '\0' ) {
+				len = ::strnlen( un.sun_path, len );
+			}
+			return { un.sun_path, len };
+		}
+
+		::sockaddr *data( ) {
+			return reinterpret_cast<::sockaddr *>( &storage );
+		}
+
+		::sockaddr const *data( ) const {
+			return reinterpret_cast<::sockaddr const *>( &storage );
+		}
+	};
+} // namespace daw::networking
@@ -0,0 +1,127 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <type_traits>
+#include <vector>
+
+namespace daw::networking {
+	/// A socket option as setsockopt sees it, an int value at level and name
+	struct raw_socket_option {
+		int level;
+		int name;
+		int value;
+	};
+
+	using socket_option_list = std::vector<raw_socket_option>;
+
+	namespace socket_options {
+		/***
+		 * An option as a type, so the level, name and value type are checked at
+		 * compile time, e.g. set_option( socket_options::tcp_nodelay{ true } )
+		 */
+		template<int Level, int Name, typename Value>
+		struct basic_option {
+			static constexpr int level = Level;
+			static constexpr int name = Name;
+			using value_type = Value;
+
+			value_type value;
+
+			constexpr raw_socket_option raw( ) const {
+				return { Level, Name, static_cast<int>( value ) };
+			}
+
+			static constexpr value_type from_raw( int value ) {
+				if constexpr( std::is_same_v<value_type, bool> ) {
+					return value != 0;
+				} else {
+					return static_cast<value_type>( value );
+				}
+			}
+		};
+
+		/// Send small segments right away rather than holding them for Nagle
+		using tcp_nodelay = basic_option<IPPROTO_TCP, TCP_NODELAY, bool>;
+		using keep_alive = basic_option<SOL_SOCKET, SO_KEEPALIVE, bool>;
+		/// Bytes, the kernel doubles the value for its own bookkeeping
+		using send_buffer_size = basic_option<SOL_SOCKET, SO_SNDBUF, int>;
+		/***
+		 * Bytes, the kernel doubles the value.  Set it before connecting, the
+		 * window scale is fixed by the handshake
+		 */
+		using receive_buffer_size = basic_option<SOL_SOCKET, SO_RCVBUF, int>;
+#if defined( __linux__ )
+		/***
+		 * ACK right away instead of delaying it.  The kernel drops back to
+		 * delayed ACKs on its own, so it needs setting again to stay on
+		 */
+		using tcp_quickack = basic_option<IPPROTO_TCP, TCP_QUICKACK, bool>;
+		/// Microseconds a blocking receive busy polls the device queue for
+		using busy_poll = basic_option<SOL_SOCKET, SO_BUSY_POLL, int>;
+		/***
+		 * Bytes of unsent data past which the socket stops being writable,
+		 * keeping the send queue, and the latency of what is queued, short
+		 */
+		using tcp_notsent_lowat =
+		  basic_option<IPPROTO_TCP, TCP_NOTSENT_LOWAT, unsigned>;
+		/// Milliseconds unacknowledged data may wait before the connection fails
+		using tcp_user_timeout =
+		  basic_option<IPPROTO_TCP, TCP_USER_TIMEOUT, unsigned>;
+		/// The CPU whose receive queue a listener steers new connections from
+		using incoming_cpu = basic_option<SOL_SOCKET, SO_INCOMING_CPU, int>;
+#endif
+	} // namespace socket_options
+
+	namespace details {
+		/// Set each of options on fd, returning 0 or the errno of the first failure
+		inline int apply_socket_options( int fd, socket_option_list const &options ) {
+			for( auto const &option : options ) {
+				if( ::setsockopt( fd, option.level, option.name, &option.value,
+				                  sizeof( option.value ) ) < 0 ) {
+					return errno;
+				}
+			}
+			return 0;
+		}
+	} // namespace details
+
+	template<typename T>
+	inline constexpr bool is_socket_option_v = false;
+
+	template<int Level, int Name, typename Value>
+	inline constexpr bool
+	  is_socket_option_v<socket_options::basic_option<Level, Name, Value>> = true;
+
+	/***
+	 * Sets of options for a kind of traffic, for set_options on a socket or
+	 * client.  Applied before connecting they also cover the handshake
+	 */
+	namespace socket_profiles {
+		/// Request/response traffic, no Nagle or delayed ACKs and a short queue
+		inline socket_option_list low_latency( ) {
+			return {
+			  socket_options::tcp_nodelay{ true }.raw( ),
+#if defined( __linux__ )
+			  socket_options::tcp_quickack{ true }.raw( ),
+			  socket_options::tcp_notsent_lowat{ 16U * 1024U }.raw( ),
+#endif
+			};
+		}
+
+		/// Streaming large transfers, big buffers so the window can open up
+		inline socket_option_list bulk_throughput( int buffer_size = 4 * 1024 *
+		                                                             1024 ) {
+			return { socket_options::send_buffer_size{ buffer_size }.raw( ),
+			         socket_options::receive_buffer_size{ buffer_size }.raw( ) };
+		}
+	} // namespace socket_profiles
+} // namespace daw::networking
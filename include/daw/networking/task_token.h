@@ -6,21 +6,53 @@
 
 #pragma once
 
-#include <daw/parallel/daw_latch.h>
+#include "details/completion_flag.h"
+
+#include <chrono>
+#include <memory>
 
 namespace daw {
-	struct task_token : private daw::shared_latch {
-		inline task_token( )
-		  : daw::shared_latch( 1 ) {}
-
-		using daw::shared_latch::notify;
-		using daw::shared_latch::operator bool;
-		using daw::shared_latch::set_latch;
-		using daw::shared_latch::try_wait;
-		using daw::shared_latch::wait;
-		using daw::shared_latch::wait_for;
-		using daw::shared_latch::wait_until;
-	};
-}
+	/***
+	 * A one shot signal whose copies share state.  Waiting spins briefly and
+	 * then parks on a futex, rather than taking a mutex and condition variable
+	 */
+	class task_token {
+		std::shared_ptr<details::completion_flag> m_flag =
+		  std::make_shared<details::completion_flag>( );
+
+	public:
+		task_token( ) = default;
+
+		void notify( ) {
+			m_flag->set( );
+		}
+
+		void set_latch( ) {
+			m_flag->set( );
+		}
 
+		explicit operator bool( ) const {
+			return try_wait( );
+		}
 
+		[[nodiscard]] bool try_wait( ) const {
+			return m_flag->try_wait( );
+		}
+
+		void wait( ) const {
+			m_flag->wait( );
+		}
+
+		template<typename Rep, typename Period>
+		[[nodiscard]] bool
+		wait_for( std::chrono::duration<Rep, Period> const &rel_time ) const {
+			return m_flag->wait_for( rel_time );
+		}
+
+		template<typename Clock, typename Duration>
+		[[nodiscard]] bool wait_until(
+		  std::chrono::time_point<Clock, Duration> const &timeout_time ) const {
+			return m_flag->wait_until( timeout_time );
+		}
+	};
+} // namespace daw
@@ -8,44 +8,139 @@
 
 #include "async_result.h"
 #include "network_socket.h"
+#include "socket_options.h"
 #include <daw/daw_span.h>
 
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <string_view>
+#include <type_traits>
 
 namespace daw::networking {
-	struct shared_tcp_client;
+	template<typename ExecPolicy>
+	class basic_shared_tcp_client;
 
-	class unique_tcp_client {
-		std::unique_ptr<network_socket> m_socket;
+	/***
+	 * A TCP connection owned by one object, running its operations on
+	 * ExecPolicy
+	 */
+	template<typename ExecPolicy>
+	class basic_unique_tcp_client {
+	public:
+		using socket_type = basic_network_socket<ExecPolicy>;
+
+	private:
+		std::unique_ptr<socket_type> m_socket;
 
-		friend class ::daw::networking::shared_tcp_client;
+		friend class ::daw::networking::basic_shared_tcp_client<ExecPolicy>;
 
 	public:
-		unique_tcp_client( );
-		unique_tcp_client( std::string_view host, std::uint16_t port );
+		basic_unique_tcp_client( );
+		basic_unique_tcp_client( std::string_view host, std::uint16_t port );
+
+		/// Wrap an open socket, e.g. a connection accepted by a tcp_server
+		explicit basic_unique_tcp_client( std::unique_ptr<socket_type> socket );
 
 		void connect( std::string_view host, std::uint16_t port );
 		void close( );
 
+		bool is_open( ) const {
+			return m_socket->is_open( );
+		}
+
+		/// See basic_network_socket::is_alive
+		bool is_alive( ) const {
+			return m_socket->is_alive( );
+		}
+
+		/// See basic_network_socket::set_write_coalescing
+		void set_write_coalescing( bool enabled ) {
+			m_socket->set_write_coalescing( enabled );
+		}
+
+		/// See basic_network_socket::set_timeout
+		void set_timeout( std::chrono::milliseconds timeout ) {
+			m_socket->set_timeout( timeout );
+		}
+
+		/// See basic_network_socket::set_option
+		template<typename Option,
+		         std::enable_if_t<is_socket_option_v<Option>, std::nullptr_t> =
+		           nullptr>
+		void set_option( Option const &option ) {
+			m_socket->set_option( option );
+		}
+
+		/***
+		 * Apply a set of options, e.g. socket_profiles::low_latency( ) before
+		 * connecting
+		 */
+		void set_options( socket_option_list const &options ) {
+			m_socket->set_options( options );
+		}
+
+		template<typename Option,
+		         std::enable_if_t<is_socket_option_v<Option>, std::nullptr_t> =
+		           nullptr>
+		[[nodiscard]] typename Option::value_type get_option( ) const {
+			return m_socket->template get_option<Option>( );
+		}
+
+		/***
+		 * The operations that take a stop token fail with ECANCELED once a stop
+		 * is requested, see basic_network_socket::connect_async
+		 */
 		async_result<void> connect_async( std::string_view host,
-		                                  std::uint16_t port );
+		                                  std::uint16_t port,
+		                                  std::stop_token stop = { } );
 
 		async_result<void> connect_async( std::string_view host, std::uint16_t port,
-		                                  std::function<void( )> on_completion );
+		                                  std::function<void( )> on_completion,
+		                                  std::stop_token stop = { } );
 
 		async_result<void> close_async( );
 
 		std::size_t write( daw::span<char const> buffer );
-		async_result<void> write_async( daw::span<char const> buffer );
+		async_result<void> write_async( daw::span<char const> buffer,
+		                                std::stop_token stop = { } );
+		/// Gather write of a range of daw::span<char const>
+		template<typename Buffers,
+		         std::enable_if_t<
+		           ::daw::details::is_buffer_sequence_v<Buffers, char const>,
+		           std::nullptr_t> = nullptr>
+		async_result<void> write_async( Buffers const &buffers,
+		                                std::stop_token stop = { } ) {
+			return m_socket->send_async( buffers, 0, std::move( stop ) );
+		}
 		async_result<void> write_async(
 		  daw::span<char const> buffer,
 		  std::function<std::optional<daw::span<char const>>( daw::span<char const>,
 		                                                      std::size_t )>
 		    on_completion );
+#if defined( __linux__ )
+		/// See basic_network_socket::send_zerocopy_async
+		async_result<void> write_zerocopy_async( daw::span<char const> buffer );
+		async_result<std::size_t> write_file_async( int fd, ::off_t offset,
+		                                            std::size_t count,
+		                                            std::stop_token stop = { } );
+#endif
 		std::size_t read( daw::span<char> buffer );
-		async_result<std::size_t> read_async( daw::span<char> buffer );
+		async_result<std::size_t> read_async( daw::span<char> buffer,
+		                                      std::stop_token stop = { } );
+		/// See basic_network_socket::receive_some_async
+		async_result<std::size_t> read_some_async( daw::span<char> buffer,
+		                                           std::stop_token stop = { } );
+		/// Scatter read into a range of daw::span<char>
+		template<
+		  typename Buffers,
+		  std::enable_if_t<::daw::details::is_buffer_sequence_v<Buffers, char>,
+		                   std::nullptr_t> = nullptr>
+		async_result<std::size_t> read_async( Buffers const &buffers,
+		                                      std::stop_token stop = { } ) {
+			return m_socket->receive_async( buffers, 0, std::move( stop ) );
+		}
 		async_result<void>
 		read_async( daw::span<char> buffer,
 		            std::function<std::optional<daw::span<char>>( daw::span<char>,
@@ -53,34 +148,122 @@ namespace daw::networking {
 		              on_completion );
 	};
 
-	class shared_tcp_client {
-		std::shared_ptr<network_socket> m_socket;
+	/***
+	 * A TCP connection with shared ownership, running its operations on
+	 * ExecPolicy
+	 */
+	template<typename ExecPolicy>
+	class basic_shared_tcp_client {
+	public:
+		using socket_type = basic_network_socket<ExecPolicy>;
+
+	private:
+		std::shared_ptr<socket_type> m_socket;
 
 	public:
-		shared_tcp_client( );
-		shared_tcp_client( std::string_view host, std::uint16_t port );
-		explicit shared_tcp_client( unique_tcp_client &&other );
+		basic_shared_tcp_client( );
+		basic_shared_tcp_client( std::string_view host, std::uint16_t port );
+		explicit basic_shared_tcp_client(
+		  basic_unique_tcp_client<ExecPolicy> &&other );
 
 		void connect( std::string_view host, std::uint16_t port );
 		void close( );
 
+		bool is_open( ) const {
+			return m_socket->is_open( );
+		}
+
+		/// See basic_network_socket::is_alive
+		bool is_alive( ) const {
+			return m_socket->is_alive( );
+		}
+
+		/// See basic_network_socket::set_write_coalescing
+		void set_write_coalescing( bool enabled ) {
+			m_socket->set_write_coalescing( enabled );
+		}
+
+		/// See basic_network_socket::set_timeout
+		void set_timeout( std::chrono::milliseconds timeout ) {
+			m_socket->set_timeout( timeout );
+		}
+
+		/// See basic_network_socket::set_option
+		template<typename Option,
+		         std::enable_if_t<is_socket_option_v<Option>, std::nullptr_t> =
+		           nullptr>
+		void set_option( Option const &option ) {
+			m_socket->set_option( option );
+		}
+
+		/***
+		 * Apply a set of options, e.g. socket_profiles::low_latency( ) before
+		 * connecting
+		 */
+		void set_options( socket_option_list const &options ) {
+			m_socket->set_options( options );
+		}
+
+		template<typename Option,
+		         std::enable_if_t<is_socket_option_v<Option>, std::nullptr_t> =
+		           nullptr>
+		[[nodiscard]] typename Option::value_type get_option( ) const {
+			return m_socket->template get_option<Option>( );
+		}
+
+		/***
+		 * The operations that take a stop token fail with ECANCELED once a stop
+		 * is requested, see basic_network_socket::connect_async
+		 */
 		async_result<void> connect_async( std::string_view host,
-		                                  std::uint16_t port );
+		                                  std::uint16_t port,
+		                                  std::stop_token stop = { } );
 
 		async_result<void> connect_async( std::string_view host, std::uint16_t port,
-		                                  std::function<void( )> on_completion );
+		                                  std::function<void( )> on_completion,
+		                                  std::stop_token stop = { } );
 
 		async_result<void> close_async( );
 
 		std::size_t write( daw::span<char const> buffer );
-		async_result<void> write_async( daw::span<char const> buffer );
+		async_result<void> write_async( daw::span<char const> buffer,
+		                                std::stop_token stop = { } );
+		/// Gather write of a range of daw::span<char const>
+		template<typename Buffers,
+		         std::enable_if_t<
+		           ::daw::details::is_buffer_sequence_v<Buffers, char const>,
+		           std::nullptr_t> = nullptr>
+		async_result<void> write_async( Buffers const &buffers,
+		                                std::stop_token stop = { } ) {
+			return m_socket->send_async( buffers, 0, std::move( stop ) );
+		}
 		async_result<void> write_async(
-			daw::span<char const> buffer,
-			std::function<std::optional<daw::span<char const>>( daw::span<char const>,
-																													std::size_t )>
-			on_completion );
+		  daw::span<char const> buffer,
+		  std::function<std::optional<daw::span<char const>>( daw::span<char const>,
+		                                                      std::size_t )>
+		    on_completion );
+#if defined( __linux__ )
+		/// See basic_network_socket::send_zerocopy_async
+		async_result<void> write_zerocopy_async( daw::span<char const> buffer );
+		async_result<std::size_t> write_file_async( int fd, ::off_t offset,
+		                                            std::size_t count,
+		                                            std::stop_token stop = { } );
+#endif
 		std::size_t read( daw::span<char> buffer );
-		async_result<std::size_t> read_async( daw::span<char> buffer );
+		async_result<std::size_t> read_async( daw::span<char> buffer,
+		                                      std::stop_token stop = { } );
+		/// See basic_network_socket::receive_some_async
+		async_result<std::size_t> read_some_async( daw::span<char> buffer,
+		                                           std::stop_token stop = { } );
+		/// Scatter read into a range of daw::span<char>
+		template<
+		  typename Buffers,
+		  std::enable_if_t<::daw::details::is_buffer_sequence_v<Buffers, char>,
+		                   std::nullptr_t> = nullptr>
+		async_result<std::size_t> read_async( Buffers const &buffers,
+		                                      std::stop_token stop = { } ) {
+			return m_socket->receive_async( buffers, 0, std::move( stop ) );
+		}
 		async_result<void>
 		read_async( daw::span<char> buffer,
 		            std::function<std::optional<daw::span<char>>( daw::span<char>,
@@ -88,14 +271,34 @@ namespace daw::networking {
 		              on_completion );
 	};
 
-	inline unique_tcp_client &operator<<( unique_tcp_client &client,
-	                                      std::string_view message ) {
+	// Instantiated in tcp_client.cpp
+	extern template class basic_unique_tcp_client<async_exec_policy_thread>;
+	extern template class basic_shared_tcp_client<async_exec_policy_thread>;
+
+	using unique_tcp_client = basic_unique_tcp_client<async_exec_policy_thread>;
+	using shared_tcp_client = basic_shared_tcp_client<async_exec_policy_thread>;
+
+#if defined( __linux__ )
+	extern template class basic_unique_tcp_client<async_exec_policy_epoll>;
+	extern template class basic_shared_tcp_client<async_exec_policy_epoll>;
+	extern template class basic_unique_tcp_client<async_exec_policy_uring>;
+	extern template class basic_shared_tcp_client<async_exec_policy_uring>;
+	extern template class basic_unique_tcp_client<async_exec_policy_pool>;
+	extern template class basic_shared_tcp_client<async_exec_policy_pool>;
+#endif
+
+	template<typename ExecPolicy>
+	basic_unique_tcp_client<ExecPolicy> &
+	operator<<( basic_unique_tcp_client<ExecPolicy> &client,
+	            std::string_view message ) {
 		client.write( { message.data( ), message.size( ) } );
 		return client;
 	}
 
-	inline shared_tcp_client &operator<<( shared_tcp_client &client,
-	                                      std::string_view message ) {
+	template<typename ExecPolicy>
+	basic_shared_tcp_client<ExecPolicy> &
+	operator<<( basic_shared_tcp_client<ExecPolicy> &client,
+	            std::string_view message ) {
 		client.write( { message.data( ), message.size( ) } );
 		return client;
 	}
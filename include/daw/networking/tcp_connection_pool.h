@@ -0,0 +1,317 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "async_result.h"
+#include "network_socket.h"
+#include "tcp_client.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace daw::networking {
+	struct tcp_connection_pool_options {
+		// Idle connections per endpoint that eviction leaves alone
+		std::size_t min_idle = 0;
+		// Most idle connections kept per endpoint, extra ones are closed
+		std::size_t max_idle = 8;
+		// Idle connections older than this are closed, down to min_idle
+		std::chrono::milliseconds idle_timeout = std::chrono::seconds( 60 );
+	};
+
+	/***
+	 * Keeps connected clients per host:port and leases them out, so requests
+	 * to the same endpoint skip the connect and TCP slow start.  A checkout
+	 * takes the most recently returned connection that is still alive, and
+	 * connects a new one when there is none.  Endpoints are spread over
+	 * independently locked shards so concurrent checkouts to different
+	 * endpoints do not contend, and sockets are only connected or closed
+	 * outside of a lock
+	 */
+	template<typename ExecPolicy>
+	class basic_tcp_connection_pool {
+	public:
+		using client_type = basic_unique_tcp_client<ExecPolicy>;
+		using socket_type = typename client_type::socket_type;
+		using clock = std::chrono::steady_clock;
+		/// Makes the unconnected socket of a new connection
+		using socket_factory = std::function<std::unique_ptr<socket_type>( )>;
+
+		static constexpr std::size_t shard_count = 16;
+
+	private:
+		struct idle_client {
+			client_type client;
+			clock::time_point since;
+		};
+
+		struct endpoint {
+			std::string host;
+			std::uint16_t port;
+			// Oldest first, checkouts take from the back
+			std::vector<idle_client> idle{ };
+		};
+
+		struct shard {
+			std::mutex mutex{ };
+			// Entries are never erased, so leases can point at them
+			std::unordered_map<std::string, endpoint> endpoints{ };
+		};
+
+		tcp_connection_pool_options m_options;
+		socket_factory m_make_socket;
+		std::array<shard, shard_count> m_shards{ };
+
+		static std::string key_of( std::string_view host, std::uint16_t port ) {
+			auto key = std::string( host );
+			key += ':';
+			key += std::to_string( port );
+			return key;
+		}
+
+		std::pair<shard *, endpoint *> find( std::string_view host,
+		                                     std::uint16_t port ) {
+			auto key = key_of( host, port );
+			auto &sh = m_shards[std::hash<std::string>{ }( key ) % shard_count];
+			auto const lck = std::unique_lock( sh.mutex );
+			auto pos = sh.endpoints.find( key );
+			if( pos == sh.endpoints.end( ) ) {
+				pos = sh.endpoints
+				        .emplace( std::move( key ),
+				                  endpoint{ std::string( host ), port } )
+				        .first;
+			}
+			return { &sh, &pos->second };
+		}
+
+		/***
+		 * Move the idle clients past idle_timeout, beyond min_idle, into
+		 * expired.  Called with the shard locked
+		 */
+		void take_expired( endpoint &ep, clock::time_point now,
+		                   std::vector<idle_client> &expired ) const {
+			std::size_t n = 0;
+			while( n < ep.idle.size( ) and
+			       ep.idle.size( ) - n > m_options.min_idle and
+			       now - ep.idle[n].since >= m_options.idle_timeout ) {
+				++n;
+			}
+			for( std::size_t i = 0; i < n; ++i ) {
+				expired.push_back( std::move( ep.idle[i] ) );
+			}
+			ep.idle.erase( ep.idle.begin( ), ep.idle.begin( ) +
+			                                   static_cast<std::ptrdiff_t>( n ) );
+		}
+
+		void release( shard &sh, endpoint &ep, client_type client ) {
+			if( not client.is_open( ) ) {
+				return;
+			}
+			auto dropped = std::vector<idle_client>( );
+			auto const now = clock::now( );
+			{
+				auto const lck = std::unique_lock( sh.mutex );
+				take_expired( ep, now, dropped );
+				if( ep.idle.size( ) < m_options.max_idle ) {
+					ep.idle.push_back( idle_client{ std::move( client ), now } );
+					return;
+				}
+			}
+			// client and dropped close here, outside of the lock
+		}
+
+		client_type new_client( ) {
+			return client_type( m_make_socket( ) );
+		}
+
+	public:
+		/***
+		 * A leased connection.  It goes back to the pool when the lease ends,
+		 * unless it was closed or discarded.  Only return a connection with no
+		 * response still in flight
+		 */
+		class lease {
+			basic_tcp_connection_pool *m_pool = nullptr;
+			shard *m_shard = nullptr;
+			endpoint *m_endpoint = nullptr;
+			std::optional<client_type> m_client{ };
+
+			friend class basic_tcp_connection_pool;
+
+			lease( basic_tcp_connection_pool &pool, shard &sh, endpoint &ep,
+			       client_type &&client )
+			  : m_pool( &pool )
+			  , m_shard( &sh )
+			  , m_endpoint( &ep )
+			  , m_client( std::move( client ) ) {}
+
+		public:
+			lease( lease &&other ) noexcept
+			  : m_pool( other.m_pool )
+			  , m_shard( other.m_shard )
+			  , m_endpoint( other.m_endpoint )
+			  , m_client( std::move( other.m_client ) ) {
+				other.m_client.reset( );
+			}
+
+			lease &operator=( lease &&rhs ) noexcept {
+				if( this != &rhs ) {
+					reset( );
+					m_pool = rhs.m_pool;
+					m_shard = rhs.m_shard;
+					m_endpoint = rhs.m_endpoint;
+					m_client = std::move( rhs.m_client );
+					rhs.m_client.reset( );
+				}
+				return *this;
+			}
+
+			~lease( ) {
+				reset( );
+			}
+
+			client_type &operator*( ) {
+				return *m_client;
+			}
+
+			client_type *operator->( ) {
+				return &*m_client;
+			}
+
+			/// Close the connection instead of returning it, e.g. after an error
+			void discard( ) {
+				m_client.reset( );
+			}
+
+			/// Return the connection to the pool now
+			void reset( ) {
+				if( m_client ) {
+					m_pool->release( *m_shard, *m_endpoint, std::move( *m_client ) );
+					m_client.reset( );
+				}
+			}
+		};
+
+		explicit basic_tcp_connection_pool(
+		  tcp_connection_pool_options options = { },
+		  socket_factory make_socket =
+		    [] {
+			    return std::make_unique<socket_type>( address_family::Unspecified,
+			                                          socket_types::Stream );
+		    } )
+		  : m_options( options )
+		  , m_make_socket( std::move( make_socket ) ) {}
+
+		basic_tcp_connection_pool( basic_tcp_connection_pool const & ) = delete;
+		basic_tcp_connection_pool &
+		operator=( basic_tcp_connection_pool const & ) = delete;
+
+		/***
+		 * Lease a connection to host and port, an idle one when it is still
+		 * alive or else a new one.  Connecting blocks the caller
+		 */
+		lease acquire( std::string_view host, std::uint16_t port ) {
+			auto const [sh, ep] = find( host, port );
+			auto dead = std::vector<idle_client>( );
+			while( true ) {
+				auto candidate = std::optional<client_type>( );
+				{
+					auto const lck = std::unique_lock( sh->mutex );
+					take_expired( *ep, clock::now( ), dead );
+					if( ep->idle.empty( ) ) {
+						break;
+					}
+					candidate.emplace( std::move( ep->idle.back( ).client ) );
+					ep->idle.pop_back( );
+				}
+				if( candidate->is_alive( ) ) {
+					return lease( *this, *sh, *ep, std::move( *candidate ) );
+				}
+			}
+			auto client = new_client( );
+			client.connect( ep->host, ep->port );
+			return lease( *this, *sh, *ep, std::move( client ) );
+		}
+
+		/***
+		 * Connect up to count idle connections to host and port, in parallel,
+		 * less those already idle and never past max_idle
+		 */
+		void prewarm( std::string_view host, std::uint16_t port,
+		              std::size_t count ) {
+			auto const [sh, ep] = find( host, port );
+			{
+				auto const lck = std::unique_lock( sh->mutex );
+				count = std::min( count, m_options.max_idle );
+				count = count > ep->idle.size( ) ? count - ep->idle.size( ) : 0;
+			}
+			auto clients = std::vector<client_type>( );
+			auto connects = std::vector<async_result<void>>( );
+			for( std::size_t n = 0; n < count; ++n ) {
+				clients.push_back( new_client( ) );
+				connects.push_back( clients.back( ).connect_async( host, port ) );
+			}
+			when_all( std::move( connects ) ).get( );
+			for( auto &client : clients ) {
+				release( *sh, *ep, std::move( client ) );
+			}
+		}
+
+		/// prewarm up to min_idle
+		void prewarm( std::string_view host, std::uint16_t port ) {
+			prewarm( host, port, m_options.min_idle );
+		}
+
+		/***
+		 * Close the connections idle for longer than idle_timeout, keeping
+		 * min_idle per endpoint.  Checkouts and returns already do this for
+		 * their endpoint
+		 */
+		void evict_idle( ) {
+			auto const now = clock::now( );
+			for( auto &sh : m_shards ) {
+				auto expired = std::vector<idle_client>( );
+				{
+					auto const lck = std::unique_lock( sh.mutex );
+					for( auto &kv : sh.endpoints ) {
+						take_expired( kv.second, now, expired );
+					}
+				}
+			}
+		}
+
+		/// The idle connections to host and port
+		std::size_t idle_count( std::string_view host, std::uint16_t port ) {
+			auto const [sh, ep] = find( host, port );
+			auto const lck = std::unique_lock( sh->mutex );
+			return ep->idle.size( );
+		}
+	};
+
+	using tcp_connection_pool =
+	  basic_tcp_connection_pool<async_exec_policy_thread>;
+#if defined( __linux__ )
+	using epoll_tcp_connection_pool =
+	  basic_tcp_connection_pool<async_exec_policy_epoll>;
+	using uring_tcp_connection_pool =
+	  basic_tcp_connection_pool<async_exec_policy_uring>;
+	using pool_tcp_connection_pool =
+	  basic_tcp_connection_pool<async_exec_policy_pool>;
+#endif
+} // namespace daw::networking
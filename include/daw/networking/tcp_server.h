@@ -0,0 +1,251 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "async_result.h"
+#include "network_socket.h"
+#include "socket_options.h"
+#include "tcp_client.h"
+
+#include <daw/daw_span.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <sys/socket.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace daw::networking {
+	namespace details {
+		/// Reactor reports the cpu it is pinned to, e.g. a pool_worker
+		template<typename Reactor, typename = void>
+		inline constexpr bool has_cpu_v = false;
+
+		template<typename Reactor>
+		inline constexpr bool has_cpu_v<
+		  Reactor, std::void_t<decltype( std::declval<Reactor const &>( ).cpu( ) )>> =
+		  true;
+	} // namespace details
+
+	/***
+	 * Accepts TCP connections on one listener shard per reactor.  The shards
+	 * bind the same port with SO_REUSEPORT so the kernel spreads incoming
+	 * connections across them.  Each wakeup drains a shard's backlog in one
+	 * batch, and every connection becomes a client that runs on the reactor
+	 * of the shard that accepted it.  Reactors is a group such as
+	 * epoll_reactor_group or work_stealing_pool
+	 */
+	template<typename ExecPolicy, typename Reactors>
+	class basic_tcp_server {
+	public:
+		using client_type = basic_unique_tcp_client<ExecPolicy>;
+		using socket_type = basic_network_socket<ExecPolicy>;
+
+		/***
+		 * Called with each new connection on the accepting shard's thread.  It
+		 * can be called from several shards at once and must not throw
+		 */
+		using connection_handler = std::function<void( client_type )>;
+
+		/// The most connections a shard accepts per wakeup
+		static constexpr std::size_t accept_batch = 64;
+
+	private:
+		using reactor_t = std::remove_reference_t<decltype(
+		  std::declval<Reactors &>( )[std::size_t{ }] )>;
+
+		struct shard {
+			reactor_t *home;
+			std::unique_ptr<socket_type> listener;
+			// The listener's, set once it is bound
+			address_family family = address_family::Unspecified;
+			std::array<int, accept_batch> fds{ };
+			std::optional<async_result<void>> accepting{ };
+
+			explicit shard( reactor_t &reactor )
+			  : home( &reactor )
+			  , listener( std::make_unique<socket_type>(
+			      address_family::Unspecified, socket_types::Stream, reactor ) ) {}
+		};
+
+		Reactors *m_reactors;
+		std::size_t m_shard_count;
+		std::vector<std::unique_ptr<shard>> m_shards{ };
+		connection_handler m_on_connection{ };
+		std::atomic<bool> m_stopping = false;
+		std::uint16_t m_port = 0;
+		bool m_steer = false;
+		// The reactor pinned to each cpu, when steering
+		std::vector<reactor_t *> m_by_cpu{ };
+
+		/// The reactor pinned to the cpu fd's packets arrive on, or fallback
+		reactor_t *reactor_for( int fd, reactor_t *fallback ) const {
+#if defined( __linux__ )
+			int cpu = -1;
+			auto len = static_cast<::socklen_t>( sizeof( cpu ) );
+			if( ::getsockopt( fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len ) == 0 and
+			    cpu >= 0 and static_cast<std::size_t>( cpu ) < m_by_cpu.size( ) and
+			    m_by_cpu[static_cast<std::size_t>( cpu )] != nullptr ) {
+				return m_by_cpu[static_cast<std::size_t>( cpu )];
+			}
+#else
+			(void)fd;
+#endif
+			return fallback;
+		}
+
+		/// Map each cpu to the reactor pinned to it
+		void map_cpus( ) {
+			m_by_cpu.clear( );
+			if constexpr( details::has_cpu_v<reactor_t> ) {
+				for( std::size_t n = 0; n < m_reactors->size( ); ++n ) {
+					auto &reactor = ( *m_reactors )[n];
+					if( reactor.cpu( ) < 0 ) {
+						continue;
+					}
+					auto const cpu = static_cast<std::size_t>( reactor.cpu( ) );
+					if( m_by_cpu.size( ) <= cpu ) {
+						m_by_cpu.resize( cpu + 1 );
+					}
+					if( m_by_cpu[cpu] == nullptr ) {
+						m_by_cpu[cpu] = &reactor;
+					}
+				}
+			}
+		}
+
+		/// Owns every fd in fds, those it does not hand out are closed
+		bool on_accepted( shard &sh, daw::span<int const> fds ) {
+			auto pending = details::owned_fds( fds );
+			while( not pending.empty( ) ) {
+				auto accepted = pending.take( );
+				int const fd = accepted.get( );
+				auto *home = m_steer ? reactor_for( fd, sh.home ) : sh.home;
+				auto sock = std::make_unique<socket_type>(
+				  adopt_socket{ fd }, sh.family, socket_types::Stream, *home );
+				(void)accepted.release( );
+				m_on_connection( client_type( std::move( sock ) ) );
+			}
+			return not m_stopping.load( std::memory_order_relaxed );
+		}
+
+	public:
+		/***
+		 * shard_count defaults to one listener per reactor in the group
+		 */
+		explicit basic_tcp_server( Reactors &reactors, std::size_t shard_count = 0 )
+		  : m_reactors( &reactors )
+		  , m_shard_count( shard_count == 0 ? reactors.size( ) : shard_count ) {}
+
+		basic_tcp_server( basic_tcp_server const & ) = delete;
+		basic_tcp_server &operator=( basic_tcp_server const & ) = delete;
+
+		/***
+		 * Keep each connection on the core its packets arrive on, so the
+		 * kernel's receive processing and the connection's tasks share a cache.
+		 * Every shard's listener sets SO_INCOMING_CPU to its reactor's cpu, and
+		 * the kernel prefers it for connections arriving there.  A connection
+		 * accepted elsewhere runs on the reactor pinned to its cpu.  Needs
+		 * reactors pinned to cores, such as a work_stealing_pool created with
+		 * pin_to_cores, and is set before listen
+		 */
+		void set_incoming_cpu_steering( bool enabled ) {
+			daw::exception::dbg_precondition_check( m_shards.empty( ),
+			                                        "Expecting a stopped server" );
+			m_steer = enabled;
+		}
+
+		~basic_tcp_server( ) {
+			close( );
+		}
+
+		/***
+		 * Bind every shard to host and port and start accepting.  With port 0
+		 * the first shard picks a free port and the others share it
+		 */
+		void listen( std::string_view host, std::uint16_t port,
+		             connection_handler on_connection, int backlog = SOMAXCONN ) {
+			daw::exception::dbg_precondition_check( m_shards.empty( ),
+			                                        "Expecting a stopped server" );
+			m_on_connection = std::move( on_connection );
+			m_stopping = false;
+			if( m_steer ) {
+				map_cpus( );
+			}
+			for( std::size_t n = 0; n < m_shard_count; ++n ) {
+				auto sh = std::make_unique<shard>(
+				  ( *m_reactors )[n % m_reactors->size( )] );
+#if defined( __linux__ )
+				if constexpr( details::has_cpu_v<reactor_t> ) {
+					if( m_steer and sh->home->cpu( ) >= 0 ) {
+						sh->listener->set_option(
+						  socket_options::incoming_cpu{ sh->home->cpu( ) } );
+					}
+				}
+#endif
+				sh->listener->bind( host, port, true );
+				sh->family = sh->listener->family( );
+				sh->listener->listen( backlog );
+				if( port == 0 ) {
+					port = sh->listener->local_port( );
+				}
+				m_shards.push_back( std::move( sh ) );
+			}
+			m_port = port;
+			for( auto &sh : m_shards ) {
+				sh->accepting = sh->listener->accept_async(
+				  sh->fds, [this, sh = sh.get( )]( daw::span<int const> fds ) {
+					  return on_accepted( *sh, fds );
+				  } );
+			}
+		}
+
+		/// The port being listened on
+		std::uint16_t port( ) const {
+			return m_port;
+		}
+
+		std::size_t shard_count( ) const {
+			return m_shard_count;
+		}
+
+		/***
+		 * Stop accepting and close the listeners.  Connections already handed
+		 * out are unaffected
+		 */
+		void close( ) {
+			m_stopping = true;
+			// Shutting a listener down wakes its accept with an error
+			for( auto &sh : m_shards ) {
+				(void)sh->listener->shutdown( shutdown_how::DisallowReceive );
+			}
+			for( auto &sh : m_shards ) {
+				if( sh->accepting ) {
+					sh->accepting->wait( );
+				}
+				sh->listener->close( );
+			}
+			m_shards.clear( );
+		}
+	};
+
+#if defined( __linux__ )
+	using epoll_tcp_server =
+	  basic_tcp_server<async_exec_policy_epoll, epoll_reactor_group>;
+	using uring_tcp_server =
+	  basic_tcp_server<async_exec_policy_uring, uring_reactor_group>;
+	using pool_tcp_server =
+	  basic_tcp_server<async_exec_policy_pool, daw::work_stealing_pool>;
+	using tcp_server = pool_tcp_server;
+#endif
+} // namespace daw::networking
@@ -0,0 +1,115 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "async_result.h"
+#include "network_socket.h"
+
+#include <daw/daw_span.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#if defined( __linux__ )
+namespace daw::networking {
+	/***
+	 * A UDP socket running its operations on ExecPolicy.  Sending opens the
+	 * socket when it has not been bound or connected.  The batch operations
+	 * move many datagrams per sendmmsg/recvmmsg call and the segment ones
+	 * offload splitting and coalescing equal sized datagrams to the kernel
+	 */
+	template<typename ExecPolicy>
+	class basic_udp_socket {
+	public:
+		using socket_type = basic_network_socket<ExecPolicy>;
+
+	private:
+		std::unique_ptr<socket_type> m_socket;
+
+	public:
+		/***
+		 * Any trailing arguments construct the exec policy, e.g. the reactor the
+		 * socket runs on
+		 */
+		template<typename... ExecArgs>
+		explicit basic_udp_socket( address_family af = address_family::IPv4,
+		                           ExecArgs &&...exec_args )
+		  : m_socket( std::make_unique<socket_type>(
+		      af, socket_types::Dgram, std::forward<ExecArgs>( exec_args )... ) ) {}
+
+		/// Receive datagrams sent to host and port
+		void bind( std::string_view host, std::uint16_t port,
+		           bool reuse_port = false ) {
+			m_socket->bind( host, port, reuse_port );
+		}
+
+		/// Send to, and only receive from, host and port by default
+		void connect( std::string_view host, std::uint16_t port ) {
+			m_socket->connect( host, port );
+		}
+
+		std::uint16_t local_port( ) const {
+			return m_socket->local_port( );
+		}
+
+		void close( ) {
+			m_socket->close( );
+		}
+
+		async_result<void> close_async( ) {
+			return m_socket->close_async( );
+		}
+
+		async_result<void> send_to_async( daw::span<char const> buffer,
+		                                  socket_address const &peer ) {
+			m_socket->open( );
+			return m_socket->send_to_async( buffer, peer );
+		}
+
+		/// See basic_network_socket::receive_from_async
+		async_result<std::size_t> receive_from_async( daw::span<char> buffer,
+		                                              socket_address &peer ) {
+			return m_socket->receive_from_async( buffer, peer );
+		}
+
+		/// See basic_network_socket::send_batch_async
+		async_result<std::size_t>
+		send_batch_async( daw::span<outgoing_datagram const> datagrams ) {
+			m_socket->open( );
+			return m_socket->send_batch_async( datagrams );
+		}
+
+		/// See basic_network_socket::receive_batch_async
+		async_result<std::size_t>
+		receive_batch_async( daw::span<datagram> datagrams ) {
+			return m_socket->receive_batch_async( datagrams );
+		}
+
+		/// See basic_network_socket::send_segments_async
+		async_result<void> send_segments_async( daw::span<char const> buffer,
+		                                        std::uint16_t segment_size,
+		                                        socket_address const &peer = { } ) {
+			m_socket->open( );
+			return m_socket->send_segments_async( buffer, segment_size, peer );
+		}
+
+		/// See basic_network_socket::receive_segments_async
+		async_result<datagram_segments>
+		receive_segments_async( daw::span<char> buffer ) {
+			return m_socket->receive_segments_async( buffer );
+		}
+	};
+
+	using udp_socket = basic_udp_socket<async_exec_policy_thread>;
+	using epoll_udp_socket = basic_udp_socket<async_exec_policy_epoll>;
+	using uring_udp_socket = basic_udp_socket<async_exec_policy_uring>;
+	using pool_udp_socket = basic_udp_socket<async_exec_policy_pool>;
+} // namespace daw::networking
+#endif
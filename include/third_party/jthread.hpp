@@ -4,6 +4,12 @@
 #ifndef JTHREAD_HPP
 #define JTHREAD_HPP
 
+// Use the standard library version when it has one
+#if __cplusplus > 201703L and __has_include( <stop_token> )
+#include <stop_token>
+#include <thread>
+#else
+
 #include "stop_token.hpp"
 #include <thread>
 #include <future>
@@ -170,4 +176,5 @@ inline void jthread::swap(jthread& t) noexcept {
 
 } // std
 
+#endif
 #endif // JTHREAD_HPP
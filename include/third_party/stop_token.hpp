@@ -1,6 +1,11 @@
 #pragma once
 // <stop_token> header
 
+// Use the standard library version when it has one
+#if __cplusplus > 201703L and __has_include( <stop_token> )
+#include <stop_token>
+#else
+
 #include <atomic>
 #include <thread>
 #include <type_traits>
@@ -564,3 +569,4 @@ template<typename _Callback>
   stop_callback(stop_token, _Callback) -> stop_callback<_Callback>;
 
 } // namespace std
+#endif
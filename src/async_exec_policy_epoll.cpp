@@ -0,0 +1,305 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/async_exec_policy_epoll.h"
+#include "daw/networking/network_exception.h"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utility>
+
+namespace daw {
+	namespace details {
+		namespace {
+			/***
+			 * Arm wait's registration of fd for everything its waiters wait for.
+			 * Called with wait's lock held
+			 */
+			int epoll_arm( int epoll_fd, shared_fd_wait &wait, int fd ) {
+				auto event = ::epoll_event{ };
+				event.events = EPOLLONESHOT;
+				for( std::size_t lane = 0; lane < wait.waiters.size( ); ++lane ) {
+					if( wait.waiters[lane] != nullptr ) {
+						event.events |= wait.events[lane];
+					}
+				}
+				event.data.ptr = &wait;
+				int const op = wait.fd == fd ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+				int r = ::epoll_ctl( epoll_fd, op, fd, &event );
+				if( r < 0 and errno == ENOENT ) {
+					r = ::epoll_ctl( epoll_fd, EPOLL_CTL_ADD, fd, &event );
+				} else if( r < 0 and errno == EEXIST ) {
+					r = ::epoll_ctl( epoll_fd, EPOLL_CTL_MOD, fd, &event );
+				}
+				if( r < 0 ) {
+					return -errno;
+				}
+				wait.fd = fd;
+				return 0;
+			}
+		} // namespace
+
+		/***
+		 * Both lanes normally wait on the socket's fd.  A lane can only move the
+		 * registration to another fd, e.g. a resolver's wakeup fd, while the
+		 * other lane is not parked, otherwise the request fails with -EBUSY.
+		 * Only exclusive tasks wait on other fds, and they run with the read
+		 * lane idle.  The old fd's registration is left disarmed rather than
+		 * removed, it may already be closed and its number reused
+		 */
+		std::optional<::ssize_t> epoll_start( int epoll_fd, io_strand &strand,
+		                                      strand_timers &timers ) {
+			auto &req = strand.request( );
+			if( auto result = networking::details::perform_nonblocking( req ) ) {
+				return result;
+			}
+			auto &wait = strand.owner( )->fd_wait( );
+			auto const lane = strand.lane( );
+			int const result = strand.park( [&]( ) {
+				if( req.stop_requested( ) ) {
+					return -ECANCELED;
+				}
+				auto const lck = std::unique_lock( wait.mutex );
+				if( wait.fd != req.fd and wait.waiters[1 - lane] != nullptr ) {
+					return -EBUSY;
+				}
+				wait.waiters[lane] = &strand;
+				// The poll and epoll event bits are the same on Linux
+				wait.events[lane] =
+				  static_cast<std::uint32_t>( networking::details::wait_event( req ) );
+				if( int const r = epoll_arm( epoll_fd, wait, req.fd ); r < 0 ) {
+					wait.waiters[lane] = nullptr;
+					return r;
+				}
+				if( req.has_deadline( ) ) {
+					timers.schedule( strand );
+				}
+				return 0;
+			} );
+			if( result < 0 ) {
+				// The fd cannot be waited on, hand the error to the task
+				return result;
+			}
+			return std::nullopt;
+		}
+
+		bool epoll_cancel( int epoll_fd, io_strand &strand,
+		                   strand_timers &timers ) {
+			epoll_remove( epoll_fd, strand );
+			(void)timers.release( strand );
+			return true;
+		}
+
+		/// Errors and hangups wake both lanes, each finds out with its own request
+		std::array<io_strand *, 2> epoll_woken( int epoll_fd, shared_fd_wait &wait,
+		                                        std::uint32_t events ) {
+			auto woken = std::array<io_strand *, 2>{ };
+			auto const lck = std::unique_lock( wait.mutex );
+			bool waiting = false;
+			for( std::size_t lane = 0; lane < woken.size( ); ++lane ) {
+				if( wait.waiters[lane] == nullptr ) {
+					continue;
+				}
+				if( ( events & ( wait.events[lane] | EPOLLERR | EPOLLHUP ) ) != 0 ) {
+					woken[lane] = std::exchange( wait.waiters[lane], nullptr );
+				} else {
+					waiting = true;
+				}
+			}
+			if( waiting ) {
+				(void)epoll_arm( epoll_fd, wait, wait.fd );
+			}
+			return woken;
+		}
+
+		/***
+		 * The strand's fd is still open, so a registration no one waits on is
+		 * removed or it would keep reporting errors and hangups
+		 */
+		void epoll_remove( int epoll_fd, io_strand &strand ) {
+			auto &wait = strand.owner( )->fd_wait( );
+			auto const lane = strand.lane( );
+			auto const lck = std::unique_lock( wait.mutex );
+			if( wait.waiters[lane] != &strand ) {
+				return;
+			}
+			wait.waiters[lane] = nullptr;
+			if( wait.waiters[1 - lane] != nullptr ) {
+				(void)epoll_arm( epoll_fd, wait, wait.fd );
+			} else {
+				(void)::epoll_ctl( epoll_fd, EPOLL_CTL_DEL, wait.fd, nullptr );
+				wait.fd = -1;
+			}
+		}
+	} // namespace details
+
+	epoll_reactor::epoll_reactor( std::chrono::microseconds busy_poll )
+	  : m_epoll( ::epoll_create1( EPOLL_CLOEXEC ) )
+	  , m_busy_poll( busy_poll ) {
+		if( m_epoll < 0 ) {
+			throw networking::network_exception( "Error creating epoll set", errno );
+		}
+		m_wake = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+		if( m_wake < 0 ) {
+			auto const err = errno;
+			(void)::close( m_epoll );
+			throw networking::network_exception( "Error creating eventfd", err );
+		}
+		auto ev = ::epoll_event{ };
+		ev.events = EPOLLIN;
+		ev.data.ptr = nullptr;
+		(void)::epoll_ctl( m_epoll, EPOLL_CTL_ADD, m_wake, &ev );
+		m_thread =
+		  std::jthread( [this]( std::stop_token should_stop ) { run( should_stop ); } );
+	}
+
+	epoll_reactor::~epoll_reactor( ) {
+		m_thread.request_stop( );
+		wake( );
+		if( m_thread.joinable( ) ) {
+			m_thread.join( );
+		}
+		(void)::close( m_wake );
+		(void)::close( m_epoll );
+	}
+
+	bool epoll_reactor::in_scheduler_thread( ) const {
+		return std::this_thread::get_id( ) == m_thread.get_id( );
+	}
+
+	void epoll_reactor::wake( ) {
+		std::uint64_t const one = 1;
+		(void)::write( m_wake, &one, sizeof( one ) );
+	}
+
+	/***
+	 * A reactor that is polling sees the strand on its next pass.  The fence
+	 * pairs with the one in run( ), so either the reactor sees the post before
+	 * it blocks or the post sees it has stopped polling
+	 */
+	void epoll_reactor::post( std::shared_ptr<details::io_strand> strand ) {
+		if( m_posted.push( std::move( strand ) ) and not in_scheduler_thread( ) ) {
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			if( not m_polling.load( std::memory_order_relaxed ) ) {
+				wake( );
+			}
+		}
+	}
+
+	void epoll_reactor::post_close( std::shared_ptr<details::io_strand> strand ) {
+		if( m_posted.push_close( std::move( strand ) ) ) {
+			wake( );
+		}
+	}
+
+	std::optional<::ssize_t> epoll_reactor::start( details::io_strand &strand ) {
+		return details::epoll_start( m_epoll, strand, m_timers );
+	}
+
+	bool epoll_reactor::cancel( details::io_strand &strand ) {
+		return details::epoll_cancel( m_epoll, strand, m_timers );
+	}
+
+	void epoll_reactor::interrupt( details::io_strand &strand ) {
+		m_timers.interrupt( strand );
+		if( not in_scheduler_thread( ) ) {
+			wake( );
+		}
+	}
+
+	void epoll_reactor::run( std::stop_token const &should_stop ) {
+		auto events = std::array<::epoll_event, 128>{ };
+		auto ready = std::vector<std::shared_ptr<details::io_strand>>( );
+		auto closing = std::vector<std::shared_ptr<details::io_strand>>( );
+		auto expired = std::vector<details::io_strand *>( );
+		auto last_event = std::chrono::steady_clock::now( );
+		while( not should_stop.stop_requested( ) ) {
+			int timeout = m_posted.empty( ) ? m_timers.wait_ms( ) : 0;
+			if( timeout != 0 and m_busy_poll.count( ) > 0 ) {
+				if( std::chrono::steady_clock::now( ) - last_event < m_busy_poll ) {
+					m_polling.store( true, std::memory_order_relaxed );
+					timeout = 0;
+				} else if( m_polling.load( std::memory_order_relaxed ) ) {
+					m_polling.store( false, std::memory_order_relaxed );
+					std::atomic_thread_fence( std::memory_order_seq_cst );
+					if( not m_posted.empty( ) ) {
+						timeout = 0;
+					}
+				}
+			}
+			int const count =
+			  ::epoll_wait( m_epoll, events.data( ), static_cast<int>( events.size( ) ),
+			                timeout );
+			if( count < 0 and errno != EINTR ) {
+				break;
+			}
+			for( int n = 0; n < count; ++n ) {
+				if( events[n].data.ptr == nullptr ) {
+					std::uint64_t value = 0;
+					(void)::read( m_wake, &value, sizeof( value ) );
+					continue;
+				}
+				details::epoll_dispatch( m_epoll, events[n], m_timers,
+				                         [&]( auto self ) {
+					                         ready.push_back( std::move( self ) );
+				                         } );
+			}
+			details::epoll_expire( m_epoll, m_timers, expired, [&]( auto self ) {
+				ready.push_back( std::move( self ) );
+			} );
+			m_posted.take( ready, closing );
+			if( m_busy_poll.count( ) > 0 and not ready.empty( ) ) {
+				last_event = std::chrono::steady_clock::now( );
+			}
+			for( auto &strand : ready ) {
+				strand->run( );
+			}
+			ready.clear( );
+			for( auto &strand : closing ) {
+				strand->close( );
+			}
+			closing.clear( );
+		}
+	}
+
+	async_exec_policy_epoll::async_exec_policy_epoll( )
+	  : async_exec_policy_epoll( epoll_reactor_group::default_group( ).next( ) ) {}
+
+	async_exec_policy_epoll::async_exec_policy_epoll( epoll_reactor &reactor )
+	  : m_strands( reactor ) {}
+
+	void async_exec_policy_epoll::add_io_task( networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::write,
+		                       std::move( tsk ) );
+	}
+
+	void async_exec_policy_epoll::add_read_io_task( networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::read,
+		                       std::move( tsk ) );
+	}
+
+	void async_exec_policy_epoll::add_exclusive_io_task(
+	  networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::exclusive,
+		                       std::move( tsk ) );
+	}
+
+	void async_exec_policy_epoll::interrupt( ) {
+		m_strands.interrupt( );
+	}
+
+	void async_exec_policy_epoll::wait( ) const {
+		m_strands.wait( );
+	}
+} // namespace daw
@@ -0,0 +1,338 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/async_exec_policy_pool.h"
+#include "daw/networking/async_exec_policy_epoll.h"
+#include "daw/networking/network_exception.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utility>
+
+namespace daw {
+	namespace {
+		// How many strands a busy worker runs between checks of its epoll set
+		constexpr std::size_t poll_interval = 32;
+		// Strands and events a worker has room for before its queues grow
+		constexpr std::size_t queue_reserve = 256;
+		constexpr std::size_t event_batch = 128;
+	} // namespace
+
+	pool_worker::pool_worker( work_stealing_pool &pool, std::size_t index,
+	                          cpu_affinity affinity )
+	  : m_pool( &pool )
+	  , m_index( index )
+	  , m_affinity( affinity )
+	  , m_epoll( ::epoll_create1( EPOLL_CLOEXEC ) ) {
+		if( m_epoll < 0 ) {
+			throw networking::network_exception( "Error creating epoll set", errno );
+		}
+		m_wake = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+		if( m_wake < 0 ) {
+			auto const err = errno;
+			(void)::close( m_epoll );
+			throw networking::network_exception( "Error creating eventfd", err );
+		}
+		auto ev = ::epoll_event{ };
+		ev.events = EPOLLIN;
+		ev.data.ptr = nullptr;
+		(void)::epoll_ctl( m_epoll, EPOLL_CTL_ADD, m_wake, &ev );
+	}
+
+	pool_worker::~pool_worker( ) {
+		m_thread.request_stop( );
+		wake( );
+		if( m_thread.joinable( ) ) {
+			m_thread.join( );
+		}
+		(void)::close( m_wake );
+		(void)::close( m_epoll );
+	}
+
+	void pool_worker::launch( ) {
+		m_thread = std::jthread( [this]( std::stop_token should_stop ) {
+			if( m_affinity.pinned( ) ) {
+				(void)details::pin_current_thread( m_affinity.cpu );
+			}
+			reserve_queues( );
+			run( should_stop );
+		} );
+	}
+
+	/***
+	 * Runs on the worker once it is pinned, so the queues it uses most are
+	 * allocated on its cpu's NUMA node rather than wherever they first grow
+	 */
+	void pool_worker::reserve_queues( ) {
+		auto const numa_node =
+		  details::prefer_numa_node( details::numa_node_of_cpu( m_affinity.cpu ) );
+		m_events.resize( event_batch );
+		m_expired.reserve( queue_reserve );
+		m_closing_batch.reserve( queue_reserve );
+		auto const lck = std::unique_lock( m_mutex );
+		m_ready.reserve( queue_reserve );
+		m_closing.reserve( queue_reserve );
+	}
+
+	bool pool_worker::in_scheduler_thread( ) const {
+		return std::this_thread::get_id( ) == m_thread.get_id( );
+	}
+
+	void pool_worker::wake( ) {
+		std::uint64_t const one = 1;
+		(void)::write( m_wake, &one, sizeof( one ) );
+	}
+
+	bool pool_worker::try_wake( ) {
+		if( m_sleeping.exchange( false ) ) {
+			wake( );
+			return true;
+		}
+		return false;
+	}
+
+	void pool_worker::post( std::shared_ptr<details::io_strand> strand ) {
+		{
+			auto const lck = std::unique_lock( m_mutex );
+			m_ready.push_back( std::move( strand ) );
+		}
+		if( not in_scheduler_thread( ) and not try_wake( ) ) {
+			// The home worker is busy, let an idle one steal it
+			m_pool->wake_idle( m_index );
+		}
+	}
+
+	void pool_worker::post_close( std::shared_ptr<details::io_strand> strand ) {
+		{
+			auto const lck = std::unique_lock( m_mutex );
+			m_closing.push_back( std::move( strand ) );
+		}
+		if( not try_wake( ) ) {
+			wake( );
+		}
+	}
+
+	/***
+	 * A thief that parks a timed strand wakes the home worker, which may be
+	 * sleeping without a timeout
+	 */
+	std::optional<::ssize_t> pool_worker::start( details::io_strand &strand ) {
+		bool const timed = strand.request( ).has_deadline( );
+		auto result = details::epoll_start( m_epoll, strand, m_timers );
+		if( not result and timed and not in_scheduler_thread( ) ) {
+			(void)try_wake( );
+		}
+		return result;
+	}
+
+	bool pool_worker::cancel( details::io_strand &strand ) {
+		return details::epoll_cancel( m_epoll, strand, m_timers );
+	}
+
+	/// Expired by the home worker, which may be sleeping without a timeout
+	void pool_worker::interrupt( details::io_strand &strand ) {
+		m_timers.interrupt( strand );
+		if( not in_scheduler_thread( ) ) {
+			(void)try_wake( );
+		}
+	}
+
+	std::shared_ptr<details::io_strand> pool_worker::pop_front( ) {
+		auto const lck = std::unique_lock( m_mutex );
+		if( m_ready.empty( ) ) {
+			return { };
+		}
+		return m_ready.pop_front( );
+	}
+
+	/***
+	 * Thieves take from the back so the home worker keeps the oldest, and most
+	 * likely cache warm, strands
+	 */
+	std::shared_ptr<details::io_strand> pool_worker::steal( ) {
+		auto const lck = std::unique_lock( m_mutex, std::try_to_lock );
+		if( not lck or m_ready.empty( ) ) {
+			return { };
+		}
+		return m_ready.pop_back( );
+	}
+
+	/***
+	 * Move ready fds onto the run queue, then close strands.  Closing after the
+	 * batch is collected means no harvested event can refer to a released strand
+	 */
+	void pool_worker::poll_events( int timeout ) {
+		int const count = ::epoll_wait(
+		  m_epoll, m_events.data( ), static_cast<int>( m_events.size( ) ), timeout );
+		{
+			auto const lck = std::unique_lock( m_mutex );
+			for( int n = 0; n < count; ++n ) {
+				if( m_events[n].data.ptr == nullptr ) {
+					std::uint64_t value = 0;
+					(void)::read( m_wake, &value, sizeof( value ) );
+					continue;
+				}
+				details::epoll_dispatch( m_epoll, m_events[n], m_timers,
+				                         [&]( auto self ) {
+					                         m_ready.push_back( std::move( self ) );
+				                         } );
+			}
+			details::epoll_expire( m_epoll, m_timers, m_expired, [&]( auto self ) {
+				m_ready.push_back( std::move( self ) );
+			} );
+			// Swapped rather than moved so both keep their storage
+			std::swap( m_closing_batch, m_closing );
+		}
+		for( auto &strand : m_closing_batch ) {
+			strand->close( );
+		}
+		m_closing_batch.clear( );
+	}
+
+	void pool_worker::run( std::stop_token const &should_stop ) {
+		std::size_t since_poll = 0;
+		while( not should_stop.stop_requested( ) ) {
+			auto strand = pop_front( );
+			if( not strand ) {
+				strand = m_pool->steal_for( m_index );
+			}
+			if( strand ) {
+				strand->run( );
+				strand.reset( );
+				if( ++since_poll == poll_interval ) {
+					since_poll = 0;
+					poll_events( 0 );
+				}
+				continue;
+			}
+			since_poll = 0;
+			m_sleeping = true;
+			bool has_work = false;
+			{
+				auto const lck = std::unique_lock( m_mutex );
+				has_work = not m_ready.empty( ) or not m_closing.empty( );
+			}
+			poll_events( has_work ? 0 : m_timers.wait_ms( ) );
+			m_sleeping = false;
+		}
+	}
+
+	work_stealing_pool::work_stealing_pool( std::size_t worker_count,
+	                                        bool pin_to_cores ) {
+		worker_count = std::max( worker_count, std::size_t{ 1 } );
+		m_workers.reserve( worker_count );
+		for( std::size_t n = 0; n < worker_count; ++n ) {
+			auto affinity = cpu_affinity{ };
+			if( pin_to_cores ) {
+				affinity.cpu = static_cast<int>(
+				  n % static_cast<std::size_t>( details::cpu_count( ) ) );
+			}
+			// Places the worker itself, its timer wheel included, on the node
+			auto const numa_node =
+			  details::prefer_numa_node( details::numa_node_of_cpu( affinity.cpu ) );
+			m_workers.push_back( std::make_unique<pool_worker>( *this, n, affinity ) );
+		}
+		// Every worker must exist before any of them can steal
+		for( auto &worker : m_workers ) {
+			worker->launch( );
+		}
+	}
+
+	work_stealing_pool::~work_stealing_pool( ) {
+		for( auto &worker : m_workers ) {
+			worker->m_thread.request_stop( );
+			worker->wake( );
+		}
+		for( auto &worker : m_workers ) {
+			if( worker->m_thread.joinable( ) ) {
+				worker->m_thread.join( );
+			}
+		}
+	}
+
+	std::shared_ptr<details::io_strand>
+	work_stealing_pool::steal_for( std::size_t thief ) {
+		auto const count = m_workers.size( );
+		for( std::size_t n = 1; n < count; ++n ) {
+			auto &victim = *m_workers[( thief + n ) % count];
+			if( victim.m_sleeping ) {
+				// It is about to wake for its own work
+				continue;
+			}
+			if( auto strand = victim.steal( ) ) {
+				return strand;
+			}
+		}
+		return { };
+	}
+
+	void work_stealing_pool::wake_idle( std::size_t except ) {
+		auto const count = m_workers.size( );
+		for( std::size_t n = 1; n < count; ++n ) {
+			if( m_workers[( except + n ) % count]->try_wake( ) ) {
+				return;
+			}
+		}
+	}
+
+	pool_worker &work_stealing_pool::next( ) {
+		auto const idx = m_next.fetch_add( 1, std::memory_order_relaxed );
+		return *m_workers[idx % m_workers.size( )];
+	}
+
+	pool_worker &work_stealing_pool::operator[]( std::size_t idx ) {
+		return *m_workers[idx];
+	}
+
+	std::size_t work_stealing_pool::size( ) const {
+		return m_workers.size( );
+	}
+
+	work_stealing_pool &work_stealing_pool::default_pool( ) {
+		// Intentionally leaked so sockets destroyed during static destruction
+		// still have a pool
+		static auto *pool =
+		  new work_stealing_pool( std::thread::hardware_concurrency( ), true );
+		return *pool;
+	}
+
+	async_exec_policy_pool::async_exec_policy_pool( )
+	  : async_exec_policy_pool( work_stealing_pool::default_pool( ) ) {}
+
+	async_exec_policy_pool::async_exec_policy_pool( work_stealing_pool &pool )
+	  : async_exec_policy_pool( pool.next( ) ) {}
+
+	async_exec_policy_pool::async_exec_policy_pool( pool_worker &home )
+	  : m_strands( home ) {}
+
+	void async_exec_policy_pool::add_io_task( networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::write,
+		                       std::move( tsk ) );
+	}
+
+	void async_exec_policy_pool::add_read_io_task( networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::read,
+		                       std::move( tsk ) );
+	}
+
+	void async_exec_policy_pool::add_exclusive_io_task(
+	  networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::exclusive,
+		                       std::move( tsk ) );
+	}
+
+	void async_exec_policy_pool::interrupt( ) {
+		m_strands.interrupt( );
+	}
+
+	void async_exec_policy_pool::wait( ) const {
+		m_strands.wait( );
+	}
+} // namespace daw
@@ -6,32 +6,209 @@
 
 #include "daw/networking/async_exec_policy_thread.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <poll.h>
+
 namespace daw {
-	async_exec_policy_thread::~async_exec_policy_thread( ) {
-		m_thread.request_stop( );
-		m_queue.clear( );
-		m_queue.notify_all( );
-	}
+	namespace details {
+		thread_scheduler::thread_scheduler( cpu_affinity affinity )
+		  : m_thread( [this, affinity]( std::stop_token should_stop ) {
+			  if( affinity.pinned( ) ) {
+				  (void)pin_current_thread( affinity.cpu );
+			  }
+			  run( should_stop );
+		  } ) {}
+
+		thread_scheduler::~thread_scheduler( ) {
+			m_thread.request_stop( );
+			m_wake.notify( );
+			if( m_thread.joinable( ) ) {
+				m_thread.join( );
+			}
+		}
+
+		bool thread_scheduler::in_scheduler_thread( ) const {
+			return std::this_thread::get_id( ) == m_thread.get_id( );
+		}
+
+		/***
+		 * The fence pairs with the one in run( ), either the worker sees the
+		 * post before it sleeps or the post sees it sleeping.  The exchange
+		 * keeps concurrent posts from all writing the fd
+		 */
+		void thread_scheduler::wake( ) {
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			if( m_sleeping.load( std::memory_order_relaxed ) and
+			    m_sleeping.exchange( false, std::memory_order_relaxed ) ) {
+				m_wake.notify( );
+			}
+		}
+
+		void thread_scheduler::post( std::shared_ptr<io_strand> strand ) {
+			m_posted.push( posted_strand{ std::move( strand ), false } );
+			wake( );
+		}
+
+		void thread_scheduler::post_close( std::shared_ptr<io_strand> strand ) {
+			m_posted.push( posted_strand{ std::move( strand ), true } );
+			wake( );
+		}
+
+		/// Strands only run on the worker, so this is never called elsewhere
+		std::optional<::ssize_t> thread_scheduler::start( io_strand &strand ) {
+			auto &req = strand.request( );
+			if( auto result = networking::details::perform_nonblocking( req ) ) {
+				return result;
+			}
+			int const result = strand.park( [&]( ) {
+				if( req.stop_requested( ) ) {
+					return -ECANCELED;
+				}
+				m_parked.push_back( &strand );
+				if( req.has_deadline( ) ) {
+					m_timers.schedule( strand );
+				}
+				return 0;
+			} );
+			if( result < 0 ) {
+				return result;
+			}
+			return std::nullopt;
+		}
+
+		bool thread_scheduler::cancel( io_strand &strand ) {
+			unparked( strand );
+			return true;
+		}
+
+		void thread_scheduler::interrupt( io_strand &strand ) {
+			m_timers.interrupt( strand );
+			wake( );
+		}
+
+		void thread_scheduler::unparked( io_strand &strand ) {
+			auto const pos = std::find( m_parked.begin( ), m_parked.end( ), &strand );
+			if( pos != m_parked.end( ) ) {
+				m_parked.erase( pos );
+			}
+			(void)m_timers.release( strand );
+		}
+
+		/***
+		 * Both lanes of the policy's duplex_strand can be parked on the same fd,
+		 * poll takes it twice
+		 */
+		void thread_scheduler::run( std::stop_token const &should_stop ) {
+			auto ready = std::vector<std::shared_ptr<io_strand>>( );
+			auto closing = std::vector<std::shared_ptr<io_strand>>( );
+			auto woken = std::vector<io_strand *>( );
+			auto fds = std::vector<::pollfd>( );
+			while( not should_stop.stop_requested( ) ) {
+				fds.clear( );
+				fds.push_back( ::pollfd{ m_wake.fd( ), POLLIN, 0 } );
+				for( auto *strand : m_parked ) {
+					auto const &req = strand->request( );
+					fds.push_back( ::pollfd{
+					  req.fd, static_cast<short>( networking::details::wait_event( req ) ),
+					  0 } );
+				}
+				int timeout = m_posted.empty( ) ? m_timers.wait_ms( ) : 0;
+				if( timeout != 0 ) {
+					m_sleeping.store( true, std::memory_order_relaxed );
+					std::atomic_thread_fence( std::memory_order_seq_cst );
+					if( not m_posted.empty( ) or should_stop.stop_requested( ) ) {
+						timeout = 0;
+					}
+				}
+				int const count = ::poll(
+				  fds.data( ), static_cast<::nfds_t>( fds.size( ) ), timeout );
+				m_sleeping.store( false, std::memory_order_relaxed );
+				if( count < 0 and errno != EINTR ) {
+					break;
+				}
+				if( fds[0].revents != 0 ) {
+					m_wake.drain( );
+				}
+				// Collected first, unparking a strand removes it from m_parked
+				for( std::size_t n = 1; n < fds.size( ); ++n ) {
+					if( fds[n].revents != 0 ) {
+						woken.push_back( m_parked[n - 1] );
+					}
+				}
+				for( auto *strand : woken ) {
+					if( auto self = strand->unpark( ) ) {
+						unparked( *strand );
+						ready.push_back( std::move( self ) );
+					}
+				}
+				woken.clear( );
+				m_timers.expire( woken );
+				for( auto *strand : woken ) {
+					if( auto self = strand->unpark( ) ) {
+						unparked( *strand );
+						strand->complete( expired_result( strand->request( ) ) );
+						ready.push_back( std::move( self ) );
+					}
+				}
+				woken.clear( );
+				while( auto posted = m_posted.try_pop( ) ) {
+					( posted->close ? closing : ready )
+					  .push_back( std::move( posted->strand ) );
+				}
+				for( auto &strand : ready ) {
+					strand->run( );
+				}
+				ready.clear( );
+				for( auto &strand : closing ) {
+					strand->close( );
+				}
+				closing.clear( );
+			}
+		}
+	} // namespace details
 
 	async_exec_policy_thread::async_exec_policy_thread( )
-	  : m_thread( [&]( std::stop_token should_stop ) {
-		  while( not should_stop.stop_requested( ) ) {
-			  auto tsk = m_queue.wait_and_pop( );
-			  if( tsk ) {
-				  ( *tsk )( );
-			  }
-		  }
-	  } ) {
-		m_queue.reset( m_thread.get_stop_token( ) );
+	  : async_exec_policy_thread( cpu_affinity{ } ) {}
+
+	/***
+	 * The node preference lasts until the delegated constructor returns.  It
+	 * only places what is allocated there, the scheduler's queue and the
+	 * strands with their initial storage.  A strand's task queue that grows
+	 * later does so on whichever thread queues to it.  The worker's own
+	 * buffers are allocated by the worker, after it pins itself
+	 */
+	async_exec_policy_thread::async_exec_policy_thread( cpu_affinity affinity )
+	  : async_exec_policy_thread(
+	      affinity, details::prefer_numa_node(
+	                  details::numa_node_of_cpu( affinity.cpu ) ) ) {}
+
+	async_exec_policy_thread::async_exec_policy_thread(
+	  cpu_affinity affinity, details::prefer_numa_node const & )
+	  : m_scheduler( affinity )
+	  , m_strands( m_scheduler ) {}
+
+	void async_exec_policy_thread::add_io_task( networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::write,
+		                       std::move( tsk ) );
 	}
 
-	void async_exec_policy_thread::wait( ) const {
-		m_queue.wait( );
+	void async_exec_policy_thread::add_read_io_task( networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::read,
+		                       std::move( tsk ) );
 	}
 
-	task_token async_exec_policy_thread::add_task( std::function<void( )> tsk ) {
-		auto tok = task_token( );
-		m_queue.push( packaged_task( std::move( tsk ), tok ) );
-		return tok;
+	void async_exec_policy_thread::add_exclusive_io_task(
+	  networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::exclusive,
+		                       std::move( tsk ) );
+	}
+
+	void async_exec_policy_thread::interrupt( ) {
+		m_strands.interrupt( );
+	}
+
+	void async_exec_policy_thread::wait( ) const {
+		m_strands.wait( );
 	}
 } // namespace daw
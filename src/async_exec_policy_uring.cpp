@@ -0,0 +1,432 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/async_exec_policy_uring.h"
+#include "daw/networking/network_exception.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+
+namespace daw {
+	namespace {
+		// The low bits of an SQE's user_data say what completed for the strand
+		constexpr std::uint64_t native_tag = 0;
+		constexpr std::uint64_t poll_tag = 1;
+		constexpr std::uint64_t cancel_tag = 2;
+		// Without a strand, the reactor's own timeout for the next deadline
+		constexpr std::uint64_t timeout_tag = 3;
+		constexpr std::uint64_t tag_mask = 3;
+		constexpr unsigned ring_entries = 256;
+
+		std::uint64_t to_user_data( details::io_strand &strand,
+		                            std::uint64_t tag ) {
+			return reinterpret_cast<std::uintptr_t>( &strand ) | tag;
+		}
+
+		/// The opcode that performs the request in the ring, if there is one
+		std::optional<std::uint8_t> native_opcode( networking::io_op_type op ) {
+			switch( op ) {
+			case networking::io_op_type::send:
+				return IORING_OP_SEND;
+			case networking::io_op_type::recv:
+				return IORING_OP_RECV;
+			case networking::io_op_type::sendmsg:
+				return IORING_OP_SENDMSG;
+			case networking::io_op_type::recvmsg:
+				return IORING_OP_RECVMSG;
+			default:
+				return std::nullopt;
+			}
+		}
+	} // namespace
+
+	struct uring_reactor::ring {
+		int fd = -1;
+		void *sq_ptr = MAP_FAILED;
+		std::size_t sq_size = 0;
+		void *cq_ptr = MAP_FAILED;
+		std::size_t cq_size = 0;
+		::io_uring_sqe *sqes = static_cast<::io_uring_sqe *>( MAP_FAILED );
+		std::size_t sqes_size = 0;
+		unsigned *sq_head = nullptr;
+		unsigned *sq_tail = nullptr;
+		unsigned *sq_mask = nullptr;
+		unsigned *sq_array = nullptr;
+		unsigned sq_entries = 0;
+		unsigned *cq_head = nullptr;
+		unsigned *cq_tail = nullptr;
+		unsigned *cq_mask = nullptr;
+		::io_uring_cqe *cqes = nullptr;
+		unsigned to_submit = 0;
+		// When the earliest timeout SQE in flight fires
+		networking::io_clock::time_point timeout_at =
+		  networking::io_clock::time_point::max( );
+		::__kernel_timespec timeout{ };
+
+		explicit ring( unsigned entries ) {
+			auto params = ::io_uring_params{ };
+			fd = static_cast<int>( ::syscall( __NR_io_uring_setup, entries, &params ) );
+			if( fd < 0 ) {
+				throw networking::network_exception( "Error creating io_uring",
+				                                     errno );
+			}
+			sq_size = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+			cq_size =
+			  params.cq_off.cqes + params.cq_entries * sizeof( ::io_uring_cqe );
+			bool const single_mmap =
+			  ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+			if( single_mmap ) {
+				sq_size = cq_size = std::max( sq_size, cq_size );
+			}
+			sq_ptr = ::mmap( nullptr, sq_size, PROT_READ | PROT_WRITE,
+			                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+			if( sq_ptr != MAP_FAILED ) {
+				cq_ptr = single_mmap
+				           ? sq_ptr
+				           : ::mmap( nullptr, cq_size, PROT_READ | PROT_WRITE,
+				                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+			}
+			sqes_size = params.sq_entries * sizeof( ::io_uring_sqe );
+			if( cq_ptr != MAP_FAILED ) {
+				sqes = static_cast<::io_uring_sqe *>(
+				  ::mmap( nullptr, sqes_size, PROT_READ | PROT_WRITE,
+				          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES ) );
+			}
+			if( sqes == MAP_FAILED ) {
+				auto const err = errno;
+				release( );
+				throw networking::network_exception( "Error mapping io_uring", err );
+			}
+			auto *sq = static_cast<char *>( sq_ptr );
+			sq_head = reinterpret_cast<unsigned *>( sq + params.sq_off.head );
+			sq_tail = reinterpret_cast<unsigned *>( sq + params.sq_off.tail );
+			sq_mask = reinterpret_cast<unsigned *>( sq + params.sq_off.ring_mask );
+			sq_array = reinterpret_cast<unsigned *>( sq + params.sq_off.array );
+			sq_entries = params.sq_entries;
+			auto *cq = static_cast<char *>( cq_ptr );
+			cq_head = reinterpret_cast<unsigned *>( cq + params.cq_off.head );
+			cq_tail = reinterpret_cast<unsigned *>( cq + params.cq_off.tail );
+			cq_mask = reinterpret_cast<unsigned *>( cq + params.cq_off.ring_mask );
+			cqes = reinterpret_cast<::io_uring_cqe *>( cq + params.cq_off.cqes );
+		}
+
+		~ring( ) {
+			release( );
+		}
+
+		ring( ring const & ) = delete;
+		ring &operator=( ring const & ) = delete;
+
+		void release( ) {
+			if( sqes != MAP_FAILED ) {
+				(void)::munmap( sqes, sqes_size );
+			}
+			if( cq_ptr != MAP_FAILED and cq_ptr != sq_ptr ) {
+				(void)::munmap( cq_ptr, cq_size );
+			}
+			if( sq_ptr != MAP_FAILED ) {
+				(void)::munmap( sq_ptr, sq_size );
+			}
+			if( fd >= 0 ) {
+				(void)::close( fd );
+			}
+		}
+
+		/***
+		 * Submit everything queued and, when min_complete is non-zero, wait for
+		 * that many completions
+		 */
+		void enter( unsigned min_complete ) {
+			if( to_submit == 0 and min_complete == 0 ) {
+				return;
+			}
+			auto const r = ::syscall(
+			  __NR_io_uring_enter, fd, to_submit, min_complete,
+			  min_complete > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0 );
+			if( r > 0 ) {
+				to_submit -= std::min( to_submit, static_cast<unsigned>( r ) );
+			}
+		}
+
+		/***
+		 * The next free SQE, zeroed.  Without SQPOLL the kernel only reads the
+		 * ring during io_uring_enter, so it is published immediately
+		 */
+		::io_uring_sqe *get_sqe( ) {
+			unsigned const tail = *sq_tail;
+			while( tail - __atomic_load_n( sq_head, __ATOMIC_ACQUIRE ) >=
+			       sq_entries ) {
+				enter( 0 );
+			}
+			auto const idx = tail & *sq_mask;
+			auto *sqe = &sqes[idx];
+			std::memset( sqe, 0, sizeof( *sqe ) );
+			sq_array[idx] = idx;
+			__atomic_store_n( sq_tail, tail + 1, __ATOMIC_RELEASE );
+			++to_submit;
+			return sqe;
+		}
+	};
+
+	uring_reactor::uring_reactor( )
+	  : m_ring( std::make_unique<ring>( ring_entries ) )
+	  , m_wake( ::eventfd( 0, EFD_CLOEXEC ) ) {
+		if( m_wake < 0 ) {
+			throw networking::network_exception( "Error creating eventfd", errno );
+		}
+		m_thread =
+		  std::jthread( [this]( std::stop_token should_stop ) { run( should_stop ); } );
+	}
+
+	uring_reactor::~uring_reactor( ) {
+		m_thread.request_stop( );
+		wake( );
+		if( m_thread.joinable( ) ) {
+			m_thread.join( );
+		}
+		(void)::close( m_wake );
+	}
+
+	bool uring_reactor::in_scheduler_thread( ) const {
+		return std::this_thread::get_id( ) == m_thread.get_id( );
+	}
+
+	void uring_reactor::wake( ) {
+		std::uint64_t const one = 1;
+		(void)::write( m_wake, &one, sizeof( one ) );
+	}
+
+	void uring_reactor::submit_wake_read( ) {
+		auto *sqe = m_ring->get_sqe( );
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = m_wake;
+		sqe->addr = reinterpret_cast<std::uintptr_t>( &m_wake_value );
+		sqe->len = sizeof( m_wake_value );
+		sqe->user_data = native_tag;
+	}
+
+	void uring_reactor::post( std::shared_ptr<details::io_strand> strand ) {
+		if( m_posted.push( std::move( strand ) ) and not in_scheduler_thread( ) ) {
+			wake( );
+		}
+	}
+
+	void uring_reactor::post_close( std::shared_ptr<details::io_strand> strand ) {
+		if( m_posted.push_close( std::move( strand ) ) ) {
+			wake( );
+		}
+	}
+
+	std::optional<::ssize_t> uring_reactor::start( details::io_strand &strand ) {
+		auto &req = strand.request( );
+		auto tag = native_tag;
+		auto const opcode = native_opcode( req.op );
+		if( not opcode ) {
+			if( auto result = networking::details::perform_nonblocking( req ) ) {
+				return result;
+			}
+			tag = poll_tag;
+		}
+		int const result = strand.park( [&]( ) {
+			if( req.stop_requested( ) ) {
+				return -ECANCELED;
+			}
+			if( req.has_deadline( ) ) {
+				m_timers.schedule( strand );
+			}
+			auto *sqe = m_ring->get_sqe( );
+			sqe->user_data = to_user_data( strand, tag );
+			strand.scheduler_data( ) = static_cast<int>( tag );
+			if( tag == poll_tag ) {
+				sqe->opcode = IORING_OP_POLL_ADD;
+				sqe->fd = req.fd;
+				sqe->poll32_events =
+				  static_cast<std::uint32_t>( networking::details::wait_event( req ) );
+				return 0;
+			}
+			bool const is_send = req.op == networking::io_op_type::send or
+			                     req.op == networking::io_op_type::sendmsg;
+			sqe->opcode = *opcode;
+			sqe->fd = req.fd;
+			sqe->addr = reinterpret_cast<std::uintptr_t>( req.buffer );
+			// The msg variants take one msghdr
+			sqe->len = *opcode == IORING_OP_SENDMSG or *opcode == IORING_OP_RECVMSG
+			             ? 1U
+			             : static_cast<std::uint32_t>( req.size );
+			sqe->msg_flags = static_cast<std::uint32_t>(
+			  is_send ? req.flags | MSG_NOSIGNAL : req.flags );
+			return 0;
+		} );
+		if( result < 0 ) {
+			return result;
+		}
+		return std::nullopt;
+	}
+
+	void uring_reactor::submit_cancel( details::io_strand &strand ) {
+		auto *sqe = m_ring->get_sqe( );
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->addr = to_user_data(
+		  strand, static_cast<std::uint64_t>( strand.scheduler_data( ) ) );
+		sqe->user_data = cancel_tag;
+	}
+
+	/***
+	 * The cancelled request still posts a CQE, which unparks the strand so the
+	 * close can finish once the kernel is done with the request
+	 */
+	bool uring_reactor::cancel( details::io_strand &strand ) {
+		submit_cancel( strand );
+		return false;
+	}
+
+	/***
+	 * Wake the next enter when the earliest deadline is due.  A timeout
+	 * already in flight that fires sooner covers it
+	 */
+	void uring_reactor::submit_timeout( ) {
+		int const wait = m_timers.wait_ms( );
+		if( wait < 0 ) {
+			return;
+		}
+		auto const at =
+		  networking::io_clock::now( ) + std::chrono::milliseconds( wait );
+		if( at >= m_ring->timeout_at ) {
+			return;
+		}
+		m_ring->timeout_at = at;
+		m_ring->timeout.tv_sec = wait / 1000;
+		m_ring->timeout.tv_nsec = static_cast<long long>( wait % 1000 ) * 1000000;
+		auto *sqe = m_ring->get_sqe( );
+		sqe->opcode = IORING_OP_TIMEOUT;
+		sqe->addr = reinterpret_cast<std::uintptr_t>( &m_ring->timeout );
+		sqe->len = 1;
+		sqe->user_data = timeout_tag;
+	}
+
+	void uring_reactor::interrupt( details::io_strand &strand ) {
+		m_timers.interrupt( strand );
+		if( not in_scheduler_thread( ) ) {
+			wake( );
+		}
+	}
+
+	void uring_reactor::reap(
+	  std::vector<std::shared_ptr<details::io_strand>> &ready ) {
+		unsigned head = *m_ring->cq_head;
+		unsigned const tail = __atomic_load_n( m_ring->cq_tail, __ATOMIC_ACQUIRE );
+		for( ; head != tail; ++head ) {
+			auto const &cqe = m_ring->cqes[head & *m_ring->cq_mask];
+			auto const tag = cqe.user_data & tag_mask;
+			auto *strand = reinterpret_cast<details::io_strand *>(
+			  static_cast<std::uintptr_t>( cqe.user_data & ~tag_mask ) );
+			if( strand == nullptr ) {
+				if( tag == native_tag ) {
+					submit_wake_read( );
+				} else if( tag == timeout_tag ) {
+					m_ring->timeout_at = networking::io_clock::time_point::max( );
+				}
+				continue;
+			}
+			if( tag == native_tag ) {
+				if( cqe.res == -EAGAIN and not strand->timer( ).expired and
+				    not strand->closed( ) ) {
+					// Kernels that honour O_NONBLOCK for io_uring need a poll first
+					auto &req = strand->request( );
+					auto *sqe = m_ring->get_sqe( );
+					sqe->opcode = IORING_OP_POLL_ADD;
+					sqe->fd = req.fd;
+					sqe->poll32_events =
+					  static_cast<std::uint32_t>( networking::details::wait_event( req ) );
+					sqe->user_data = to_user_data( *strand, poll_tag );
+					strand->scheduler_data( ) = static_cast<int>( poll_tag );
+					continue;
+				}
+			}
+			// A request cut short by its timer reports why
+			bool const timed_out = m_timers.release( *strand ) and
+			                       ( tag != native_tag or cqe.res == -ECANCELED or
+			                         cqe.res == -EAGAIN );
+			if( timed_out ) {
+				strand->complete( details::expired_result( strand->request( ) ) );
+			} else if( tag == native_tag ) {
+				strand->complete( cqe.res );
+			}
+			// After a poll completes the request is still pending and start retries
+			if( auto self = strand->unpark( ) ) {
+				ready.push_back( std::move( self ) );
+			}
+		}
+		__atomic_store_n( m_ring->cq_head, head, __ATOMIC_RELEASE );
+	}
+
+	void uring_reactor::run( std::stop_token const &should_stop ) {
+		auto ready = std::vector<std::shared_ptr<details::io_strand>>( );
+		auto closing = std::vector<std::shared_ptr<details::io_strand>>( );
+		submit_wake_read( );
+		while( not should_stop.stop_requested( ) ) {
+			// One syscall submits everything queued by the last batch of strands
+			bool const idle = m_posted.empty( );
+			if( idle ) {
+				submit_timeout( );
+			}
+			m_ring->enter( idle ? 1 : 0 );
+			reap( ready );
+			m_timers.expire( m_expired );
+			for( auto *strand : m_expired ) {
+				submit_cancel( *strand );
+			}
+			m_expired.clear( );
+			m_posted.take( ready, closing );
+			for( auto &strand : ready ) {
+				strand->run( );
+			}
+			ready.clear( );
+			for( auto &strand : closing ) {
+				strand->close( );
+			}
+			closing.clear( );
+		}
+	}
+
+	async_exec_policy_uring::async_exec_policy_uring( )
+	  : async_exec_policy_uring( uring_reactor_group::default_group( ).next( ) ) {}
+
+	async_exec_policy_uring::async_exec_policy_uring( uring_reactor &reactor )
+	  : m_strands( reactor ) {}
+
+	void async_exec_policy_uring::add_io_task( networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::write,
+		                       std::move( tsk ) );
+	}
+
+	void async_exec_policy_uring::add_read_io_task( networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::read,
+		                       std::move( tsk ) );
+	}
+
+	void async_exec_policy_uring::add_exclusive_io_task(
+	  networking::io_task tsk ) {
+		m_strands.add_io_task( details::duplex_strand::task_kind::exclusive,
+		                       std::move( tsk ) );
+	}
+
+	void async_exec_policy_uring::interrupt( ) {
+		m_strands.interrupt( );
+	}
+
+	void async_exec_policy_uring::wait( ) const {
+		m_strands.wait( );
+	}
+} // namespace daw
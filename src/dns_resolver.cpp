@@ -0,0 +1,232 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/dns_resolver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <netdb.h>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace daw::networking {
+	namespace {
+		std::string cache_key( std::string_view host, address_family af,
+		                       socket_types st ) {
+			auto key = std::string( host );
+			key += '\0';
+			key += std::to_string( static_cast<int>( af ) );
+			key += ',';
+			key += std::to_string( static_cast<int>( st ) );
+			return key;
+		}
+
+		bool matches_family( socket_address const &address, address_family af ) {
+			return af == address_family::Unspecified or address.family( ) == af;
+		}
+	} // namespace
+
+	dns_resolver::dns_resolver( dns_resolver_options options,
+	                            lookup_function lookup )
+	  : m_options( options )
+	  , m_lookup( std::move( lookup ) ) {
+		auto const count = std::max<std::size_t>( m_options.worker_count, 1 );
+		for( std::size_t n = 0; n < count; ++n ) {
+			m_workers.push_back( std::make_unique<async_exec_policy_thread>( ) );
+		}
+	}
+
+	async_result<address_list> dns_resolver::resolve( std::string_view host,
+	                                                  address_family af,
+	                                                  socket_types st ) {
+		auto state = async_result_state<address_list>::make( );
+		if( auto numeric = socket_address::try_numeric( std::string( host ), 0 );
+		    numeric and matches_family( *numeric, af ) ) {
+			state->set_value( std::make_shared<std::vector<socket_address> const>(
+			  1, *numeric ) );
+			return { std::move( state ) };
+		}
+
+		auto key = cache_key( host, af, st );
+		auto const now = clock::now( );
+		auto lck = std::unique_lock( m_mutex );
+		auto &e = m_cache[key];
+		if( e.pending ) {
+			e.waiters.push_back( state );
+			return { std::move( state ) };
+		}
+		if( now < e.expires ) {
+			auto const error = e.error;
+			auto addresses = e.addresses;
+			lck.unlock( );
+			if( error != 0 ) {
+				state->set_error( "Error resolving addresses", error );
+			} else {
+				state->set_value( std::move( addresses ) );
+			}
+			return { std::move( state ) };
+		}
+		e.pending = true;
+		e.waiters.push_back( state );
+		if( m_cache.size( ) > m_options.max_entries ) {
+			drop_expired( now );
+		}
+		lck.unlock( );
+
+		auto &worker =
+		  *m_workers[m_next_worker.fetch_add( 1, std::memory_order_relaxed ) %
+		             m_workers.size( )];
+		// A lookup the worker drops while shutting down still answers its waiters
+		worker.add_io_task( [this, key = std::move( key ),
+		                     host = std::string( host ), af,
+		                     st]( ::ssize_t r ) mutable -> io_request {
+			auto answer = dns_answer( );
+			if( r < 0 ) {
+				answer.error = EAI_AGAIN;
+			} else {
+				try {
+					answer = m_lookup( host, af, st );
+				} catch( ... ) { answer.error = EAI_FAIL; }
+			}
+			finish_lookup( key, std::move( answer ) );
+			return { };
+		} );
+		return { std::move( state ) };
+	}
+
+	void dns_resolver::finish_lookup( std::string const &key, dns_answer answer ) {
+		if( answer.error == 0 and answer.addresses.empty( ) ) {
+			answer.error = EAI_NONAME;
+		}
+		auto ttl = answer.ttl;
+		if( ttl.count( ) == 0 ) {
+			ttl = answer.error == 0 ? m_options.positive_ttl : m_options.negative_ttl;
+		}
+		auto addresses = address_list( );
+		if( answer.error == 0 ) {
+			addresses = std::make_shared<std::vector<socket_address> const>(
+			  std::move( answer.addresses ) );
+		}
+
+		auto waiters = std::vector<async_state_ptr<address_list>>( );
+		{
+			auto const lck = std::unique_lock( m_mutex );
+			auto &e = m_cache[key];
+			e.addresses = addresses;
+			e.error = answer.error;
+			e.expires = clock::now( ) + ttl;
+			e.pending = false;
+			waiters.swap( e.waiters );
+		}
+		for( auto &w : waiters ) {
+			if( answer.error != 0 ) {
+				w->set_error( "Error resolving addresses", answer.error );
+			} else {
+				w->set_value( addresses );
+			}
+		}
+	}
+
+	/// Called with m_mutex held
+	void dns_resolver::drop_expired( clock::time_point now ) {
+		for( auto it = m_cache.begin( ); it != m_cache.end( ); ) {
+			if( not it->second.pending and it->second.expires <= now ) {
+				it = m_cache.erase( it );
+			} else {
+				++it;
+			}
+		}
+	}
+
+	void dns_resolver::clear( ) {
+		auto const lck = std::unique_lock( m_mutex );
+		for( auto it = m_cache.begin( ); it != m_cache.end( ); ) {
+			if( it->second.pending ) {
+				++it;
+			} else {
+				it = m_cache.erase( it );
+			}
+		}
+	}
+
+	dns_answer dns_resolver::system_lookup( std::string const &host,
+	                                        address_family af, socket_types st ) {
+		auto hints = ::addrinfo( );
+		hints.ai_family = static_cast<int>( af );
+		hints.ai_socktype = static_cast<int>( st );
+		::addrinfo *res = nullptr;
+		// getaddrinfo needs a service when there is no host, which gives loopback
+		int const rc = ::getaddrinfo( host.empty( ) ? nullptr : host.c_str( ),
+		                              host.empty( ) ? "0" : nullptr, &hints, &res );
+		auto answer = dns_answer( );
+		if( rc != 0 ) {
+			answer.error = rc;
+			return answer;
+		}
+		for( auto const *ai = res; ai != nullptr; ai = ai->ai_next ) {
+			auto address = socket_address( );
+			std::memcpy( &address.storage, ai->ai_addr,
+			             std::min<std::size_t>( ai->ai_addrlen,
+			                                    sizeof( address.storage ) ) );
+			address.size = ai->ai_addrlen;
+			answer.addresses.push_back( address );
+		}
+		::freeaddrinfo( res );
+		return answer;
+	}
+
+	dns_resolver::lookup_function
+	dns_resolver::hosts_lookup( std::string_view hosts ) {
+		auto table =
+		  std::make_shared<std::unordered_map<std::string, dns_answer>>( );
+		auto in = std::istringstream( std::string( hosts ) );
+		auto line = std::string( );
+		while( std::getline( in, line ) ) {
+			line = line.substr( 0, line.find( '#' ) );
+			auto words = std::istringstream( line );
+			auto address_text = std::string( );
+			if( not( words >> address_text ) ) {
+				continue;
+			}
+			auto const address = socket_address::try_numeric( address_text, 0 );
+			if( not address ) {
+				continue;
+			}
+			auto name = std::string( );
+			while( words >> name ) {
+				( *table )[name].addresses.push_back( *address );
+			}
+		}
+		return [table = std::move( table )]( std::string const &host,
+		                                     address_family af, socket_types ) {
+			auto answer = dns_answer( );
+			if( auto pos = table->find( host ); pos != table->end( ) ) {
+				for( auto const &address : pos->second.addresses ) {
+					if( matches_family( address, af ) ) {
+						answer.addresses.push_back( address );
+					}
+				}
+			}
+			if( answer.addresses.empty( ) ) {
+				answer.error = EAI_NONAME;
+			}
+			return answer;
+		};
+	}
+
+	dns_resolver &dns_resolver::system( ) {
+		static auto resolver = dns_resolver( );
+		return resolver;
+	}
+} // namespace daw::networking
@@ -0,0 +1,237 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/io_request.h"
+#include "daw/networking/details/wakeup_fd.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <fcntl.h>
+#include <optional>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#if defined( __linux__ )
+#include <sys/sendfile.h>
+#endif
+
+namespace daw::networking::details {
+	namespace {
+		constexpr bool would_block( int err ) {
+			return err == EAGAIN or err == EWOULDBLOCK;
+		}
+
+		/// Stop callback that interrupts a poll through a wakeup_fd
+		struct notify_on_stop {
+			wakeup_fd *wake;
+
+			void operator( )( ) const {
+				wake->notify( );
+			}
+		};
+
+		::ssize_t finish_connect( int fd ) {
+			int err = 0;
+			auto len = static_cast<::socklen_t>( sizeof( err ) );
+			if( ::getsockopt( fd, SOL_SOCKET, SO_ERROR, &err, &len ) < 0 ) {
+				return -errno;
+			}
+			return -static_cast<::ssize_t>( err );
+		}
+
+		int accept_one( int fd ) {
+#if defined( __linux__ )
+			return ::accept4( fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC );
+#else
+			int const result = ::accept( fd, nullptr, nullptr );
+			if( result >= 0 ) {
+				(void)::fcntl( result, F_SETFL, ::fcntl( result, F_GETFL ) | O_NONBLOCK );
+				(void)::fcntl( result, F_SETFD, FD_CLOEXEC );
+			}
+			return result;
+#endif
+		}
+
+		/***
+		 * Drain the listen backlog into the request's buffer of fds, so one
+		 * wakeup accepts every connection that is waiting
+		 */
+		std::optional<::ssize_t> accept_batch( io_request const &req ) {
+			auto *const fds = static_cast<int *>( req.buffer );
+			std::size_t count = 0;
+			while( count < req.size ) {
+				int const fd = accept_one( req.fd );
+				if( fd >= 0 ) {
+					fds[count++] = fd;
+					continue;
+				}
+				int const err = errno;
+				// The peer gave up before it was accepted, try the next one
+				if( err == EINTR or err == ECONNABORTED or err == EPROTO ) {
+					continue;
+				}
+				if( count > 0 ) {
+					// Any error will be seen again on the next call
+					break;
+				}
+				if( would_block( err ) ) {
+					return std::nullopt;
+				}
+				return -err;
+			}
+			return static_cast<::ssize_t>( count );
+		}
+	} // namespace
+
+	io_event wait_event( io_request const &req ) {
+		switch( req.op ) {
+		case io_op_type::recv:
+		case io_op_type::recvmsg:
+		case io_op_type::accept:
+		case io_op_type::recvmmsg:
+		case io_op_type::wait_readable:
+			return io_event::Read;
+		case io_op_type::recv_errqueue:
+			return io_event::Error;
+		default:
+			return io_event::Write;
+		}
+	}
+
+	std::optional<::ssize_t> perform_nonblocking( io_request &req ) {
+		while( true ) {
+			::ssize_t r = -1;
+			switch( req.op ) {
+			case io_op_type::none:
+				return 0;
+			case io_op_type::connect:
+				if( req.in_progress ) {
+					return finish_connect( req.fd );
+				}
+				r = ::connect( req.fd, static_cast<::sockaddr const *>( req.buffer ),
+				               static_cast<::socklen_t>( req.size ) );
+				if( r < 0 and errno == EINPROGRESS ) {
+					req.in_progress = true;
+					return std::nullopt;
+				}
+				break;
+			case io_op_type::send:
+				r = ::send( req.fd, req.buffer, req.size, req.flags | MSG_NOSIGNAL );
+				break;
+			case io_op_type::recv:
+				r = ::recv( req.fd, req.buffer, req.size, req.flags );
+				break;
+			case io_op_type::sendmsg:
+				r = ::sendmsg( req.fd, static_cast<::msghdr const *>( req.buffer ),
+				               req.flags | MSG_NOSIGNAL );
+				break;
+			case io_op_type::recvmsg:
+				r = ::recvmsg( req.fd, static_cast<::msghdr *>( req.buffer ),
+				               req.flags );
+				break;
+			case io_op_type::recv_errqueue:
+				r = ::recvmsg( req.fd, static_cast<::msghdr *>( req.buffer ),
+				               req.flags | MSG_ERRQUEUE );
+				break;
+			case io_op_type::accept:
+				return accept_batch( req );
+			case io_op_type::wait_readable: {
+				auto pfd = ::pollfd{ req.fd, POLLIN, 0 };
+				r = ::poll( &pfd, 1, 0 );
+				if( r == 0 ) {
+					return std::nullopt;
+				}
+				if( r > 0 ) {
+					return 0;
+				}
+				break;
+			}
+			case io_op_type::sendmmsg:
+#if defined( __linux__ )
+				r = ::sendmmsg( req.fd, static_cast<::mmsghdr *>( req.buffer ),
+				                static_cast<unsigned>( req.size ),
+				                req.flags | MSG_NOSIGNAL );
+#else
+				errno = ENOSYS;
+#endif
+				break;
+			case io_op_type::recvmmsg:
+#if defined( __linux__ )
+				r = ::recvmmsg( req.fd, static_cast<::mmsghdr *>( req.buffer ),
+				                static_cast<unsigned>( req.size ), req.flags, nullptr );
+#else
+				errno = ENOSYS;
+#endif
+				break;
+			case io_op_type::sendfile:
+#if defined( __linux__ )
+				r = ::sendfile( req.fd, req.src_fd, &req.offset, req.size );
+#else
+				errno = ENOSYS;
+#endif
+				break;
+			}
+			if( r >= 0 ) {
+				return r;
+			}
+			if( errno == EINTR ) {
+				continue;
+			}
+			if( would_block( errno ) ) {
+				return std::nullopt;
+			}
+			return -errno;
+		}
+	}
+
+	/***
+	 * A request with a stop token also polls the thread's wakeup_fd, which a
+	 * stop callback signals while the request is being performed
+	 */
+	::ssize_t perform_blocking( io_request &req ) {
+		auto on_stop = std::optional<std::stop_callback<notify_on_stop>>( );
+		wakeup_fd *wake = nullptr;
+		if( req.stop != nullptr ) {
+			thread_local auto stop_wake = wakeup_fd( );
+			wake = &stop_wake;
+			on_stop.emplace( *req.stop, notify_on_stop{ wake } );
+		}
+		while( true ) {
+			if( wake != nullptr ) {
+				// Left over from an earlier request, or a stop seen below
+				wake->drain( );
+			}
+			if( req.stop_requested( ) ) {
+				return -ECANCELED;
+			}
+			if( auto r = perform_nonblocking( req ) ) {
+				return *r;
+			}
+			int timeout = -1;
+			if( req.has_deadline( ) ) {
+				auto const now = io_clock::now( );
+				if( now >= req.deadline ) {
+					return -ETIMEDOUT;
+				}
+				auto const remaining =
+				  std::chrono::ceil<std::chrono::milliseconds>( req.deadline - now );
+				timeout = static_cast<int>( std::min<std::chrono::milliseconds::rep>(
+				  remaining.count( ), INT_MAX ) );
+			}
+			::pollfd pfds[2] = {
+			  { req.fd, static_cast<short>( wait_event( req ) ), 0 },
+			  { wake != nullptr ? wake->fd( ) : -1, POLLIN, 0 } };
+			if( ::poll( pfds, wake != nullptr ? 2 : 1, timeout ) < 0 and
+			    errno != EINTR ) {
+				return -errno;
+			}
+		}
+	}
+} // namespace daw::networking::details
@@ -0,0 +1,337 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/details/io_strand.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace daw::details {
+	namespace {
+		/***
+		 * Tasks a close took from a strand.  Each is finished with -ECANCELED
+		 * once the strand's lock has been released, as finishing one runs its
+		 * continuations
+		 */
+		struct dropped_tasks {
+			ring_buffer<networking::io_task> tasks{ };
+
+			dropped_tasks( ) = default;
+			dropped_tasks( dropped_tasks const & ) = delete;
+			dropped_tasks &operator=( dropped_tasks const & ) = delete;
+
+			~dropped_tasks( ) {
+				while( not tasks.empty( ) ) {
+					networking::cancel_io_task( tasks.pop_front( ) );
+				}
+			}
+		};
+	} // namespace
+
+	io_strand::io_strand( io_scheduler &scheduler, duplex_strand *owner,
+	                      std::size_t lane )
+	  : m_scheduler( &scheduler )
+	  , m_owner( owner )
+	  , m_lane( lane ) {
+		m_timer.owner = this;
+	}
+
+	void io_strand::add_io_task( networking::io_task tsk ) {
+		{
+			auto lck = std::unique_lock( m_mutex );
+			if( m_closed ) {
+				lck.unlock( );
+				networking::cancel_io_task( std::move( tsk ) );
+				return;
+			}
+			m_tasks.push_back( std::move( tsk ) );
+			if( m_active ) {
+				return;
+			}
+			m_active = true;
+		}
+		m_scheduler->post( shared_from_this( ) );
+	}
+
+	void io_strand::wait( ) const {
+		auto lck = std::unique_lock( m_mutex );
+		m_idle.wait( lck, [&] { return not m_active; } );
+	}
+
+	/***
+	 * A strand that stays ready gets a bounded number of steps before yielding
+	 * to the other strands on the scheduler
+	 */
+	void io_strand::run( ) {
+		// Tasks dropped by a close are cancelled after the lock is released
+		auto dropped = dropped_tasks( );
+		auto lck = std::unique_lock( m_mutex );
+		++m_running;
+		for( std::size_t budget = 64; budget > 0; --budget ) {
+			if( m_closed or ( not m_head and m_tasks.empty( ) ) ) {
+				m_active = false;
+				if( m_owner != nullptr and not m_closed ) {
+					// Still counted in m_running, so a shutdown waits for the owner
+					lck.unlock( );
+					m_owner->lane_idle( );
+					lck.lock( );
+				}
+				leave( dropped.tasks );
+				return;
+			}
+			if( not m_head ) {
+				m_head = m_tasks.pop_front( );
+			}
+			lck.unlock( );
+			if( m_request ) {
+				auto result = m_scheduler->start( *this );
+				if( not result ) {
+					lck.lock( );
+					leave( dropped.tasks );
+					return;
+				}
+				m_result = *result;
+			}
+			try {
+				m_request = m_head( std::exchange( m_result, 0 ) );
+			} catch( ... ) { m_request = { }; }
+			lck.lock( );
+			if( not m_request ) {
+				m_head = nullptr;
+			}
+		}
+		leave( dropped.tasks );
+		lck.unlock( );
+		m_scheduler->post( shared_from_this( ) );
+	}
+
+	/***
+	 * Called with the lock held when run exits.  A parked strand can already be
+	 * running again elsewhere, so this only finishes a close once the last
+	 * runner has left and no request is still with the scheduler
+	 */
+	void io_strand::leave( ring_buffer<networking::io_task> &dropped ) {
+		if( --m_running == 0 and m_closed and not m_self ) {
+			drop_tasks( dropped );
+		}
+		m_idle.notify_all( );
+	}
+
+	/***
+	 * Runs on the scheduler after the current batch of events has been
+	 * collected, so no event can still refer to this strand once it is
+	 * released.  When the strand is running the runner drops the tasks instead.
+	 * A request the scheduler cannot cancel right away, e.g. one io_uring
+	 * still owns, keeps the strand parked until its completion arrives and the
+	 * runner it is posted to drops the tasks
+	 */
+	void io_strand::close( ) {
+		auto self = std::shared_ptr<io_strand>( );
+		auto dropped = dropped_tasks( );
+		auto const lck = std::unique_lock( m_mutex );
+		m_closed = true;
+		if( m_self and m_scheduler->cancel( *this ) ) {
+			self = std::move( m_self );
+		}
+		if( m_running == 0 and not m_self ) {
+			drop_tasks( dropped.tasks );
+		}
+		m_idle.notify_all( );
+	}
+
+	/// Called with the lock held to hand every task to dropped
+	void io_strand::drop_tasks( ring_buffer<networking::io_task> &dropped ) {
+		dropped = std::move( m_tasks );
+		if( m_head ) {
+			dropped.push_back( std::move( m_head ) );
+		}
+		m_active = false;
+	}
+
+	void io_strand::shutdown( ) {
+		if( m_scheduler->in_scheduler_thread( ) ) {
+			close( );
+		} else {
+			m_scheduler->post_close( shared_from_this( ) );
+		}
+		auto lck = std::unique_lock( m_mutex );
+		// Until then the kernel can still be using the request's buffers
+		m_idle.wait( lck,
+		             [&] { return m_closed and m_running == 0 and not m_self; } );
+	}
+
+	/***
+	 * m_request only changes while the strand is not parked, so it is safe to
+	 * read once m_self shows that it is
+	 */
+	void io_strand::interrupt( ) {
+		auto const lck = std::unique_lock( m_mutex );
+		if( m_self and m_request.stop_requested( ) ) {
+			m_scheduler->interrupt( *this );
+		}
+	}
+
+	bool io_strand::idle( ) const {
+		auto const lck = std::unique_lock( m_mutex );
+		return not m_active;
+	}
+
+	bool io_strand::closed( ) const {
+		auto const lck = std::unique_lock( m_mutex );
+		return m_closed;
+	}
+
+	std::shared_ptr<io_strand> io_strand::unpark( ) {
+		auto const lck = std::unique_lock( m_mutex );
+		return std::move( m_self );
+	}
+
+	void io_strand::complete( ::ssize_t result ) {
+		m_result = result;
+		m_request = { };
+	}
+
+	duplex_strand::duplex_strand( io_scheduler &scheduler )
+	  : m_lanes{ std::make_shared<io_strand>( scheduler, this, 0 ),
+	             std::make_shared<io_strand>( scheduler, this, 1 ) } {}
+
+	duplex_strand::~duplex_strand( ) {
+		shutdown( );
+	}
+
+	/***
+	 * Reads and writes go straight to their lane unless tasks are held, then
+	 * they queue behind the exclusive task that is holding them
+	 */
+	void duplex_strand::add_io_task( task_kind kind, networking::io_task tsk ) {
+		auto lck = std::unique_lock( m_mutex );
+		if( m_closed ) {
+			lck.unlock( );
+			networking::cancel_io_task( std::move( tsk ) );
+			return;
+		}
+		if( kind != task_kind::exclusive and
+		    not m_gated.load( std::memory_order_relaxed ) ) {
+			lane( kind ).add_io_task( std::move( tsk ) );
+			return;
+		}
+		m_held.push_back( held_task{ std::move( tsk ), kind } );
+		m_gated.store( true, std::memory_order_seq_cst );
+		advance( );
+	}
+
+	/***
+	 * Called with the lock held to release the held tasks that can run.  The
+	 * exclusive task at the front starts once both lanes are idle and is done
+	 * when the write lane is idle again
+	 */
+	void duplex_strand::advance( ) {
+		while( true ) {
+			if( m_exclusive_running ) {
+				if( not lane( task_kind::write ).idle( ) ) {
+					return;
+				}
+				m_exclusive_running = false;
+			}
+			if( m_held.empty( ) ) {
+				break;
+			}
+			auto const kind = m_held.front( ).kind;
+			if( kind == task_kind::exclusive ) {
+				if( not lane( task_kind::read ).idle( ) or
+				    not lane( task_kind::write ).idle( ) ) {
+					return;
+				}
+				m_exclusive_running = true;
+			}
+			lane( kind ).add_io_task( m_held.pop_front( ).task );
+		}
+		m_gated.store( false, std::memory_order_seq_cst );
+		m_released.notify_all( );
+	}
+
+	/***
+	 * m_gated is set before a task is held, so a lane going idle either sees
+	 * it or went idle before the held task checks the lanes
+	 */
+	void duplex_strand::lane_idle( ) {
+		if( not m_gated.load( std::memory_order_seq_cst ) ) {
+			return;
+		}
+		auto const lck = std::unique_lock( m_mutex );
+		if( not m_closed ) {
+			advance( );
+		}
+	}
+
+	void duplex_strand::interrupt( ) {
+		for( auto &strand : m_lanes ) {
+			strand->interrupt( );
+		}
+	}
+
+	void duplex_strand::wait( ) const {
+		{
+			auto lck = std::unique_lock( m_mutex );
+			m_released.wait( lck, [&] {
+				return m_closed or not m_gated.load( std::memory_order_relaxed );
+			} );
+		}
+		for( auto const &strand : m_lanes ) {
+			strand->wait( );
+		}
+	}
+
+	/// The lanes drop their tasks first, they were queued before the held ones
+	void duplex_strand::shutdown( ) {
+		auto held = ring_buffer<held_task>( );
+		{
+			auto const lck = std::unique_lock( m_mutex );
+			if( m_closed ) {
+				return;
+			}
+			m_closed = true;
+			held = std::move( m_held );
+			m_released.notify_all( );
+		}
+		for( auto &strand : m_lanes ) {
+			strand->shutdown( );
+		}
+		while( not held.empty( ) ) {
+			networking::cancel_io_task( held.pop_front( ).task );
+		}
+	}
+
+	bool strand_queue::push( std::shared_ptr<io_strand> strand ) {
+		auto const lck = std::unique_lock( m_mutex );
+		bool const was_empty = m_ready.empty( ) and m_closing.empty( );
+		m_ready.push_back( std::move( strand ) );
+		return was_empty;
+	}
+
+	bool strand_queue::push_close( std::shared_ptr<io_strand> strand ) {
+		auto const lck = std::unique_lock( m_mutex );
+		bool const was_empty = m_ready.empty( ) and m_closing.empty( );
+		m_closing.push_back( std::move( strand ) );
+		return was_empty;
+	}
+
+	bool strand_queue::empty( ) const {
+		auto const lck = std::unique_lock( m_mutex );
+		return m_ready.empty( ) and m_closing.empty( );
+	}
+
+	void strand_queue::take( std::vector<std::shared_ptr<io_strand>> &ready,
+	                         std::vector<std::shared_ptr<io_strand>> &closing ) {
+		auto const lck = std::unique_lock( m_mutex );
+		std::move( m_ready.begin( ), m_ready.end( ), std::back_inserter( ready ) );
+		m_ready.clear( );
+		std::move( m_closing.begin( ), m_closing.end( ),
+		           std::back_inserter( closing ) );
+		m_closing.clear( );
+	}
+} // namespace daw::details
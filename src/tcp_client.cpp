@@ -11,82 +11,120 @@
 #include <string_view>
 
 namespace daw::networking {
-	unique_tcp_client::unique_tcp_client( )
-	  : m_socket( std::make_unique<network_socket>( address_family::Unspecified,
-	                                                socket_types::Stream ) ) {}
+	template<typename ExecPolicy>
+	basic_unique_tcp_client<ExecPolicy>::basic_unique_tcp_client( )
+	  : m_socket( std::make_unique<socket_type>( address_family::Unspecified,
+	                                             socket_types::Stream ) ) {}
 
-	shared_tcp_client::shared_tcp_client( )
-	  : m_socket( std::make_shared<network_socket>( address_family::Unspecified,
-	                                                socket_types::Stream ) ) {}
+	template<typename ExecPolicy>
+	basic_shared_tcp_client<ExecPolicy>::basic_shared_tcp_client( )
+	  : m_socket( std::make_shared<socket_type>( address_family::Unspecified,
+	                                             socket_types::Stream ) ) {}
 
-	unique_tcp_client::unique_tcp_client( std::string_view host,
-	                                      std::uint16_t port )
-	  : unique_tcp_client( ) {
+	template<typename ExecPolicy>
+	basic_unique_tcp_client<ExecPolicy>::basic_unique_tcp_client(
+	  std::string_view host, std::uint16_t port )
+	  : basic_unique_tcp_client( ) {
 
 		m_socket->connect( host, port );
 	}
 
-	shared_tcp_client::shared_tcp_client( std::string_view host,
-	                                      std::uint16_t port )
-	  : shared_tcp_client( ) {
+	template<typename ExecPolicy>
+	basic_shared_tcp_client<ExecPolicy>::basic_shared_tcp_client(
+	  std::string_view host, std::uint16_t port )
+	  : basic_shared_tcp_client( ) {
 
 		m_socket->connect( host, port );
 	}
 
-	void unique_tcp_client::connect( std::string_view host, std::uint16_t port ) {
+	template<typename ExecPolicy>
+	basic_unique_tcp_client<ExecPolicy>::basic_unique_tcp_client(
+	  std::unique_ptr<socket_type> socket )
+	  : m_socket( std::move( socket ) ) {}
+
+	template<typename ExecPolicy>
+	void basic_unique_tcp_client<ExecPolicy>::connect( std::string_view host,
+	                                                   std::uint16_t port ) {
 		m_socket->connect( host, port );
 	}
 
-	void shared_tcp_client::connect( std::string_view host, std::uint16_t port ) {
+	template<typename ExecPolicy>
+	void basic_shared_tcp_client<ExecPolicy>::connect( std::string_view host,
+	                                                   std::uint16_t port ) {
 		m_socket->connect( host, port );
 	}
 
-	void unique_tcp_client::close( ) {
+	template<typename ExecPolicy>
+	void basic_unique_tcp_client<ExecPolicy>::close( ) {
 		m_socket->close( );
 	}
 
-	void shared_tcp_client::close( ) {
+	template<typename ExecPolicy>
+	void basic_shared_tcp_client<ExecPolicy>::close( ) {
 		m_socket->close( );
 	}
 
-	shared_tcp_client::shared_tcp_client( unique_tcp_client &&other )
+	template<typename ExecPolicy>
+	basic_shared_tcp_client<ExecPolicy>::basic_shared_tcp_client(
+	  basic_unique_tcp_client<ExecPolicy> &&other )
 	  : m_socket( other.m_socket.release( ) ) {}
 
-	async_result<void> unique_tcp_client::connect_async( std::string_view host,
-	                                                     std::uint16_t port ) {
-		return m_socket->connect_async( host, port );
+	template<typename ExecPolicy>
+	async_result<void>
+	basic_unique_tcp_client<ExecPolicy>::connect_async( std::string_view host,
+	                                                    std::uint16_t port,
+	                                                    std::stop_token stop ) {
+		return m_socket->connect_async( host, port, std::move( stop ) );
 	}
 
-	async_result<void>
-	unique_tcp_client::connect_async( std::string_view host, std::uint16_t port,
-	                                  std::function<void( )> on_completion ) {
+	template<typename ExecPolicy>
+	async_result<void> basic_unique_tcp_client<ExecPolicy>::connect_async(
+	  std::string_view host, std::uint16_t port,
+	  std::function<void( )> on_completion, std::stop_token stop ) {
 
-		return m_socket->connect_async( host, port, std::move( on_completion ) );
+		return m_socket->connect_async( host, port, std::move( on_completion ),
+		                                std::move( stop ) );
 	}
 
-	async_result<void> unique_tcp_client::close_async( ) {
+	template<typename ExecPolicy>
+	async_result<void> basic_unique_tcp_client<ExecPolicy>::close_async( ) {
 		return m_socket->close_async( );
 	}
 
-	std::size_t unique_tcp_client::write( daw::span<const char> buffer ) {
+	template<typename ExecPolicy>
+	std::size_t
+	basic_unique_tcp_client<ExecPolicy>::write( daw::span<const char> buffer ) {
 		return m_socket->send( buffer );
 	}
 
-	std::size_t unique_tcp_client::read( daw::span<char> buffer ) {
+	template<typename ExecPolicy>
+	std::size_t
+	basic_unique_tcp_client<ExecPolicy>::read( daw::span<char> buffer ) {
 		return m_socket->receive( buffer );
 	}
 
-	async_result<void>
-	unique_tcp_client::write_async( daw::span<const char> buffer ) {
-		return m_socket->send_async( buffer );
+	template<typename ExecPolicy>
+	async_result<void> basic_unique_tcp_client<ExecPolicy>::write_async(
+	  daw::span<const char> buffer, std::stop_token stop ) {
+		return m_socket->send_async( buffer, 0, std::move( stop ) );
+	}
+
+	template<typename ExecPolicy>
+	async_result<std::size_t>
+	basic_unique_tcp_client<ExecPolicy>::read_async( daw::span<char> buffer,
+	                                                 std::stop_token stop ) {
+		return m_socket->receive_async( buffer, 0, std::move( stop ) );
 	}
 
+	template<typename ExecPolicy>
 	async_result<std::size_t>
-	unique_tcp_client::read_async( daw::span<char> buffer ) {
-		return m_socket->receive_async( buffer );
+	basic_unique_tcp_client<ExecPolicy>::read_some_async( daw::span<char> buffer,
+	                                                      std::stop_token stop ) {
+		return m_socket->receive_some_async( buffer, 0, std::move( stop ) );
 	}
 
-	async_result<void> unique_tcp_client::read_async(
+	template<typename ExecPolicy>
+	async_result<void> basic_unique_tcp_client<ExecPolicy>::read_async(
 	  daw::span<char> buffer,
 	  std::function<std::optional<daw::span<char>>( daw::span<char>,
 	                                                std::size_t )>
@@ -94,7 +132,8 @@ namespace daw::networking {
 		return m_socket->receive_async( buffer, std::move( on_completion ) );
 	}
 
-	async_result<void> unique_tcp_client::write_async(
+	template<typename ExecPolicy>
+	async_result<void> basic_unique_tcp_client<ExecPolicy>::write_async(
 	  daw::span<const char> buffer,
 	  std::function<std::optional<daw::span<const char>>( daw::span<const char>,
 	                                                      std::size_t )>
@@ -102,7 +141,8 @@ namespace daw::networking {
 		return m_socket->send_async( buffer, std::move( on_completion ) );
 	}
 
-	async_result<void> shared_tcp_client::write_async(
+	template<typename ExecPolicy>
+	async_result<void> basic_shared_tcp_client<ExecPolicy>::write_async(
 	  daw::span<const char> buffer,
 	  std::function<std::optional<daw::span<const char>>( daw::span<const char>,
 	                                                      std::size_t )>
@@ -110,25 +150,40 @@ namespace daw::networking {
 		return m_socket->send_async( buffer, std::move( on_completion ) );
 	}
 
-	std::size_t shared_tcp_client::write( daw::span<const char> buffer ) {
+	template<typename ExecPolicy>
+	std::size_t
+	basic_shared_tcp_client<ExecPolicy>::write( daw::span<const char> buffer ) {
 		return m_socket->send( buffer );
 	}
 
-	std::size_t shared_tcp_client::read( daw::span<char> buffer ) {
+	template<typename ExecPolicy>
+	std::size_t
+	basic_shared_tcp_client<ExecPolicy>::read( daw::span<char> buffer ) {
 		return m_socket->receive( buffer );
 	}
 
-	async_result<void>
-	shared_tcp_client::write_async( daw::span<const char> buffer ) {
-		return m_socket->send_async( buffer );
+	template<typename ExecPolicy>
+	async_result<void> basic_shared_tcp_client<ExecPolicy>::write_async(
+	  daw::span<const char> buffer, std::stop_token stop ) {
+		return m_socket->send_async( buffer, 0, std::move( stop ) );
+	}
+
+	template<typename ExecPolicy>
+	async_result<std::size_t>
+	basic_shared_tcp_client<ExecPolicy>::read_async( daw::span<char> buffer,
+	                                                 std::stop_token stop ) {
+		return m_socket->receive_async( buffer, 0, std::move( stop ) );
 	}
 
+	template<typename ExecPolicy>
 	async_result<std::size_t>
-	shared_tcp_client::read_async( daw::span<char> buffer ) {
-		return m_socket->receive_async( buffer );
+	basic_shared_tcp_client<ExecPolicy>::read_some_async( daw::span<char> buffer,
+	                                                      std::stop_token stop ) {
+		return m_socket->receive_some_async( buffer, 0, std::move( stop ) );
 	}
 
-	async_result<void> shared_tcp_client::read_async(
+	template<typename ExecPolicy>
+	async_result<void> basic_shared_tcp_client<ExecPolicy>::read_async(
 	  daw::span<char> buffer,
 	  std::function<std::optional<daw::span<char>>( daw::span<char>,
 	                                                std::size_t )>
@@ -136,19 +191,67 @@ namespace daw::networking {
 		return m_socket->receive_async( buffer, std::move( on_completion ) );
 	}
 
-	async_result<void> shared_tcp_client::close_async( ) {
-		return m_socket->close_async( );
+#if defined( __linux__ )
+	template<typename ExecPolicy>
+	async_result<void> basic_unique_tcp_client<ExecPolicy>::write_zerocopy_async(
+	  daw::span<const char> buffer ) {
+		return m_socket->send_zerocopy_async( buffer );
 	}
 
-	async_result<void> shared_tcp_client::connect_async( std::string_view host,
-	                                                     std::uint16_t port ) {
-		return m_socket->connect_async( host, port );
+	template<typename ExecPolicy>
+	async_result<std::size_t>
+	basic_unique_tcp_client<ExecPolicy>::write_file_async( int fd, ::off_t offset,
+	                                                       std::size_t count,
+	                                                       std::stop_token stop ) {
+		return m_socket->send_file_async( fd, offset, count, std::move( stop ) );
+	}
+
+	template<typename ExecPolicy>
+	async_result<void> basic_shared_tcp_client<ExecPolicy>::write_zerocopy_async(
+	  daw::span<const char> buffer ) {
+		return m_socket->send_zerocopy_async( buffer );
+	}
+
+	template<typename ExecPolicy>
+	async_result<std::size_t>
+	basic_shared_tcp_client<ExecPolicy>::write_file_async( int fd, ::off_t offset,
+	                                                       std::size_t count,
+	                                                       std::stop_token stop ) {
+		return m_socket->send_file_async( fd, offset, count, std::move( stop ) );
 	}
+#endif
 
+	template<typename ExecPolicy>
+	async_result<void> basic_shared_tcp_client<ExecPolicy>::close_async( ) {
+		return m_socket->close_async( );
+	}
+
+	template<typename ExecPolicy>
 	async_result<void>
-	shared_tcp_client::connect_async( std::string_view host, std::uint16_t port,
-	                                  std::function<void( )> on_completion ) {
+	basic_shared_tcp_client<ExecPolicy>::connect_async( std::string_view host,
+	                                                    std::uint16_t port,
+	                                                    std::stop_token stop ) {
+		return m_socket->connect_async( host, port, std::move( stop ) );
+	}
+
+	template<typename ExecPolicy>
+	async_result<void> basic_shared_tcp_client<ExecPolicy>::connect_async(
+	  std::string_view host, std::uint16_t port,
+	  std::function<void( )> on_completion, std::stop_token stop ) {
 
-		return m_socket->connect_async( host, port, std::move( on_completion ) );
+		return m_socket->connect_async( host, port, std::move( on_completion ),
+		                                std::move( stop ) );
 	}
+
+	template class basic_unique_tcp_client<async_exec_policy_thread>;
+	template class basic_shared_tcp_client<async_exec_policy_thread>;
+
+#if defined( __linux__ )
+	template class basic_unique_tcp_client<async_exec_policy_epoll>;
+	template class basic_shared_tcp_client<async_exec_policy_epoll>;
+	template class basic_unique_tcp_client<async_exec_policy_uring>;
+	template class basic_shared_tcp_client<async_exec_policy_uring>;
+	template class basic_unique_tcp_client<async_exec_policy_pool>;
+	template class basic_shared_tcp_client<async_exec_policy_pool>;
+#endif
 } // namespace daw::networking
@@ -0,0 +1,94 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/tcp_server.h"
+
+#include <daw/daw_benchmark.h>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+	using namespace daw::networking;
+
+	constexpr std::size_t connections_per_thread = 2000;
+
+	/***
+	 * Connect and reset, linger 0 keeps the client side out of TIME_WAIT so a
+	 * long run does not exhaust ephemeral ports
+	 */
+	void connect_and_reset( std::uint16_t port ) {
+		int const fd = ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+		daw::expecting( fd >= 0 );
+		auto addr = ::sockaddr_in( );
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons( port );
+		addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+		daw::expecting( ::connect( fd, reinterpret_cast<::sockaddr const *>( &addr ),
+		                           sizeof( addr ) ) == 0 );
+		auto const no_linger = ::linger{ 1, 0 };
+		(void)::setsockopt( fd, SOL_SOCKET, SO_LINGER, &no_linger,
+		                    sizeof( no_linger ) );
+		::close( fd );
+	}
+
+	/***
+	 * Connections per second accepted by a server with shard_count listeners
+	 * on a pool of the same size, with one connecting thread per shard
+	 */
+	void accept_rate( std::size_t shard_count ) {
+		auto pool = daw::work_stealing_pool( shard_count, true );
+		auto server = pool_tcp_server( pool );
+		auto accepted = std::atomic<std::size_t>( 0 );
+		server.listen( "127.0.0.1", 0, [&]( pool_tcp_server::client_type ) {
+			// Dropping the client closes the connection
+			accepted.fetch_add( 1, std::memory_order_relaxed );
+		} );
+
+		auto const total = connections_per_thread * shard_count;
+		auto const start = std::chrono::steady_clock::now( );
+		{
+			auto connectors = std::vector<std::thread>( );
+			for( std::size_t t = 0; t < shard_count; ++t ) {
+				connectors.emplace_back( [&] {
+					for( std::size_t n = 0; n < connections_per_thread; ++n ) {
+						connect_and_reset( server.port( ) );
+					}
+				} );
+			}
+			for( auto &c : connectors ) {
+				c.join( );
+			}
+		}
+		while( accepted.load( std::memory_order_relaxed ) < total ) {
+			std::this_thread::yield( );
+		}
+		auto const elapsed = std::chrono::duration<double>(
+		  std::chrono::steady_clock::now( ) - start );
+		server.close( );
+		std::cout << shard_count << " shard(s): " << total << " connections in "
+		          << elapsed.count( ) << "s, "
+		          << static_cast<double>( total ) / elapsed.count( )
+		          << " connections/s\n";
+	}
+} // namespace
+
+int main( ) {
+	auto const max_shards = std::max( std::thread::hardware_concurrency( ), 1U );
+	for( std::size_t shards = 1; shards < max_shards; shards *= 2 ) {
+		accept_rate( shards );
+	}
+	accept_rate( max_shards );
+}
@@ -0,0 +1,135 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "test_echo_server.h"
+
+#include "daw/networking/network_socket.h"
+
+#include <daw/daw_benchmark.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <netinet/in.h>
+#include <new>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+	std::atomic<std::size_t> allocation_count = 0;
+} // namespace
+
+void *operator new( std::size_t size ) {
+	allocation_count.fetch_add( 1, std::memory_order_relaxed );
+	if( auto *p = std::malloc( size == 0 ? 1 : size ) ) {
+		return p;
+	}
+	throw std::bad_alloc( );
+}
+
+void operator delete( void *p ) noexcept {
+	std::free( p );
+}
+
+void operator delete( void *p, std::size_t ) noexcept {
+	std::free( p );
+}
+
+namespace {
+	using namespace daw::networking;
+
+	constexpr std::size_t rounds = 1000;
+
+	/// Allocations made by everything, on any thread, while f runs
+	template<typename F>
+	std::size_t count_allocations( F &&f ) {
+		auto const before = allocation_count.load( );
+		f( );
+		return allocation_count.load( ) - before;
+	}
+
+	template<typename ExecPolicy>
+	void executor_does_not_allocate( ) {
+		auto exec = ExecPolicy( );
+		std::size_t calls = 0;
+		auto const run = [&] {
+			for( std::size_t n = 0; n < rounds; ++n ) {
+				exec.add_task( [&calls] { ++calls; } );
+				exec.add_io_task(
+				  [&calls, buff = std::array<char, 32>{ }]( ::ssize_t ) -> io_request {
+					  daw::do_not_optimize( buff );
+					  ++calls;
+					  return { };
+				  } );
+			}
+			exec.wait( );
+		};
+		// The first round sizes the queues
+		run( );
+		daw::expecting( 0U, count_allocations( run ) );
+		daw::expecting( 4 * rounds, calls );
+	}
+
+	/***
+	 * Once the socket is connected and the result states have been pooled a
+	 * send/receive round trip allocates nothing
+	 */
+	void socket_ops_do_not_allocate( std::uint16_t port ) {
+		auto sock = epoll_network_socket( address_family::IPv4, socket_types::Stream );
+		sock.connect_async( "127.0.0.1", port ).get( );
+		auto const message = std::string( "allocation free" );
+		auto reply = std::string( message.size( ), '\0' );
+		auto const round_trip = [&] {
+			for( std::size_t n = 0; n < rounds; ++n ) {
+				sock.send_async( message ).get( );
+				daw::expecting( message.size( ), sock.receive_async( reply ).get( ) );
+			}
+		};
+		round_trip( );
+		daw::expecting( 0U, count_allocations( round_trip ) );
+		sock.close_async( ).get( );
+	}
+
+	/***
+	 * Once the result states and connect addresses have been pooled a
+	 * connect and close cycle allocates nothing.  The listener is driven with
+	 * raw syscalls so it does not allocate either
+	 */
+	void connect_close_does_not_allocate( ) {
+		int const listener = ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+		auto address = socket_address::from_numeric( "127.0.0.1", 0 );
+		daw::expecting( listener >= 0 and
+		                ::bind( listener, address.data( ), address.size ) == 0 and
+		                ::listen( listener, SOMAXCONN ) == 0 and
+		                ::getsockname( listener, address.data( ), &address.size ) ==
+		                  0 );
+		auto sock =
+		  epoll_network_socket( address_family::IPv4, socket_types::Stream );
+		auto const cycle = [&] {
+			for( std::size_t n = 0; n < rounds; ++n ) {
+				sock.connect_async( address ).get( );
+				int const fd = ::accept4( listener, nullptr, nullptr, SOCK_CLOEXEC );
+				daw::expecting( fd >= 0 );
+				(void)::close( fd );
+				sock.close_async( ).get( );
+			}
+		};
+		cycle( );
+		daw::expecting( 0U, count_allocations( cycle ) );
+		(void)::close( listener );
+	}
+} // namespace
+
+int main( ) {
+	executor_does_not_allocate<daw::async_exec_policy_thread>( );
+	executor_does_not_allocate<daw::async_exec_policy_epoll>( );
+	executor_does_not_allocate<daw::async_exec_policy_pool>( );
+	auto server = test::echo_server( );
+	socket_ops_do_not_allocate( server.port( ) );
+	connect_close_does_not_allocate( );
+}
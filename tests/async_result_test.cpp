@@ -0,0 +1,139 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/async_result.h"
+#include "daw/networking/network_exception.h"
+#include "daw/networking/task_token.h"
+
+#include "third_party/jthread.hpp"
+
+#include <daw/daw_benchmark.h>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	using daw::async_result;
+	using daw::async_result_state;
+
+	void then_chains_values( ) {
+		auto first = async_result_state<int>::make( );
+		auto result = async_result<int>( first )
+		                .then( []( int v ) { return v * 2; } )
+		                .then( []( int v ) { return std::to_string( v ); } );
+		daw::expecting( not result.try_wait( ) );
+		auto worker = std::jthread( [first] { first->set_value( 21 ); } );
+		daw::expecting( std::string( "42" ), result.get( ) );
+	}
+
+	void then_unwraps_async_results( ) {
+		auto first = async_result_state<void>::make( );
+		auto second = async_result_state<std::size_t>::make( );
+		auto result = async_result<void>( first ).then(
+		  [second] { return async_result<std::size_t>( second ); } );
+		first->set_value( );
+		daw::expecting( not result.try_wait( ) );
+		second->set_value( 5U );
+		daw::expecting( 5U, result.get( ) );
+	}
+
+	void then_passes_failures( ) {
+		auto first = async_result_state<int>::make( );
+		bool called = false;
+		auto result =
+		  async_result<int>( first ).then( [&]( int ) { called = true; } );
+		first->set_error( "send error", 104 );
+		daw::expecting( not called );
+		long long error_code = 0;
+		try {
+			result.get( );
+		} catch( daw::networking::network_exception const &ex ) {
+			error_code = ex.error_code( );
+		}
+		daw::expecting( 104LL, error_code );
+	}
+
+	std::vector<daw::async_state_ptr<int>> make_states( ) {
+		auto states = std::vector<daw::async_state_ptr<int>>( );
+		for( int n = 0; n < 8; ++n ) {
+			states.push_back( async_result_state<int>::make( ) );
+		}
+		return states;
+	}
+
+	std::vector<async_result<int>>
+	results_of( std::vector<daw::async_state_ptr<int>> const &states ) {
+		return { states.begin( ), states.end( ) };
+	}
+
+	void when_all_waits_for_every_result( ) {
+		auto const states = make_states( );
+		auto results = results_of( states );
+		auto all = daw::when_all( results );
+		states[3]->set_value( 3 );
+		daw::expecting( not all.try_wait( ) );
+		{
+			auto workers = std::vector<std::jthread>( );
+			for( int n = 0; n < 8; ++n ) {
+				if( n != 3 ) {
+					workers.emplace_back( [&states, n] { states[n]->set_value( n ); } );
+				}
+			}
+		}
+		all.get( );
+		for( int n = 0; n < 8; ++n ) {
+			daw::expecting( n, results[n].get( ) );
+		}
+	}
+
+	void when_any_takes_the_first( ) {
+		auto const states = make_states( );
+		auto any = daw::when_any( results_of( states ) );
+		daw::expecting( not any.try_wait( ) );
+		states[5]->set_value( 5 );
+		states[2]->set_value( 2 );
+		daw::expecting( 5U, any.get( ) );
+	}
+
+	/***
+	 * Results arriving while the waiter spins, once it has learnt how long
+	 * they take, and after it has parked are all seen
+	 */
+	void waits_spin_then_park( ) {
+		using namespace std::chrono_literals;
+		for( auto const delay : { 0us, 20us, 2000us } ) {
+			for( int n = 0; n < 16; ++n ) {
+				auto state = async_result_state<int>::make( );
+				auto worker = std::jthread( [state, delay, n] {
+					std::this_thread::sleep_for( delay );
+					state->set_value( n );
+				} );
+				daw::expecting( n, async_result<int>( state ).get( ) );
+			}
+		}
+		daw::set_wait_spin_limit( 0ns );
+		auto token = daw::task_token( );
+		auto worker = std::jthread( [token]( ) mutable {
+			std::this_thread::sleep_for( 1ms );
+			token.notify( );
+		} );
+		token.wait( );
+		daw::expecting( static_cast<bool>( token ) );
+		daw::set_wait_spin_limit( 50us );
+	}
+} // namespace
+
+int main( ) {
+	then_chains_values( );
+	then_unwraps_async_results( );
+	then_passes_failures( );
+	when_all_waits_for_every_result( );
+	when_any_takes_the_first( );
+	waits_spin_then_park( );
+}
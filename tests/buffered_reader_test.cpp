@@ -0,0 +1,87 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/buffered_reader.h"
+#include "daw/networking/tcp_client.h"
+
+#include <daw/daw_benchmark.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace {
+	using namespace daw::networking;
+
+	std::pair<unique_tcp_client, unique_tcp_client> connected_clients( ) {
+		auto sockets =
+		  make_socket_pair<daw::async_exec_policy_thread>( socket_types::Stream );
+		return { unique_tcp_client( std::move( sockets.first ) ),
+		         unique_tcp_client( std::move( sockets.second ) ) };
+	}
+
+	void send( unique_tcp_client &client, std::string_view data ) {
+		daw::expecting( data.size( ), client.write( { data.data( ), data.size( ) } ) );
+	}
+
+	std::string_view view( daw::span<char const> data ) {
+		return { data.data( ), data.size( ) };
+	}
+
+	int error_of( daw::async_result<daw::span<char const>> result ) {
+		try {
+			(void)result.get( );
+		} catch( network_exception const &ex ) {
+			return static_cast<int>( ex.error_code( ) );
+		}
+		return 0;
+	}
+
+	void frames_a_stream( ) {
+		auto [writer, client] = connected_clients( );
+		auto reader = basic_buffered_reader( client );
+		send( writer, "GET / HTTP/1.1\r\nHost: a\r\n\r\n" );
+		send( writer, std::string_view( "\x00\x04"
+		                                 "body",
+		                                 6 ) );
+		daw::expecting( "GET / HTTP/1.1\r\n",
+		                view( reader.read_until( "\r\n" ).get( ) ) );
+		daw::expecting( "Host: a\r\n", view( reader.read_until( "\r\n" ).get( ) ) );
+		daw::expecting( "\r\n", view( reader.read_until( "\r\n" ).get( ) ) );
+		auto const header = reader.peek( 2 ).get( );
+		auto const length = static_cast<std::size_t>( header[1] );
+		reader.consume( 2 );
+		daw::expecting( "body", view( reader.read_exactly( length ).get( ) ) );
+		writer.close( );
+		daw::expecting( ENODATA, error_of( reader.read_exactly( 1 ) ) );
+	}
+
+	/***
+	 * Records straddle the end of a one page ring, and a delimiter split
+	 * between sends is still found
+	 */
+	void wraps_around( ) {
+		auto [writer, client] = connected_clients( );
+		auto reader = basic_buffered_reader( client, 1 );
+		auto const line = std::string( 1000, 'x' ) + "\r\n";
+		for( int n = 0; n < 20; ++n ) {
+			send( writer, std::string_view( line ).substr( 0, 1001 ) );
+			send( writer, std::string_view( line ).substr( 1001 ) );
+			daw::expecting( line, view( reader.read_until( "\r\n" ).get( ) ) );
+		}
+		send( writer, std::string( reader.capacity( ) + 1, 'y' ) );
+		daw::expecting( EMSGSIZE, error_of( reader.read_until( "\n" ) ) );
+		daw::expecting( EMSGSIZE,
+		                error_of( reader.read_exactly( reader.capacity( ) + 1 ) ) );
+	}
+} // namespace
+
+int main( ) {
+	frames_a_stream( );
+	wraps_around( );
+}
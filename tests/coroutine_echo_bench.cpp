@@ -0,0 +1,113 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "test_echo_server.h"
+
+#include "daw/networking/network_socket.h"
+
+#include <daw/daw_benchmark.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if not defined( __cpp_impl_coroutine )
+#error "coroutine_echo_bench needs C++20 coroutines"
+#endif
+
+namespace {
+	using namespace daw::networking;
+	using socket_t = epoll_network_socket;
+
+	constexpr std::size_t socket_count = 64;
+	constexpr std::size_t rounds = 100;
+	constexpr std::size_t message_size = 64;
+
+	struct connection {
+		socket_t sock{ address_family::IPv4, socket_types::Stream };
+		std::string message = std::string( message_size, 'x' );
+		std::string reply = std::string( message_size, '\0' );
+		std::size_t received = 0;
+		std::size_t rounds_left = 0;
+	};
+
+	std::vector<std::unique_ptr<connection>> connect_all( std::uint16_t port ) {
+		auto connections = std::vector<std::unique_ptr<connection>>( );
+		auto connects = std::vector<daw::async_result<void>>( );
+		for( std::size_t n = 0; n < socket_count; ++n ) {
+			connections.push_back( std::make_unique<connection>( ) );
+			connects.push_back(
+			  connections.back( )->sock.connect_async( "127.0.0.1", port ) );
+		}
+		daw::when_all( std::move( connects ) ).get( );
+		return connections;
+	}
+
+	daw::async_result<void> echo_coroutine( connection &conn ) {
+		for( std::size_t r = 0; r < rounds; ++r ) {
+			co_await conn.sock.send_async( conn.message );
+			auto const count = co_await conn.sock.receive_async( conn.reply );
+			daw::expecting( message_size, count );
+		}
+	}
+
+	/***
+	 * The same exchange driven by the callback overloads.  Each completed
+	 * reply starts the next round from inside the callback
+	 */
+	void echo_callback_round( connection &conn, std::atomic<std::size_t> &done ) {
+		(void)conn.sock.send_async( conn.message );
+		conn.received = 0;
+		(void)conn.sock.receive_async(
+		  conn.reply,
+		  [&conn, &done]( daw::span<char> buffer,
+		                  std::size_t count ) -> std::optional<daw::span<char>> {
+			  conn.received += count;
+			  if( conn.received < message_size ) {
+				  buffer.remove_prefix( count );
+				  return buffer;
+			  }
+			  if( --conn.rounds_left > 0 ) {
+				  echo_callback_round( conn, done );
+			  } else {
+				  done.fetch_add( 1 );
+			  }
+			  return std::nullopt;
+		  } );
+	}
+} // namespace
+
+int main( ) {
+	auto server = test::echo_server( );
+	auto connections = connect_all( server.port( ) );
+	auto const bytes = socket_count * rounds * message_size * 2;
+
+	daw::bench_n_test_mbs<5>( "coroutine echo", bytes, [&] {
+		auto handlers = std::vector<daw::async_result<void>>( );
+		for( auto &conn : connections ) {
+			handlers.push_back( echo_coroutine( *conn ) );
+		}
+		daw::when_all( std::move( handlers ) ).get( );
+	} );
+
+	daw::bench_n_test_mbs<5>( "callback echo", bytes, [&] {
+		auto done = std::atomic<std::size_t>( 0 );
+		for( auto &conn : connections ) {
+			conn->rounds_left = rounds;
+			echo_callback_round( *conn, done );
+		}
+		while( done.load( ) != socket_count ) {
+			std::this_thread::yield( );
+		}
+	} );
+
+	for( auto &conn : connections ) {
+		conn->sock.close_async( ).get( );
+	}
+}
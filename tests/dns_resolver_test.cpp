@@ -0,0 +1,163 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "test_echo_server.h"
+
+#include "daw/networking/dns_resolver.h"
+#include "daw/networking/network_socket.h"
+
+#include <daw/daw_benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <netdb.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	using namespace daw::networking;
+	using namespace std::chrono_literals;
+
+	/***
+	 * Answers every name with 10.0.0.1 after a delay, counting the lookups
+	 */
+	struct counting_lookup {
+		std::atomic<int> *calls;
+		std::chrono::milliseconds ttl;
+
+		dns_answer operator( )( std::string const &host, address_family,
+		                        socket_types ) const {
+			calls->fetch_add( 1 );
+			std::this_thread::sleep_for( 20ms );
+			auto answer = dns_answer( );
+			if( host == "missing.test" ) {
+				answer.error = EAI_NONAME;
+				return answer;
+			}
+			answer.addresses.push_back( socket_address::from_numeric( "10.0.0.1", 0 ) );
+			answer.ttl = ttl;
+			return answer;
+		}
+	};
+
+	long long error_of( daw::async_result<address_list> result ) {
+		try {
+			(void)result.get( );
+		} catch( network_exception const &ex ) { return ex.error_code( ); }
+		return 0;
+	}
+
+	void coalesces_and_caches( ) {
+		auto calls = std::atomic<int>( 0 );
+		auto resolver = dns_resolver( { }, counting_lookup{ &calls, 0ms } );
+		auto results = std::vector<daw::async_result<address_list>>( );
+		for( int n = 0; n < 8; ++n ) {
+			results.push_back( resolver.resolve( "svc.test" ) );
+		}
+		for( auto &r : results ) {
+			daw::expecting( results[0].get( ).get( ), r.get( ).get( ) );
+		}
+		daw::expecting( 1, calls.load( ) );
+		daw::expecting( std::uint16_t{ 0 }, results[0].get( )->front( ).port( ) );
+
+		auto cached = resolver.resolve( "svc.test" );
+		daw::expecting( cached.try_wait( ) );
+		daw::expecting( 1, calls.load( ) );
+
+		resolver.clear( );
+		resolver.resolve( "svc.test" ).wait( );
+		daw::expecting( 2, calls.load( ) );
+
+		// Numeric hosts never reach the lookup
+		daw::expecting( resolver.resolve( "127.0.0.1" ).try_wait( ) );
+		daw::expecting( 2, calls.load( ) );
+	}
+
+	void expires_answers( ) {
+		auto calls = std::atomic<int>( 0 );
+		auto options = dns_resolver_options( );
+		options.negative_ttl = 10s;
+		auto resolver = dns_resolver( options, counting_lookup{ &calls, 30ms } );
+		resolver.resolve( "svc.test" ).wait( );
+		std::this_thread::sleep_for( 60ms );
+		resolver.resolve( "svc.test" ).wait( );
+		daw::expecting( 2, calls.load( ) );
+
+		daw::expecting( static_cast<long long>( EAI_NONAME ),
+		                error_of( resolver.resolve( "missing.test" ) ) );
+		daw::expecting( static_cast<long long>( EAI_NONAME ),
+		                error_of( resolver.resolve( "missing.test" ) ) );
+		daw::expecting( 3, calls.load( ) );
+	}
+
+	/***
+	 * A lookup that is not cached parks the connect until the resolver answers
+	 */
+	template<typename ExecPolicy>
+	void connects_through_hosts( std::uint16_t port ) {
+		auto resolver = dns_resolver(
+		  { }, dns_resolver::hosts_lookup( "# test hosts\n"
+		                                   "127.0.0.1 echo.test echo # alias\n" ) );
+		for( auto host : { "echo.test", "echo" } ) {
+			auto sock = basic_network_socket<ExecPolicy>(
+			  address_family::IPv4, socket_types::Stream );
+			sock.set_resolver( resolver );
+			auto const msg = std::string( "resolved" );
+			sock.connect_async( host, port ).get( );
+			sock.send_async( msg ).get( );
+			auto buffer = std::string( msg.size( ), '\0' );
+			daw::expecting( msg.size( ), sock.receive_async( buffer ).get( ) );
+			daw::expecting( msg, buffer );
+		}
+		auto sock = basic_network_socket<ExecPolicy>(
+		  address_family::IPv4, socket_types::Stream );
+		sock.set_resolver( resolver );
+		auto failed = false;
+		try {
+			sock.connect_async( "unknown.test", port ).get( );
+		} catch( network_exception const & ) { failed = true; }
+		daw::expecting( failed );
+	}
+
+	/***
+	 * Addresses that refuse or never answer ahead of the one that works
+	 */
+	template<typename ExecPolicy>
+	void races_addresses( std::uint16_t port ) {
+		auto resolver = dns_resolver(
+		  { }, dns_resolver::hosts_lookup( "::1 dual.test\n"
+		                                   "127.0.0.2 dual.test\n"
+		                                   "127.0.0.1 dual.test\n"
+		                                   "192.0.2.1 slow.test\n"
+		                                   "127.0.0.1 slow.test\n" ) );
+		for( auto host : { "dual.test", "slow.test" } ) {
+			auto sock = basic_network_socket<ExecPolicy>(
+			  address_family::Unspecified, socket_types::Stream );
+			sock.set_resolver( resolver );
+			auto const start = std::chrono::steady_clock::now( );
+			sock.connect_any_async( host, port, 50ms ).get( );
+			daw::expecting( std::chrono::steady_clock::now( ) - start < 2s );
+			auto const msg = std::string( "raced" );
+			sock.send_async( msg ).get( );
+			auto buffer = std::string( msg.size( ), '\0' );
+			daw::expecting( msg.size( ), sock.receive_async( buffer ).get( ) );
+			daw::expecting( msg, buffer );
+		}
+	}
+} // namespace
+
+int main( ) {
+	auto server = test::echo_server( );
+	coalesces_and_caches( );
+	expires_answers( );
+	connects_through_hosts<daw::async_exec_policy_thread>( server.port( ) );
+	connects_through_hosts<daw::async_exec_policy_epoll>( server.port( ) );
+	connects_through_hosts<daw::async_exec_policy_pool>( server.port( ) );
+	races_addresses<daw::async_exec_policy_thread>( server.port( ) );
+	races_addresses<daw::async_exec_policy_epoll>( server.port( ) );
+}
@@ -0,0 +1,68 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/details/locked_queue.h"
+#include "daw/networking/details/mpsc_queue.h"
+
+#include <daw/daw_benchmark.h>
+#include <daw/daw_scope_guard.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	constexpr std::size_t items_per_producer = 200'000;
+
+	/***
+	 * producer_count threads push tagged sequence numbers while one consumer
+	 * pops them, checking that each producer's items arrive in order
+	 */
+	template<typename Queue>
+	void contend( Queue &queue, std::size_t producer_count ) {
+		auto producers = std::vector<std::thread>( );
+		for( std::size_t p = 0; p < producer_count; ++p ) {
+			producers.emplace_back( [&queue, p] {
+				for( std::size_t n = 0; n < items_per_producer; ++n ) {
+					queue.push( ( static_cast<std::uint64_t>( p ) << 32U ) | n );
+				}
+			} );
+		}
+		auto next = std::vector<std::uint64_t>( producer_count, 0 );
+		for( std::size_t n = 0; n < producer_count * items_per_producer; ++n ) {
+			auto const item = queue.wait_and_pop( );
+			daw::expecting( item.has_value( ) );
+			auto const p = static_cast<std::size_t>( *item >> 32U );
+			daw::expecting( next[p]++, *item & 0xFFFF'FFFFU );
+		}
+		for( auto &t : producers ) {
+			t.join( );
+		}
+	}
+} // namespace
+
+int main( ) {
+	auto const max_producers =
+	  std::max( std::thread::hardware_concurrency( ), 2U ) - 1U;
+	for( std::size_t producers = 1; producers <= max_producers;
+	     producers *= 2 ) {
+		auto const items = producers * items_per_producer;
+		auto const suffix = " " + std::to_string( producers ) + " producer(s)";
+		daw::bench_n_test_mbs<3>(
+		  "locked_queue" + suffix, items * sizeof( std::uint64_t ), [&] {
+			  auto queue = daw::locked_queue<std::uint64_t>( );
+			  contend( queue, producers );
+		  } );
+		daw::bench_n_test_mbs<3>(
+		  "mpsc_queue" + suffix, items * sizeof( std::uint64_t ), [&] {
+			  auto queue = daw::mpsc_queue<std::uint64_t>( );
+			  contend( queue, producers );
+		  } );
+	}
+}
@@ -0,0 +1,101 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "daw/networking/network_socket.h"
+#include "daw/networking/tcp_server.h"
+
+#include <daw/daw_benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	using namespace daw::networking;
+
+	constexpr std::size_t socket_count = 64;
+	constexpr std::size_t rounds = 100;
+	constexpr std::size_t message_size = 64;
+
+	/***
+	 * Loopback echo through a server on a pool pinned to every core.  With
+	 * steering each connection is served on the core its packets arrive on.
+	 * On a multi-socket machine that keeps a connection's kernel and
+	 * userspace work on one NUMA node, without it they often differ
+	 */
+	void echo_load( bool steer ) {
+		auto const cores = std::max( std::thread::hardware_concurrency( ), 1U );
+		auto server_pool = daw::work_stealing_pool( cores, true );
+		auto client_pool = daw::work_stealing_pool( cores );
+		auto server = pool_tcp_server( server_pool );
+		server.set_incoming_cpu_steering( steer );
+		auto accepted_mutex = std::mutex( );
+		auto accepted = std::vector<pool_tcp_server::client_type>( );
+		server.listen( "127.0.0.1", 0, [&]( pool_tcp_server::client_type client ) {
+			auto const lck = std::unique_lock( accepted_mutex );
+			accepted.push_back( std::move( client ) );
+		} );
+
+		auto sockets = std::vector<std::unique_ptr<pool_network_socket>>( );
+		for( std::size_t n = 0; n < socket_count; ++n ) {
+			sockets.push_back( std::make_unique<pool_network_socket>(
+			  address_family::IPv4, socket_types::Stream, client_pool ) );
+			sockets.back( )->connect_async( "127.0.0.1", server.port( ) ).get( );
+		}
+		auto const accepted_count = [&] {
+			auto const lck = std::unique_lock( accepted_mutex );
+			return accepted.size( );
+		};
+		while( accepted_count( ) < socket_count ) {
+			std::this_thread::yield( );
+		}
+
+		auto const message = std::string( message_size, 'x' );
+		auto requests = std::vector<std::string>(
+		  socket_count, std::string( message_size, '\0' ) );
+		auto replies = std::vector<std::string>(
+		  socket_count, std::string( message_size, '\0' ) );
+
+		auto const title =
+		  std::string( steer ? "echo, steered" : "echo, unsteered" );
+		daw::bench_n_test_mbs<3>(
+		  title, socket_count * rounds * message_size * 2, [&]( ) {
+			  for( std::size_t r = 0; r < rounds; ++r ) {
+				  auto reads = std::vector<daw::async_result<std::size_t>>( );
+				  reads.reserve( socket_count );
+				  for( std::size_t n = 0; n < socket_count; ++n ) {
+					  (void)sockets[n]->send_async( message );
+					  reads.push_back( accepted[n].read_async( requests[n] ) );
+				  }
+				  for( std::size_t n = 0; n < socket_count; ++n ) {
+					  daw::expecting( message_size, reads[n].get( ) );
+					  (void)accepted[n].write_async( requests[n] );
+					  reads[n] = sockets[n]->receive_async( replies[n] );
+				  }
+				  for( auto &rd : reads ) {
+					  daw::expecting( message_size, rd.get( ) );
+				  }
+			  }
+		  } );
+		server.close( );
+		for( auto &s : sockets ) {
+			s->close_async( ).get( );
+		}
+		for( auto &client : accepted ) {
+			client.close_async( ).get( );
+		}
+	}
+} // namespace
+
+int main( ) {
+	echo_load( false );
+	echo_load( true );
+}
@@ -0,0 +1,77 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "test_echo_server.h"
+
+#include "daw/networking/network_socket.h"
+
+#include <daw/daw_benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	using namespace daw::networking;
+
+	constexpr std::size_t socket_count = 64;
+	constexpr std::size_t rounds = 100;
+	constexpr std::size_t message_size = 64;
+
+	/***
+	 * Loopback echo load on a pool of worker_count workers.  Every socket sends
+	 * and reads back rounds messages
+	 */
+	void echo_load( std::uint16_t port, std::size_t worker_count ) {
+		auto pool = daw::work_stealing_pool( worker_count, true );
+		auto sockets = std::vector<std::unique_ptr<pool_network_socket>>( );
+		auto connects = std::vector<daw::async_result<void>>( );
+		for( std::size_t n = 0; n < socket_count; ++n ) {
+			sockets.push_back( std::make_unique<pool_network_socket>(
+			  address_family::IPv4, socket_types::Stream, pool ) );
+			connects.push_back( sockets.back( )->connect_async( "127.0.0.1", port ) );
+		}
+		for( auto &c : connects ) {
+			c.get( );
+		}
+		auto const message = std::string( message_size, 'x' );
+		auto replies = std::vector<std::string>(
+		  socket_count, std::string( message_size, '\0' ) );
+
+		auto const title = "echo " + std::to_string( worker_count ) + " worker(s)";
+		daw::bench_n_test_mbs<3>(
+		  title, socket_count * rounds * message_size * 2, [&]( ) {
+			  for( std::size_t r = 0; r < rounds; ++r ) {
+				  auto reads = std::vector<daw::async_result<std::size_t>>( );
+				  reads.reserve( socket_count );
+				  for( std::size_t n = 0; n < socket_count; ++n ) {
+					  (void)sockets[n]->send_async( message );
+					  reads.push_back( sockets[n]->receive_async( replies[n] ) );
+				  }
+				  for( auto &rd : reads ) {
+					  daw::expecting( message_size, rd.get( ) );
+				  }
+			  }
+		  } );
+		for( auto &s : sockets ) {
+			s->close_async( ).get( );
+		}
+	}
+} // namespace
+
+int main( ) {
+	auto server = test::echo_server( );
+	auto const max_workers =
+	  std::max( std::thread::hardware_concurrency( ), 1U );
+	for( std::size_t workers = 1; workers < max_workers; workers *= 2 ) {
+		echo_load( server.port( ), workers );
+	}
+	echo_load( server.port( ), max_workers );
+}
@@ -0,0 +1,670 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "test_echo_server.h"
+
+#include "daw/networking/network_socket.h"
+#include "daw/networking/tcp_server.h"
+#include "daw/networking/udp_socket.h"
+
+#include <daw/daw_benchmark.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+	using namespace daw::networking;
+
+	/***
+	 * Many sockets sharing a small reactor group or pool, all echoing at once
+	 */
+	template<typename ExecPolicy, typename Reactors>
+	void echo_many( std::uint16_t port, Reactors &reactors ) {
+		using socket_t = basic_network_socket<ExecPolicy>;
+		constexpr std::size_t socket_count = 256;
+		auto sockets = std::vector<std::unique_ptr<socket_t>>( );
+		auto connects = std::vector<daw::async_result<void>>( );
+		for( std::size_t n = 0; n < socket_count; ++n ) {
+			sockets.push_back( std::make_unique<socket_t>(
+			  address_family::IPv4, socket_types::Stream, reactors.next( ) ) );
+			connects.push_back( sockets.back( )->connect_async( "127.0.0.1", port ) );
+		}
+		for( auto &c : connects ) {
+			c.get( );
+		}
+
+		auto messages = std::vector<std::string>( );
+		auto replies = std::vector<std::string>( );
+		auto reads = std::vector<daw::async_result<std::size_t>>( );
+		for( std::size_t n = 0; n < socket_count; ++n ) {
+			messages.push_back( "message #" + std::to_string( n ) );
+			replies.emplace_back( messages.back( ).size( ), '\0' );
+		}
+		for( std::size_t n = 0; n < socket_count; ++n ) {
+			(void)sockets[n]->send_async( messages[n] );
+			reads.push_back( sockets[n]->receive_async( replies[n] ) );
+		}
+		for( std::size_t n = 0; n < socket_count; ++n ) {
+			daw::expecting( messages[n].size( ), reads[n].get( ) );
+			daw::expecting( messages[n], replies[n] );
+		}
+		for( auto &s : sockets ) {
+			s->close_async( ).get( );
+		}
+	}
+
+	/***
+	 * connect, send and receive chained with then, nothing blocks until the
+	 * final get
+	 */
+	template<typename ExecPolicy>
+	void pipeline( std::uint16_t port ) {
+		auto sock = basic_network_socket<ExecPolicy>( address_family::IPv4,
+		                                              socket_types::Stream );
+		auto const message = std::string( "pipelined" );
+		auto reply = std::string( message.size( ), '\0' );
+		auto received = sock.connect_async( "127.0.0.1", port )
+		                  .then( [&] { return sock.send_async( message ); } )
+		                  .then( [&] { return sock.receive_async( reply ); } );
+		daw::expecting( message.size( ), received.get( ) );
+		daw::expecting( message, reply );
+		sock.close_async( ).get( );
+	}
+
+	/***
+	 * A gather send big enough to be written in pieces, echoed back into
+	 * buffers split at different offsets
+	 */
+	template<typename ExecPolicy>
+	void scatter_gather( std::uint16_t port ) {
+		auto sock = basic_network_socket<ExecPolicy>( address_family::IPv4,
+		                                              socket_types::Stream );
+		sock.connect_async( "127.0.0.1", port ).get( );
+		auto const head = std::string( "head:" );
+		auto body = std::string( 192 * 1024, '\0' );
+		for( std::size_t n = 0; n < body.size( ); ++n ) {
+			body[n] = static_cast<char>( 'a' + n % 26 );
+		}
+		auto const tail = std::string( ":tail" );
+		auto const out = std::vector<daw::span<char const>>{
+		  { head.data( ), head.size( ) },
+		  { },
+		  { body.data( ), body.size( ) },
+		  { tail.data( ), tail.size( ) } };
+
+		auto const total = head.size( ) + body.size( ) + tail.size( );
+		auto reply = std::string( total, '\0' );
+		auto const split = total / 3;
+		auto const in = std::vector<daw::span<char>>{
+		  { reply.data( ), 7 },
+		  { reply.data( ) + 7, split - 7 },
+		  { reply.data( ) + split, total - split } };
+
+		auto sent = sock.send_async( out );
+		auto received = sock.receive_async( in );
+		sent.get( );
+		daw::expecting( total, received.get( ) );
+		daw::expecting( head + body + tail, reply );
+		sock.close_async( ).get( );
+	}
+
+	/***
+	 * A zerocopy send, completing once the kernel released the buffer, then a
+	 * file sent with sendfile from a non zero offset.  The timeout puts the
+	 * operations' requests under a deadline, except the zerocopy reap
+	 */
+	template<typename ExecPolicy>
+	void zerocopy_and_sendfile( std::uint16_t port ) {
+		auto sock = basic_network_socket<ExecPolicy>( address_family::IPv4,
+		                                              socket_types::Stream );
+		sock.set_timeout( std::chrono::seconds( 10 ) );
+		sock.connect_async( "127.0.0.1", port ).get( );
+		auto message = std::string( 64 * 1024, '\0' );
+		for( std::size_t n = 0; n < message.size( ); ++n ) {
+			message[n] = static_cast<char>( 'A' + n % 26 );
+		}
+		auto reply = std::string( message.size( ), '\0' );
+		auto sent = sock.send_zerocopy_async( message );
+		auto received = sock.receive_async( reply );
+		sent.get( );
+		daw::expecting( message.size( ), received.get( ) );
+		daw::expecting( message, reply );
+
+		std::FILE *file = std::tmpfile( );
+		daw::expecting( file != nullptr );
+		auto const contents = std::string( "skipped|" ) + message;
+		std::fwrite( contents.data( ), 1, contents.size( ), file );
+		std::fflush( file );
+		auto const offset = static_cast<::off_t>( contents.find( '|' ) + 1 );
+		std::fill( reply.begin( ), reply.end( ), '\0' );
+		// Asking for more than the file has completes with what it has
+		auto file_sent = sock.send_file_async( ::fileno( file ), offset,
+		                                       message.size( ) + 100 );
+		received = sock.receive_async( reply );
+		daw::expecting( message.size( ), file_sent.get( ) );
+		daw::expecting( message.size( ), received.get( ) );
+		daw::expecting( message, reply );
+		std::fclose( file );
+		sock.close_async( ).get( );
+	}
+
+	/***
+	 * Zerocopy sends on a socket that was closed and connected again.  The new
+	 * fd needs SO_ZEROCOPY of its own and the kernel numbers its sends from 0
+	 */
+	template<typename ExecPolicy>
+	void zerocopy_after_reconnect( std::uint16_t port ) {
+		auto sock = basic_network_socket<ExecPolicy>( address_family::IPv4,
+		                                              socket_types::Stream );
+		auto const message = std::string( 16 * 1024, 'z' );
+		auto reply = std::string( message.size( ), '\0' );
+		for( int n = 0; n < 2; ++n ) {
+			sock.connect_async( "127.0.0.1", port ).get( );
+			auto sent = sock.send_zerocopy_async( message );
+			auto received = sock.receive_async( reply );
+			sent.get( );
+			daw::expecting( message.size( ), received.get( ) );
+			daw::expecting( message, reply );
+			sock.close_async( ).get( );
+		}
+	}
+
+	/***
+	 * Connections spread over a sharded server, each answered through the
+	 * client the server handed out.  With steer each connection runs on the
+	 * reactor pinned to the cpu its packets arrive on
+	 */
+	template<typename ExecPolicy, typename Reactors>
+	void sharded_server( Reactors &reactors, bool steer = false ) {
+		using server_t = basic_tcp_server<ExecPolicy, Reactors>;
+		constexpr std::size_t connection_count = 64;
+		auto accepted_mutex = std::mutex( );
+		auto accepted = std::vector<typename server_t::client_type>( );
+		auto server = server_t( reactors );
+		server.set_incoming_cpu_steering( steer );
+		server.listen( "127.0.0.1", 0, [&]( typename server_t::client_type client ) {
+			auto const lck = std::unique_lock( accepted_mutex );
+			accepted.push_back( std::move( client ) );
+		} );
+
+		auto sockets = std::vector<std::unique_ptr<basic_network_socket<ExecPolicy>>>( );
+		for( std::size_t n = 0; n < connection_count; ++n ) {
+			sockets.push_back( std::make_unique<basic_network_socket<ExecPolicy>>(
+			  address_family::IPv4, socket_types::Stream, reactors.next( ) ) );
+			sockets.back( )->connect_async( "127.0.0.1", server.port( ) ).get( );
+		}
+		auto const accepted_count = [&] {
+			auto const lck = std::unique_lock( accepted_mutex );
+			return accepted.size( );
+		};
+		while( accepted_count( ) < connection_count ) {
+			std::this_thread::yield( );
+		}
+		server.close( );
+
+		auto const message = std::string( "from the server" );
+		for( auto &client : accepted ) {
+			(void)client.write_async( message );
+		}
+		for( auto &sock : sockets ) {
+			auto reply = std::string( message.size( ), '\0' );
+			daw::expecting( message.size( ), sock->receive_async( reply ).get( ) );
+			daw::expecting( message, reply );
+			sock->close_async( ).get( );
+		}
+		for( auto &client : accepted ) {
+			client.close_async( ).get( );
+		}
+	}
+
+	/***
+	 * A batch of datagrams sent with one sendmmsg and read back with one
+	 * recvmmsg, then a single datagram each way
+	 */
+	template<typename ExecPolicy>
+	void udp_batches( ) {
+		auto receiver = basic_udp_socket<ExecPolicy>( );
+		receiver.bind( "127.0.0.1", 0 );
+		auto const to =
+		  socket_address::from_numeric( "127.0.0.1", receiver.local_port( ) );
+		auto sender = basic_udp_socket<ExecPolicy>( );
+
+		constexpr std::size_t count = 8;
+		auto payloads = std::vector<std::string>( );
+		auto outgoing = std::vector<outgoing_datagram>( );
+		for( std::size_t n = 0; n < count; ++n ) {
+			payloads.push_back( "datagram #" + std::to_string( n ) );
+		}
+		for( auto const &p : payloads ) {
+			outgoing.push_back(
+			  outgoing_datagram{ daw::span<char const>( p.data( ), p.size( ) ), to } );
+		}
+		daw::expecting( count, sender.send_batch_async( outgoing ).get( ) );
+
+		auto storage = std::vector<std::string>( count * 2, std::string( 32, '\0' ) );
+		auto incoming = std::vector<datagram>( storage.size( ) );
+		for( std::size_t n = 0; n < storage.size( ); ++n ) {
+			incoming[n].buffer = daw::span<char>( storage[n].data( ), storage[n].size( ) );
+		}
+		// Loopback delivers during the send so every datagram is waiting
+		daw::expecting( count, receiver.receive_batch_async( incoming ).get( ) );
+		for( std::size_t n = 0; n < count; ++n ) {
+			daw::expecting( payloads[n],
+			                std::string( incoming[n].buffer.data( ), incoming[n].size ) );
+			daw::expecting( not incoming[n].truncated );
+			daw::expecting( incoming[n].peer.port( ) != 0 );
+		}
+
+		auto const single = std::string( "single" );
+		sender.send_to_async( single, to ).get( );
+		auto from = socket_address( );
+		auto buffer = std::string( 64, '\0' );
+		daw::expecting( single.size( ),
+		                receiver.receive_from_async( buffer, from ).get( ) );
+		daw::expecting( single, buffer.substr( 0, single.size( ) ) );
+		daw::expecting( incoming[0].peer.port( ), from.port( ) );
+		sender.close( );
+		receiver.close( );
+	}
+
+	/***
+	 * One buffer goes out as equal sized datagrams plus a short last one and
+	 * comes back as segment views, coalesced or not depending on the kernel
+	 */
+	template<typename ExecPolicy>
+	void udp_segments( ) {
+		auto receiver = basic_udp_socket<ExecPolicy>( );
+		receiver.bind( "127.0.0.1", 0 );
+		auto const to =
+		  socket_address::from_numeric( "127.0.0.1", receiver.local_port( ) );
+		auto sender = basic_udp_socket<ExecPolicy>( );
+
+		constexpr std::uint16_t segment_size = 1000;
+		auto payload = std::string( segment_size * 10 + 123, '\0' );
+		for( std::size_t n = 0; n < payload.size( ); ++n ) {
+			payload[n] = static_cast<char>( 'a' + n % 26 );
+		}
+		sender.send_segments_async( payload, segment_size, to ).get( );
+
+		auto buffer = std::string( 65536, '\0' );
+		auto received = std::string( );
+		while( received.size( ) < payload.size( ) ) {
+			auto segments = receiver.receive_segments_async( buffer ).get( );
+			daw::expecting( segments.size( ) > 0 );
+			daw::expecting( segments.peer.port( ) != 0 );
+			for( std::size_t n = 0; n < segments.size( ); ++n ) {
+				auto const seg = segments[n];
+				daw::expecting( seg.size( ) <= segment_size );
+				received.append( seg.data( ), seg.size( ) );
+			}
+		}
+		daw::expecting( payload, received );
+		sender.close( );
+		receiver.close( );
+	}
+
+	/***
+	 * Unix domain listeners on an abstract and a filesystem path, and passing
+	 * a pipe over a socket pair
+	 */
+	template<typename ExecPolicy>
+	void unix_sockets( ) {
+		using socket_t = basic_network_socket<ExecPolicy>;
+		auto const suffix = std::to_string( ::getpid( ) );
+		auto const fs_path = "/tmp/daw_networking_test_" + suffix;
+		auto const paths = std::vector<std::string>{
+		  std::string( 1, '\0' ) + "daw_networking_test_" + suffix, fs_path };
+		for( auto const &path : paths ) {
+			(void)::unlink( fs_path.c_str( ) );
+			auto listener = socket_t( address_family::Unix, socket_types::Stream );
+			listener.bind( path, 0 );
+			listener.listen( );
+			auto client = socket_t( address_family::Unix, socket_types::Stream );
+			client.connect_async( path, 0 ).get( );
+
+			auto fds = std::vector<int>( 4, -1 );
+			int accepted = -1;
+			listener
+			  .accept_async( fds,
+			                 [&]( daw::span<int const> batch ) {
+				                 accepted = batch[0];
+				                 return false;
+			                 } )
+			  .get( );
+			auto server = socket_t( adopt_socket{ accepted }, address_family::Unix,
+			                        socket_types::Stream );
+			auto const msg = std::string( "over unix" );
+			client.send_async( msg ).get( );
+			auto buffer = std::string( msg.size( ), '\0' );
+			daw::expecting( msg.size( ), server.receive_async( buffer ).get( ) );
+			daw::expecting( msg, buffer );
+		}
+		(void)::unlink( fs_path.c_str( ) );
+
+		auto pair = make_socket_pair<ExecPolicy>( socket_types::SeqPacket );
+		int pipe_fds[2];
+		daw::expecting( ::pipe( pipe_fds ) == 0 );
+		auto const tag = std::string( "fd" );
+		auto const to_pass = std::vector<int>{ pipe_fds[0] };
+		daw::expecting( tag.size( ),
+		                pair.first->send_fds_async( tag, to_pass ).get( ) );
+		::close( pipe_fds[0] );
+
+		auto buffer = std::string( 16, '\0' );
+		auto received = std::vector<int>( 4, -1 );
+		auto const result = pair.second->receive_fds_async( buffer, received ).get( );
+		daw::expecting( tag.size( ), result.size );
+		daw::expecting( std::size_t{ 1 }, result.fds.size( ) );
+		daw::expecting( not result.truncated );
+		daw::expecting( ::write( pipe_fds[1], "x", 1 ) == 1 );
+		char c = 0;
+		daw::expecting( ::read( result.fds[0], &c, 1 ) == 1 );
+		daw::expecting( 'x', c );
+		::close( result.fds[0] );
+		::close( pipe_fds[1] );
+	}
+
+	static_assert( is_socket_option_v<socket_options::tcp_nodelay> );
+	static_assert( not is_socket_option_v<int> );
+
+	/***
+	 * Options set before connecting reach the fd the connect opens, and ones
+	 * set after apply right away
+	 */
+	template<typename ExecPolicy>
+	void tuned_sockets( std::uint16_t port ) {
+		auto client = basic_network_socket<ExecPolicy>( address_family::IPv4,
+		                                                 socket_types::Stream );
+		client.set_options( socket_profiles::low_latency( ) );
+		client.set_option( socket_options::keep_alive{ true } );
+		client.connect_async( "127.0.0.1", port ).get( );
+		daw::expecting( client.template get_option<socket_options::tcp_nodelay>( ) );
+		daw::expecting( client.template get_option<socket_options::keep_alive>( ) );
+		daw::expecting(
+		  16U * 1024U,
+		  client.template get_option<socket_options::tcp_notsent_lowat>( ) );
+		client.set_option( socket_options::tcp_nodelay{ false } );
+		daw::expecting(
+		  not client.template get_option<socket_options::tcp_nodelay>( ) );
+		client.set_options( socket_profiles::bulk_throughput( 1024 * 1024 ) );
+		daw::expecting(
+		  client.template get_option<socket_options::receive_buffer_size>( ) >=
+		  1024 * 1024 );
+
+		auto const msg = std::string( "tuned" );
+		client.send_async( msg ).get( );
+		auto buffer = std::string( msg.size( ), '\0' );
+		daw::expecting( msg.size( ), client.receive_async( buffer ).get( ) );
+		daw::expecting( msg, buffer );
+	}
+
+	/***
+	 * Writers on several threads coalescing into shared sendmsg calls, with a
+	 * gather send in between, arrive complete and in per thread order
+	 */
+	template<typename ExecPolicy>
+	void coalesced_writes( ) {
+		constexpr std::size_t thread_count = 4;
+		constexpr std::size_t per_thread = 500;
+		auto pair = make_socket_pair<ExecPolicy>( socket_types::Stream );
+		pair.first->set_write_coalescing( true );
+		auto messages = std::vector<std::vector<std::string>>( thread_count );
+		std::size_t total = 0;
+		for( std::size_t t = 0; t < thread_count; ++t ) {
+			for( std::size_t n = 0; n < per_thread; ++n ) {
+				messages[t].push_back( std::to_string( t ) + ':' +
+				                       std::to_string( n ) + '\n' );
+				total += messages[t].back( ).size( );
+			}
+		}
+		auto const marker = std::string( "-\n" );
+		total += marker.size( );
+
+		auto threads = std::vector<std::thread>( );
+		for( std::size_t t = 0; t < thread_count; ++t ) {
+			threads.emplace_back( [&, t] {
+				auto results = std::vector<daw::async_result<void>>( );
+				for( auto const &msg : messages[t] ) {
+					results.push_back( pair.first->send_async( msg ) );
+				}
+				for( auto &r : results ) {
+					r.get( );
+				}
+			} );
+		}
+		auto const gather = std::vector<daw::span<char const>>{
+		  daw::span<char const>( marker.data( ), marker.size( ) ) };
+		pair.first->send_async( gather ).get( );
+		for( auto &th : threads ) {
+			th.join( );
+		}
+
+		auto received = std::string( total, '\0' );
+		daw::expecting( total, pair.second->receive_async( received ).get( ) );
+		auto next = std::vector<std::size_t>( thread_count );
+		std::size_t pos = 0;
+		while( pos < received.size( ) ) {
+			auto const end = received.find( '\n', pos );
+			auto const line = received.substr( pos, end - pos );
+			pos = end + 1;
+			if( line == "-" ) {
+				continue;
+			}
+			auto const colon = line.find( ':' );
+			auto const t = std::stoul( line.substr( 0, colon ) );
+			daw::expecting( next[t]++, std::stoul( line.substr( colon + 1 ) ) );
+		}
+		for( auto n : next ) {
+			daw::expecting( per_thread, n );
+		}
+	}
+
+	long long error_of( daw::async_result<std::size_t> result ) {
+		try {
+			(void)result.get( );
+		} catch( network_exception const &ex ) { return ex.error_code( ); }
+		return 0;
+	}
+
+	/***
+	 * A receive with no data times out and fails, and the operations queued
+	 * behind it still run
+	 */
+	template<typename ExecPolicy>
+	void timeouts( ) {
+		auto pair = make_socket_pair<ExecPolicy>( socket_types::Stream );
+		pair.first->set_timeout( std::chrono::milliseconds( 50 ) );
+		auto buffer = std::string( 1, '\0' );
+		auto stalled = pair.first->receive_async( buffer );
+		auto queued = pair.first->receive_async( buffer );
+		daw::expecting( ETIMEDOUT, error_of( std::move( stalled ) ) );
+		daw::expecting( ETIMEDOUT, error_of( std::move( queued ) ) );
+		bool threw = false;
+		try {
+			(void)pair.first->receive( buffer );
+		} catch( network_exception const &ex ) {
+			threw = ex.error_code( ) == ETIMEDOUT;
+		}
+		daw::expecting( threw );
+
+		pair.first->set_timeout( std::chrono::seconds( 10 ) );
+		auto received = pair.first->receive_async( buffer );
+		auto const msg = std::string( "x" );
+		pair.second->send_async( msg ).get( );
+		daw::expecting( 1U, received.get( ) );
+		daw::expecting( "x", buffer );
+	}
+
+	/***
+	 * Stopping a parked receive and a queued one fails just those two, the
+	 * receive queued after them still gets the data
+	 */
+	template<typename ExecPolicy>
+	void cancellation( ) {
+		auto pair = make_socket_pair<ExecPolicy>( socket_types::Stream );
+		auto buffer = std::string( 1, '\0' );
+		auto parked_stop = std::stop_source( );
+		auto queued_stop = std::stop_source( );
+		auto parked = pair.first->receive_async( buffer, 0, parked_stop.get_token( ) );
+		auto queued = pair.first->receive_async( buffer, 0, queued_stop.get_token( ) );
+		auto after = pair.first->receive_async( buffer );
+		queued_stop.request_stop( );
+		parked_stop.request_stop( );
+		daw::expecting( ECANCELED, error_of( std::move( parked ) ) );
+		daw::expecting( ECANCELED, error_of( std::move( queued ) ) );
+
+		auto const msg = std::string( "y" );
+		pair.second->send_async( msg ).get( );
+		daw::expecting( 1U, after.get( ) );
+		daw::expecting( "y", buffer );
+	}
+
+	/// A receive waiting for data does not hold up sends on the same socket
+	template<typename ExecPolicy>
+	void full_duplex( ) {
+		auto pair = make_socket_pair<ExecPolicy>( socket_types::Stream );
+		auto reply = std::string( 1, '\0' );
+		auto pending = pair.first->receive_async( reply );
+		auto const ping = std::string( "ping" );
+		pair.first->send_async( ping ).get( );
+		daw::expecting( ping.size( ),
+		                pair.first->send( { ping.data( ), ping.size( ) } ) );
+		auto received = std::string( 2 * ping.size( ), '\0' );
+		daw::expecting( received.size( ),
+		                pair.second->receive_async( received ).get( ) );
+		daw::expecting( "pingping", received );
+
+		auto const msg = std::string( "z" );
+		pair.second->send_async( msg ).get( );
+		daw::expecting( 1U, pending.get( ) );
+		daw::expecting( "z", reply );
+		pair.first->close_async( ).get( );
+		daw::expecting( false, pair.first->is_open( ) );
+	}
+
+	/***
+	 * Destroying a socket fails the operations still waiting on it rather than
+	 * leaving their results unset
+	 */
+	template<typename ExecPolicy>
+	void dropped_operations( ) {
+		auto pair = make_socket_pair<ExecPolicy>( socket_types::Stream );
+		auto buffer = std::string( 1, '\0' );
+		auto parked = pair.first->receive_async( buffer );
+		auto queued = pair.first->receive_async( buffer );
+		pair.first.reset( );
+		daw::expecting( ECANCELED, error_of( std::move( parked ) ) );
+		daw::expecting( ECANCELED, error_of( std::move( queued ) ) );
+	}
+
+	/***
+	 * A task on the thread policy's worker can queue more tasks than the
+	 * worker's queue holds without waiting on itself
+	 */
+	void worker_queues_to_itself( ) {
+		auto worker = daw::async_exec_policy_thread( );
+		std::size_t count = 0;
+		worker.add_task( [&] {
+			for( std::size_t n = 0; n < 1000; ++n ) {
+				worker.add_task( [&count, n] { daw::expecting( count++, n ); } );
+			}
+		} );
+		worker.wait( );
+		daw::expecting( 1000U, count );
+	}
+} // namespace
+
+int main( ) {
+	auto server = test::echo_server( );
+	{
+		auto reactors = daw::epoll_reactor_group( 2 );
+		echo_many<daw::async_exec_policy_epoll>( server.port( ), reactors );
+	}
+	{
+		auto busy_reactors =
+		  daw::epoll_reactor_group( 2, std::chrono::microseconds( 200 ) );
+		echo_many<daw::async_exec_policy_epoll>( server.port( ), busy_reactors );
+	}
+	pipeline<daw::async_exec_policy_epoll>( server.port( ) );
+	scatter_gather<daw::async_exec_policy_epoll>( server.port( ) );
+	scatter_gather<daw::async_exec_policy_pool>( server.port( ) );
+	zerocopy_and_sendfile<daw::async_exec_policy_epoll>( server.port( ) );
+	zerocopy_and_sendfile<daw::async_exec_policy_pool>( server.port( ) );
+	zerocopy_and_sendfile<daw::async_exec_policy_thread>( server.port( ) );
+	zerocopy_after_reconnect<daw::async_exec_policy_epoll>( server.port( ) );
+	zerocopy_after_reconnect<daw::async_exec_policy_pool>( server.port( ) );
+	zerocopy_after_reconnect<daw::async_exec_policy_thread>( server.port( ) );
+	udp_batches<daw::async_exec_policy_epoll>( );
+	udp_batches<daw::async_exec_policy_pool>( );
+	udp_batches<daw::async_exec_policy_thread>( );
+	udp_segments<daw::async_exec_policy_epoll>( );
+	udp_segments<daw::async_exec_policy_pool>( );
+	udp_segments<daw::async_exec_policy_thread>( );
+	unix_sockets<daw::async_exec_policy_epoll>( );
+	unix_sockets<daw::async_exec_policy_pool>( );
+	unix_sockets<daw::async_exec_policy_thread>( );
+	coalesced_writes<daw::async_exec_policy_epoll>( );
+	coalesced_writes<daw::async_exec_policy_pool>( );
+	coalesced_writes<daw::async_exec_policy_thread>( );
+	tuned_sockets<daw::async_exec_policy_epoll>( server.port( ) );
+	tuned_sockets<daw::async_exec_policy_thread>( server.port( ) );
+	timeouts<daw::async_exec_policy_epoll>( );
+	timeouts<daw::async_exec_policy_pool>( );
+	timeouts<daw::async_exec_policy_thread>( );
+	cancellation<daw::async_exec_policy_epoll>( );
+	cancellation<daw::async_exec_policy_pool>( );
+	cancellation<daw::async_exec_policy_thread>( );
+	full_duplex<daw::async_exec_policy_epoll>( );
+	full_duplex<daw::async_exec_policy_pool>( );
+	full_duplex<daw::async_exec_policy_thread>( );
+	dropped_operations<daw::async_exec_policy_epoll>( );
+	dropped_operations<daw::async_exec_policy_pool>( );
+	dropped_operations<daw::async_exec_policy_thread>( );
+	worker_queues_to_itself( );
+	{
+		auto reactors = daw::epoll_reactor_group( 2 );
+		sharded_server<daw::async_exec_policy_epoll>( reactors );
+	}
+	{
+		auto pool = daw::work_stealing_pool( 4 );
+		sharded_server<daw::async_exec_policy_pool>( pool );
+	}
+	{
+		auto pinned_pool = daw::work_stealing_pool( 4, true );
+		sharded_server<daw::async_exec_policy_pool>( pinned_pool, true );
+	}
+	{
+		auto pool = daw::work_stealing_pool( 4 );
+		echo_many<daw::async_exec_policy_pool>( server.port( ), pool );
+	}
+	try {
+		auto reactors = daw::uring_reactor_group( 2 );
+		echo_many<daw::async_exec_policy_uring>( server.port( ), reactors );
+		scatter_gather<daw::async_exec_policy_uring>( server.port( ) );
+		zerocopy_and_sendfile<daw::async_exec_policy_uring>( server.port( ) );
+		zerocopy_after_reconnect<daw::async_exec_policy_uring>( server.port( ) );
+		udp_batches<daw::async_exec_policy_uring>( );
+		udp_segments<daw::async_exec_policy_uring>( );
+		unix_sockets<daw::async_exec_policy_uring>( );
+		timeouts<daw::async_exec_policy_uring>( );
+		cancellation<daw::async_exec_policy_uring>( );
+		full_duplex<daw::async_exec_policy_uring>( );
+		dropped_operations<daw::async_exec_policy_uring>( );
+	} catch( network_exception const &ex ) {
+		std::cout << "io_uring unavailable(" << ex.error_code( )
+		          << "), skipping\n";
+	}
+}
@@ -0,0 +1,102 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "test_echo_server.h"
+
+#include "daw/networking/tcp_connection_pool.h"
+
+#include <daw/daw_benchmark.h>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdint>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+	using namespace daw::networking;
+	using namespace std::chrono_literals;
+
+	void echo( tcp_connection_pool::lease &conn, std::string const &msg ) {
+		conn->write( msg );
+		auto buffer = std::string( msg.size( ), '\0' );
+		daw::expecting( msg.size( ), conn->read_async( buffer ).get( ) );
+		daw::expecting( msg, buffer );
+	}
+
+	void reuses_connections( std::uint16_t port ) {
+		auto options = tcp_connection_pool_options( );
+		options.max_idle = 2;
+		auto pool = tcp_connection_pool( options );
+		{
+			auto conn = pool.acquire( "127.0.0.1", port );
+			echo( conn, "first" );
+		}
+		daw::expecting( std::size_t{ 1 }, pool.idle_count( "127.0.0.1", port ) );
+		{
+			auto a = pool.acquire( "127.0.0.1", port );
+			daw::expecting( std::size_t{ 0 }, pool.idle_count( "127.0.0.1", port ) );
+			auto b = pool.acquire( "127.0.0.1", port );
+			auto c = pool.acquire( "127.0.0.1", port );
+			echo( a, "a" );
+			echo( b, "b" );
+			echo( c, "c" );
+			c.discard( );
+		}
+		daw::expecting( std::size_t{ 2 }, pool.idle_count( "127.0.0.1", port ) );
+	}
+
+	void evicts_idle( std::uint16_t port ) {
+		auto options = tcp_connection_pool_options( );
+		options.min_idle = 1;
+		options.idle_timeout = 10ms;
+		auto pool = tcp_connection_pool( options );
+		pool.prewarm( "127.0.0.1", port, 3 );
+		daw::expecting( std::size_t{ 3 }, pool.idle_count( "127.0.0.1", port ) );
+		std::this_thread::sleep_for( 30ms );
+		pool.evict_idle( );
+		daw::expecting( std::size_t{ 1 }, pool.idle_count( "127.0.0.1", port ) );
+	}
+
+	/***
+	 * A server that closes what it accepts, so the pooled connections die
+	 * while idle and a checkout must replace them
+	 */
+	void skips_dead_connections( ) {
+		int const listener = ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+		auto addr = ::sockaddr_in( );
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+		auto len = static_cast<::socklen_t>( sizeof( addr ) );
+		daw::expecting(
+		  ::bind( listener, reinterpret_cast<::sockaddr *>( &addr ), len ) == 0 and
+		  ::listen( listener, 16 ) == 0 and
+		  ::getsockname( listener, reinterpret_cast<::sockaddr *>( &addr ),
+		                 &len ) == 0 );
+		auto const port = ntohs( addr.sin_port );
+
+		auto pool = tcp_connection_pool( );
+		pool.prewarm( "127.0.0.1", port, 2 );
+		for( int n = 0; n < 2; ++n ) {
+			::close( ::accept( listener, nullptr, nullptr ) );
+		}
+		std::this_thread::sleep_for( 10ms );
+		auto conn = pool.acquire( "127.0.0.1", port );
+		daw::expecting( conn->is_alive( ) );
+		daw::expecting( std::size_t{ 0 }, pool.idle_count( "127.0.0.1", port ) );
+		::close( listener );
+	}
+} // namespace
+
+int main( ) {
+	auto server = test::echo_server( );
+	reuses_connections( server.port( ) );
+	evicts_idle( server.port( ) );
+	skips_dead_connections( );
+}
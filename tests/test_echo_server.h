@@ -0,0 +1,95 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#pragma once
+
+#include "third_party/jthread.hpp"
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace daw::networking::test {
+	/***
+	 * Blocking loopback echo server used by the tests.  Every accepted
+	 * connection gets its own thread that echoes until the peer closes
+	 */
+	class echo_server {
+		int m_listener = -1;
+		std::uint16_t m_port = 0;
+		std::jthread m_thread;
+
+	public:
+		echo_server( )
+		  : m_listener( ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 ) ) {
+			if( m_listener < 0 ) {
+				throw std::runtime_error( "Could not create listener" );
+			}
+			int const one = 1;
+			(void)::setsockopt( m_listener, SOL_SOCKET, SO_REUSEADDR, &one,
+			                    sizeof( one ) );
+			auto addr = ::sockaddr_in{ };
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+			addr.sin_port = 0;
+			auto len = static_cast<::socklen_t>( sizeof( addr ) );
+			if( ::bind( m_listener, reinterpret_cast<::sockaddr *>( &addr ),
+			            sizeof( addr ) ) < 0 or
+			    ::listen( m_listener, SOMAXCONN ) < 0 or
+			    ::getsockname( m_listener, reinterpret_cast<::sockaddr *>( &addr ),
+			                   &len ) < 0 ) {
+				(void)::close( m_listener );
+				throw std::runtime_error( "Could not start listener" );
+			}
+			m_port = ntohs( addr.sin_port );
+			m_thread = std::jthread( [listener = m_listener]( ) {
+				auto clients = std::vector<std::jthread>( );
+				while( true ) {
+					int const fd = ::accept( listener, nullptr, nullptr );
+					if( fd < 0 ) {
+						return;
+					}
+					clients.emplace_back( [fd]( ) {
+						char buff[4096];
+						::ssize_t r = 0;
+						while( ( r = ::recv( fd, buff, sizeof( buff ), 0 ) ) > 0 ) {
+							auto pos = ::ssize_t{ 0 };
+							while( pos < r ) {
+								auto const w = ::send( fd, buff + pos,
+								                       static_cast<std::size_t>( r - pos ),
+								                       MSG_NOSIGNAL );
+								if( w <= 0 ) {
+									break;
+								}
+								pos += w;
+							}
+						}
+						(void)::close( fd );
+					} );
+				}
+			} );
+		}
+
+		~echo_server( ) {
+			(void)::shutdown( m_listener, SHUT_RDWR );
+			if( m_thread.joinable( ) ) {
+				m_thread.join( );
+			}
+			(void)::close( m_listener );
+		}
+
+		echo_server( echo_server const & ) = delete;
+		echo_server &operator=( echo_server const & ) = delete;
+
+		std::uint16_t port( ) const {
+			return m_port;
+		}
+	};
+} // namespace daw::networking::test